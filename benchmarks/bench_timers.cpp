@@ -0,0 +1,112 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file bench_timers.cpp
+ * @brief Compares the heap and timing wheel timers engines.
+ * @details Each run arms `COUNT` timers with pseudo-random timeouts spread
+ * over `SPREAD`, then measures:
+ * - arm: adding every timer.
+ * - cancel: removing every timer again.
+ * - resolve: the first resolve after cancelling, which is where the heap
+ *   pays for its lazily discarded timers.
+ * - churn: `ROUNDS` rounds of arming and cancelling a timer per connection,
+ *   with a resolve after each round, which models per-connection timeouts.
+ */
+#include "net/timers/timers.hpp"
+#include "net/timers/timing_wheel.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+using namespace net::timers;
+using std::chrono::steady_clock;
+
+/** @brief An interrupt source that does nothing. */
+struct null_interrupt_source {
+  /** @brief Does nothing. */
+  auto interrupt() const noexcept -> void {}
+};
+
+constexpr std::size_t COUNT = 100'000;
+constexpr std::size_t ROUNDS = 100;
+constexpr auto SPREAD = std::chrono::seconds(60);
+
+/** @brief Returns the nanoseconds per operation since start. */
+auto per_op(steady_clock::time_point start, std::size_t ops) -> double
+{
+  auto elapsed = steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         static_cast<double>(ops);
+}
+
+/** @brief Runs the benchmark against one timers engine. */
+template <typename Timers> auto run(const char *name) -> void
+{
+  auto engine = Timers();
+  auto rng = std::mt19937_64(1); // NOLINT
+  auto spread = std::uniform_int_distribution<std::int64_t>(
+      1, std::chrono::milliseconds(SPREAD).count());
+  auto now = clock::now();
+
+  auto deadlines = std::vector<timestamp>(COUNT);
+  for (auto &when : deadlines)
+    when = now + std::chrono::milliseconds(spread(rng));
+
+  auto tids = std::vector<timer_id>(COUNT);
+  auto start = steady_clock::now();
+  for (std::size_t i = 0; i < COUNT; ++i)
+    tids[i] = engine.add(deadlines[i], [](timer_id) {});
+  auto arm = per_op(start, COUNT);
+
+  start = steady_clock::now();
+  for (auto tid : tids)
+    engine.remove(tid);
+  auto cancel = per_op(start, COUNT);
+
+  start = steady_clock::now();
+  engine.resolve();
+  auto resolve = per_op(start, 1);
+
+  start = steady_clock::now();
+  for (std::size_t round = 0; round < ROUNDS; ++round)
+  {
+    for (std::size_t i = 0; i < COUNT; ++i)
+      tids[i] = engine.add(deadlines[i], [](timer_id) {});
+    for (auto tid : tids)
+      engine.remove(tid);
+    engine.resolve();
+  }
+  auto churn = per_op(start, COUNT * ROUNDS);
+
+  std::printf("%-12s arm %8.1f ns  cancel %8.1f ns  resolve %10.0f ns  "
+              "churn %8.1f ns\n",
+              name, arm, cancel, resolve, churn);
+}
+} // namespace
+
+auto main() -> int
+{
+  std::printf("%zu timers spread over %llds\n", COUNT,
+              static_cast<long long>(SPREAD.count()));
+  run<timers<null_interrupt_source>>("heap");
+  run<timing_wheel<null_interrupt_source>>("timing_wheel");
+  return 0;
+}
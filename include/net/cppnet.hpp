@@ -23,9 +23,23 @@
 /** @brief This is the root namespace of cppnet. */
 namespace net {}                         // namespace net
 #include "service/async_context.hpp"     // IWYU pragma: export
+#include "service/async_tcp_client.hpp"  // IWYU pragma: export
 #include "service/async_tcp_service.hpp" // IWYU pragma: export
 #include "service/async_udp_service.hpp" // IWYU pragma: export
+#include "service/context_pool.hpp"      // IWYU pragma: export
 #include "service/context_thread.hpp"    // IWYU pragma: export
+#include "service/datagram_queue.hpp"    // IWYU pragma: export
+#include "service/flow_table.hpp"        // IWYU pragma: export
+#include "service/send_file.hpp"         // IWYU pragma: export
+#include "service/write_queue.hpp"       // IWYU pragma: export
+#include "service/zerocopy.hpp"          // IWYU pragma: export
 #include "timers/interrupt.hpp"          // IWYU pragma: export
 #include "timers/timers.hpp"             // IWYU pragma: export
-#endif                                   // CPPNET_HPP
+#include "timers/timing_wheel.hpp"       // IWYU pragma: export
+#if __has_include(<sys/epoll.h>)
+#include "execution/epoll_multiplexer.hpp" // IWYU pragma: export
+#endif
+#if __has_include(<linux/io_uring.h>)
+#include "execution/io_uring_multiplexer.hpp" // IWYU pragma: export
+#endif
+#endif // CPPNET_HPP
@@ -0,0 +1,152 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file buffer_pool.hpp
+ * @brief This file defines a pool of byte buffers in several size classes.
+ */
+#pragma once
+#ifndef CPPNET_BUFFER_POOL_HPP
+#define CPPNET_BUFFER_POOL_HPP
+#include "slab_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+/** @brief This namespace provides internal cppnet implementation details. */
+namespace net::detail {
+/**
+ * @brief A pool of byte buffers in power of two size classes.
+ * @details The smallest class is `min_size()` bytes and every following
+ * class doubles in size up to `max_size()`, which is always the largest
+ * class. Each class is backed by its own slab_pool, so buffers are
+ * recycled without touching the global allocator. Like slab_pool, a
+ * buffer_pool must only be used by one thread, but its counters can be
+ * read from any thread.
+ */
+class buffer_pool : immovable {
+public:
+  /** @brief The size type. */
+  using size_type = std::size_t;
+
+  /** @brief A snapshot of the pool occupancy counters. */
+  struct stats_type {
+    /** @brief The number of buffers that are in use. */
+    size_type in_use = 0;
+    /** @brief The total size of the buffers that are in use. */
+    size_type bytes_in_use = 0;
+    /** @brief The total size of the slabs that back every class. */
+    size_type bytes_reserved = 0;
+  };
+
+  /**
+   * @brief Constructor.
+   * @param min_size The size of the smallest class. It is raised to the
+   * alignment of `std::max_align_t` if it is smaller.
+   * @param max_size The size of the largest class. It is raised to
+   * `min_size` if it is smaller.
+   */
+  buffer_pool(size_type min_size, size_type max_size)
+      : min_size_{std::max(min_size, alignof(std::max_align_t))},
+        max_size_{std::max(max_size, min_size_)}
+  {
+    for (auto size = min_size_; size < max_size_; size *= 2)
+      classes_.push_back(std::make_unique<slab_pool>());
+    classes_.push_back(std::make_unique<slab_pool>());
+  }
+
+  /**
+   * @brief Acquires a buffer of at least `size` bytes.
+   * @param size The requested size. Requests larger than `max_size()` get
+   * a buffer of `max_size()` bytes.
+   * @returns The buffer, which may be larger than requested.
+   */
+  [[nodiscard]] auto acquire(size_type size) -> std::span<std::byte>
+  {
+    const auto index = class_of_(size);
+    const auto class_size = size_of_(index);
+    auto *data = classes_[index]->allocate(class_size,
+                                           alignof(std::max_align_t));
+    return {static_cast<std::byte *>(data), class_size};
+  }
+
+  /**
+   * @brief Returns a buffer to the pool.
+   * @param buffer A buffer returned by acquire().
+   */
+  auto release(std::span<std::byte> buffer) noexcept -> void
+  {
+    classes_[class_of_(buffer.size())]->deallocate(buffer.data());
+  }
+
+  /** @returns A snapshot of the occupancy counters. */
+  [[nodiscard]] auto stats() const noexcept -> stats_type
+  {
+    auto stats = stats_type{};
+    for (size_type i = 0; i < classes_.size(); ++i)
+    {
+      const auto size = size_of_(i);
+      const auto slabs = classes_[i]->stats();
+      stats.in_use += slabs.in_use;
+      stats.bytes_in_use += slabs.in_use * size;
+      stats.bytes_reserved += slabs.capacity * size;
+    }
+    return stats;
+  }
+
+  /** @returns The size of the smallest class. */
+  [[nodiscard]] auto min_size() const noexcept -> size_type
+  {
+    return min_size_;
+  }
+
+  /** @returns The size of the largest class. */
+  [[nodiscard]] auto max_size() const noexcept -> size_type
+  {
+    return max_size_;
+  }
+
+  /** @brief Default destructor. */
+  ~buffer_pool() = default;
+
+private:
+  /** @returns The index of the smallest class that holds `size` bytes. */
+  [[nodiscard]] auto class_of_(size_type size) const noexcept -> size_type
+  {
+    auto index = size_type{0};
+    while (index + 1 < classes_.size() && size_of_(index) < size)
+      ++index;
+
+    return index;
+  }
+
+  /** @returns The buffer size of a class. */
+  [[nodiscard]] auto size_of_(size_type index) const noexcept -> size_type
+  {
+    return std::min(min_size_ << index, max_size_);
+  }
+
+  /** @brief The size of the smallest class. */
+  size_type min_size_;
+  /** @brief The size of the largest class. */
+  size_type max_size_;
+  /** @brief The slab pool of each class. */
+  std::vector<std::unique_ptr<slab_pool>> classes_;
+};
+
+} // namespace net::detail
+#endif // CPPNET_BUFFER_POOL_HPP
@@ -21,9 +21,12 @@
 #ifndef CPPNET_CONCEPT_HPP
 #define CPPNET_CONCEPT_HPP
 #include <concepts>
+#include <cstddef>
+#include <memory>
+#include <span>
 // Forward declarations
 namespace net::service {
-struct async_context;
+template <typename Service> struct context_of;
 } // namespace net::service
 
 /**
@@ -41,10 +44,37 @@ concept BasicLockable = requires(Lock lock) {
 /** @brief ServiceLike describes types that behave like an application or
  * service. */
 template <typename S>
-concept ServiceLike = requires(S service, service::async_context &ctx) {
-  { service.signal_handler(1) } noexcept -> std::same_as<void>;
-  { service.start(ctx) } noexcept -> std::same_as<void>;
+concept ServiceLike =
+    requires(S service, typename service::context_of<S>::type &ctx) {
+      { service.signal_handler(1) } noexcept -> std::same_as<void>;
+      { service.start(ctx) } noexcept -> std::same_as<void>;
+    };
+
+/** @brief This namespace is for cppnet execution backends. */
+namespace execution {
+/**
+ * @brief A concept for multiplexers that can submit socket io to the kernel
+ * directly, instead of waiting for readiness and then calling the socket.
+ */
+template <typename Mux>
+concept CompletionMultiplexer =
+    requires(Mux &mux, std::shared_ptr<typename Mux::socket_handle> socket,
+             std::span<std::byte> buf) {
+      mux.recvmsg(socket, buf, 0);
+      mux.sendmsg(socket, std::span<const std::byte>(buf), 0);
+      mux.accept(socket);
+    };
+
+/**
+ * @brief A concept for multiplexers that can wait for a socket error
+ * alone, such as a notification on the socket error queue, without waking
+ * up for readable data.
+ */
+template <typename Mux>
+concept ErrorMultiplexer = requires {
+  { Mux::ERRORS } -> std::convertible_to<typename Mux::trigger>;
 };
+} // namespace execution
 
 /** @brief This namespace is for timers and interrupts. */
 namespace timers {
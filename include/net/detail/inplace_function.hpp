@@ -0,0 +1,177 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file inplace_function.hpp
+ * @brief This file defines a move-only callable with inline storage.
+ */
+#pragma once
+#ifndef CPPNET_INPLACE_FUNCTION_HPP
+#define CPPNET_INPLACE_FUNCTION_HPP
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+/** @brief This namespace provides internal cppnet implementation details. */
+namespace net::detail {
+/**
+ * @brief A move-only callable that stores its target inline.
+ * @tparam Signature The call signature.
+ * @tparam Capacity The size of the inline buffer in bytes.
+ */
+template <typename Signature, std::size_t Capacity> class inplace_function;
+
+/**
+ * @brief A move-only callable that stores its target inline.
+ * @details Unlike `std::function`, an inplace_function never allocates.
+ * Callables that don't fit in `Capacity` bytes, or that are over-aligned,
+ * are rejected at compile time.
+ * @tparam R The return type.
+ * @tparam Args The argument types.
+ * @tparam Capacity The size of the inline buffer in bytes.
+ */
+template <typename R, typename... Args, std::size_t Capacity>
+class inplace_function<R(Args...), Capacity> {
+public:
+  /** @brief The size of the inline buffer. */
+  static constexpr std::size_t capacity = Capacity;
+
+  /** @brief Constructs an empty inplace_function. */
+  inplace_function() noexcept = default;
+  /** @brief Constructs an empty inplace_function. */
+  inplace_function(std::nullptr_t /*unused*/) noexcept {}
+
+  /**
+   * @brief Constructs an inplace_function that stores `func` inline.
+   * @tparam Fn The callable type.
+   * @param func The callable to store.
+   */
+  template <typename Fn>
+    requires(!std::is_same_v<std::remove_cvref_t<Fn>, inplace_function> &&
+             std::is_invocable_r_v<R, std::decay_t<Fn> &, Args...>)
+  inplace_function(Fn &&func) // NOLINT(google-explicit-constructor)
+  {
+    using target = std::decay_t<Fn>;
+    static_assert(sizeof(target) <= Capacity,
+                  "The callable is too large for the inline buffer.");
+    static_assert(alignof(target) <= alignof(std::max_align_t),
+                  "The callable is over-aligned for the inline buffer.");
+    static_assert(std::is_nothrow_move_constructible_v<target>,
+                  "The callable must be nothrow move constructible.");
+
+    auto *ptr = static_cast<void *>(storage_.data());
+    ::new (ptr) target(std::forward<Fn>(func));
+    vtable_ = &vtable_for<target>;
+  }
+
+  /** @brief Deleted copy constructor. */
+  inplace_function(const inplace_function &) = delete;
+  /** @brief Move constructor. */
+  inplace_function(inplace_function &&other) noexcept
+      : vtable_{std::exchange(other.vtable_, nullptr)}
+  {
+    if (vtable_)
+      vtable_->relocate(storage_.data(), other.storage_.data());
+  }
+
+  /** @brief Deleted copy assignment. */
+  auto operator=(const inplace_function &) -> inplace_function & = delete;
+  /** @brief Move assignment. */
+  auto operator=(inplace_function &&other) noexcept -> inplace_function &
+  {
+    if (this != &other)
+    {
+      reset_();
+      vtable_ = std::exchange(other.vtable_, nullptr);
+      if (vtable_)
+        vtable_->relocate(storage_.data(), other.storage_.data());
+    }
+    return *this;
+  }
+  /** @brief Destroys the stored callable. */
+  auto operator=(std::nullptr_t /*unused*/) noexcept -> inplace_function &
+  {
+    reset_();
+    return *this;
+  }
+
+  /** @returns true if a callable is stored. */
+  explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+  /**
+   * @brief Invokes the stored callable.
+   * @param args The call arguments.
+   * @returns The result of the call.
+   * @throws std::bad_function_call if no callable is stored.
+   */
+  auto operator()(Args... args) -> R
+  {
+    if (!vtable_)
+      throw std::bad_function_call();
+
+    return vtable_->invoke(storage_.data(), std::forward<Args>(args)...);
+  }
+
+  /** @brief Destructor. */
+  ~inplace_function() { reset_(); }
+
+private:
+  /** @brief The type-erased operations on the stored callable. */
+  struct vtable {
+    /** @brief Invokes the callable. */
+    R (*invoke)(std::byte *, Args &&...);
+    /** @brief Move constructs the callable into dst and destroys src. */
+    void (*relocate)(std::byte *dst, std::byte *src) noexcept;
+    /** @brief Destroys the callable. */
+    void (*destroy)(std::byte *) noexcept;
+  };
+
+  /** @brief The vtable of a callable type. */
+  template <typename Fn>
+  static constexpr vtable vtable_for = {
+      .invoke = [](std::byte *self, Args &&...args) -> R {
+        return std::invoke(*std::launder(reinterpret_cast<Fn *>(self)),
+                           std::forward<Args>(args)...);
+      },
+      .relocate =
+          [](std::byte *dst, std::byte *src) noexcept {
+            auto *from = std::launder(reinterpret_cast<Fn *>(src));
+            ::new (static_cast<void *>(dst)) Fn(std::move(*from));
+            std::destroy_at(from);
+          },
+      .destroy =
+          [](std::byte *self) noexcept {
+            std::destroy_at(std::launder(reinterpret_cast<Fn *>(self)));
+          },
+  };
+
+  /** @brief Destroys the stored callable, if any. */
+  auto reset_() noexcept -> void
+  {
+    if (auto *table = std::exchange(vtable_, nullptr))
+      table->destroy(storage_.data());
+  }
+
+  /** @brief The inline buffer. */
+  alignas(std::max_align_t) std::array<std::byte, Capacity> storage_;
+  /** @brief The vtable of the stored callable. */
+  const vtable *vtable_ = nullptr;
+};
+
+} // namespace net::detail
+#endif // CPPNET_INPLACE_FUNCTION_HPP
@@ -0,0 +1,99 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file mpsc_queue.hpp
+ * @brief This file defines an intrusive lock-free MPSC queue.
+ */
+#pragma once
+#ifndef CPPNET_MPSC_QUEUE_HPP
+#define CPPNET_MPSC_QUEUE_HPP
+#include "immovable.hpp"
+
+#include <atomic>
+#include <concepts>
+#include <utility>
+/** @brief This namespace provides internal cppnet implementation details. */
+namespace net::detail {
+/** @brief The intrusive hook of an mpsc_queue element. */
+struct mpsc_node {
+  /** @brief The next node in the queue. */
+  mpsc_node *next = nullptr;
+};
+
+/**
+ * @brief An intrusive, lock-free, multi-producer single-consumer queue.
+ * @details Producers push nodes onto a lock-free stack with a single CAS.
+ * The consumer takes the whole stack with one atomic exchange and reverses
+ * it, so nodes are handed back in the order they were pushed. The queue
+ * never allocates, the nodes must outlive their time in the queue.
+ * @tparam Node The node type, which must derive from mpsc_node.
+ */
+template <typename Node>
+  requires std::derived_from<Node, mpsc_node>
+class mpsc_queue : immovable {
+public:
+  /** @brief Default constructor. */
+  mpsc_queue() = default;
+
+  /**
+   * @brief Pushes a node onto the queue. Safe to call from any thread.
+   * @param node The node to push.
+   * @returns true if the queue was empty, in which case the consumer may
+   * need to be woken up.
+   */
+  auto push(Node *node) noexcept -> bool
+  {
+    mpsc_node *head = head_.load(std::memory_order_relaxed);
+    do
+    {
+      node->next = head;
+    } while (!head_.compare_exchange_weak(head, node, std::memory_order_release,
+                                          std::memory_order_relaxed));
+    return head == nullptr;
+  }
+
+  /**
+   * @brief Takes every node in the queue. Must only be called by the
+   * consumer.
+   * @returns The first node that was pushed, linked through `next` to the
+   * rest in push order, or nullptr if the queue was empty.
+   */
+  auto take() noexcept -> Node *
+  {
+    mpsc_node *head = head_.exchange(nullptr, std::memory_order_acquire);
+    mpsc_node *reversed = nullptr;
+    while (head)
+      reversed = std::exchange(head, std::exchange(head->next, reversed));
+
+    return static_cast<Node *>(reversed);
+  }
+
+  /** @returns true if the queue is empty. */
+  [[nodiscard]] auto empty() const noexcept -> bool
+  {
+    return head_.load(std::memory_order_relaxed) == nullptr;
+  }
+
+  /** @brief Default destructor. */
+  ~mpsc_queue() = default;
+
+private:
+  /** @brief The most recently pushed node. */
+  std::atomic<mpsc_node *> head_{nullptr};
+};
+
+} // namespace net::detail
+#endif // CPPNET_MPSC_QUEUE_HPP
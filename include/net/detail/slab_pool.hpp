@@ -0,0 +1,262 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file slab_pool.hpp
+ * @brief This file defines a pool of fixed-size memory blocks.
+ */
+#pragma once
+#ifndef CPPNET_SLAB_POOL_HPP
+#define CPPNET_SLAB_POOL_HPP
+#include "immovable.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+/** @brief This namespace provides internal cppnet implementation details. */
+namespace net::detail {
+/**
+ * @brief A pool of fixed-size memory blocks.
+ * @details Blocks are carved out of slabs that each hold `slab_size()`
+ * blocks, and freed blocks are kept on an intrusive free list, so once the
+ * pool has grown to its working set, allocations never reach the global
+ * allocator. The block size is fixed by the first allocation. Slabs are
+ * only returned to the system when the pool is destroyed.
+ *
+ * A slab_pool isn't thread-safe, it must only be used by the thread that
+ * runs the context it belongs to. The occupancy counters can be read from
+ * any thread.
+ */
+class slab_pool : immovable {
+public:
+  /** @brief The size type. */
+  using size_type = std::size_t;
+
+  /** @brief A snapshot of the pool occupancy counters. */
+  struct stats_type {
+    /** @brief The number of slabs. */
+    size_type slabs = 0;
+    /** @brief The number of blocks in all slabs. */
+    size_type capacity = 0;
+    /** @brief The number of blocks that are in use. */
+    size_type in_use = 0;
+    /** @brief The largest number of blocks that were in use at once. */
+    size_type peak = 0;
+  };
+
+  /**
+   * @brief Constructor.
+   * @param slab_size The number of blocks in each slab.
+   */
+  explicit slab_pool(size_type slab_size = DEFAULT_SLAB_SIZE) noexcept
+      : slab_size_{slab_size > 0 ? slab_size : 1}
+  {}
+
+  /**
+   * @brief Allocates a block.
+   * @param size The requested size. Must not exceed the size of the first
+   * allocation.
+   * @param align The requested alignment.
+   * @returns A pointer to the block.
+   * @throws std::bad_alloc if the request doesn't fit in a block, or if a
+   * new slab can't be allocated.
+   */
+  [[nodiscard]] auto allocate(size_type size, size_type align) -> void *
+  {
+    if (block_size_ == 0)
+    {
+      align_ = std::max(align, alignof(node));
+      block_size_ = std::max(size, sizeof(node));
+      block_size_ = (block_size_ + align_ - 1) & ~(align_ - 1);
+    }
+
+    if (size > block_size_ || align > align_)
+      throw std::bad_alloc();
+
+    if (!free_)
+      grow_();
+
+    auto *block = std::exchange(free_, free_->next);
+    const auto in_use = in_use_.load(std::memory_order_relaxed) + 1;
+    in_use_.store(in_use, std::memory_order_relaxed);
+    if (in_use > peak_.load(std::memory_order_relaxed))
+      peak_.store(in_use, std::memory_order_relaxed);
+
+    return block;
+  }
+
+  /**
+   * @brief Returns a block to the pool.
+   * @param ptr A block returned by allocate().
+   */
+  auto deallocate(void *ptr) noexcept -> void
+  {
+    assert(in_use_.load(std::memory_order_relaxed) > 0 &&
+           "ptr must have been allocated by this pool.");
+    free_ = ::new (ptr) node{free_};
+    in_use_.store(in_use_.load(std::memory_order_relaxed) - 1,
+                  std::memory_order_relaxed);
+  }
+
+  /** @returns A snapshot of the occupancy counters. */
+  [[nodiscard]] auto stats() const noexcept -> stats_type
+  {
+    const auto slabs = slabs_count_.load(std::memory_order_relaxed);
+    return {.slabs = slabs,
+            .capacity = slabs * slab_size_,
+            .in_use = in_use_.load(std::memory_order_relaxed),
+            .peak = peak_.load(std::memory_order_relaxed)};
+  }
+
+  /** @returns The number of blocks in each slab. */
+  [[nodiscard]] auto slab_size() const noexcept -> size_type
+  {
+    return slab_size_;
+  }
+
+  /** @returns The block size, or 0 if nothing has been allocated yet. */
+  [[nodiscard]] auto block_size() const noexcept -> size_type
+  {
+    return block_size_;
+  }
+
+  /** @brief Releases every slab. */
+  ~slab_pool()
+  {
+    for (auto *slab : slabs_)
+      ::operator delete(slab, std::align_val_t{align_});
+  }
+
+  /** @brief The default number of blocks in each slab. */
+  static constexpr size_type DEFAULT_SLAB_SIZE = 16;
+
+private:
+  /** @brief The free list hook that is stored in a free block. */
+  struct node {
+    /** @brief The next free block. */
+    node *next;
+  };
+
+  /** @brief Allocates a slab and links its blocks into the free list. */
+  auto grow_() -> void
+  {
+    // Make room first so that push_back can't throw and leak the slab, but
+    // grow geometrically to keep the pushes amortized constant time.
+    if (slabs_.size() == slabs_.capacity())
+      slabs_.reserve(std::max(slabs_.size() * 2, size_type{1}));
+
+    auto *slab = static_cast<std::byte *>(
+        ::operator new(block_size_ * slab_size_, std::align_val_t{align_}));
+    slabs_.push_back(slab);
+
+    for (auto i = slab_size_; i > 0; --i)
+      free_ = ::new (slab + ((i - 1) * block_size_)) node{free_};
+
+    slabs_count_.store(slabs_.size(), std::memory_order_relaxed);
+  }
+
+  /** @brief The number of blocks in each slab. */
+  size_type slab_size_;
+  /** @brief The block size. */
+  size_type block_size_ = 0;
+  /** @brief The block alignment. */
+  size_type align_ = alignof(node);
+  /** @brief The first free block. */
+  node *free_ = nullptr;
+  /** @brief The slabs. */
+  std::vector<std::byte *> slabs_;
+  /** @brief The number of slabs. */
+  std::atomic<size_type> slabs_count_{0};
+  /** @brief The number of blocks that are in use. */
+  std::atomic<size_type> in_use_{0};
+  /** @brief The high water mark of in_use_. */
+  std::atomic<size_type> peak_{0};
+};
+
+/**
+ * @brief An allocator that allocates single objects from a slab_pool.
+ * @details The allocator shares ownership of its pool, so a pool outlives
+ * every object allocated from it. This makes it suitable for
+ * `std::allocate_shared`, which stores a copy of the allocator next to the
+ * object.
+ * @tparam T The value type.
+ */
+template <typename T> class slab_allocator {
+public:
+  /** @brief The value type. */
+  using value_type = T;
+
+  /**
+   * @brief Constructor.
+   * @param pool The pool to allocate from.
+   */
+  explicit slab_allocator(std::shared_ptr<slab_pool> pool) noexcept
+      : pool_{std::move(pool)}
+  {}
+
+  /** @brief Rebinding constructor. */
+  template <typename U>
+  slab_allocator( // NOLINT(google-explicit-constructor)
+      const slab_allocator<U> &other) noexcept
+      : pool_{other.pool()}
+  {}
+
+  /**
+   * @brief Allocates storage for one object.
+   * @param count The number of objects. Must be 1.
+   * @returns The storage.
+   */
+  [[nodiscard]] auto allocate(std::size_t count) -> T *
+  {
+    if (count != 1)
+      throw std::bad_alloc();
+
+    return static_cast<T *>(pool_->allocate(sizeof(T), alignof(T)));
+  }
+
+  /**
+   * @brief Returns storage to the pool.
+   * @param ptr The storage to return.
+   */
+  auto deallocate(T *ptr, std::size_t /*count*/) noexcept -> void
+  {
+    pool_->deallocate(ptr);
+  }
+
+  /** @returns The pool. */
+  [[nodiscard]] auto pool() const noexcept -> const std::shared_ptr<slab_pool> &
+  {
+    return pool_;
+  }
+
+  /** @brief Allocators are equal if they share a pool. */
+  template <typename U>
+  auto operator==(const slab_allocator<U> &other) const noexcept -> bool
+  {
+    return pool_ == other.pool();
+  }
+
+private:
+  /** @brief The pool. */
+  std::shared_ptr<slab_pool> pool_;
+};
+
+} // namespace net::detail
+#endif // CPPNET_SLAB_POOL_HPP
@@ -0,0 +1,206 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file epoll_multiplexer.hpp
+ * @brief This file declares an epoll based io multiplexer.
+ */
+#pragma once
+#ifndef CPPNET_EPOLL_MULTIPLEXER_HPP
+#define CPPNET_EPOLL_MULTIPLEXER_HPP
+#include "net/detail/immovable.hpp"
+
+#include <io/io.hpp>
+#include <stdexec/execution.hpp>
+#include <sys/epoll.h>
+
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <vector>
+/** @brief This namespace is for cppnet execution backends. */
+namespace net::execution {
+/**
+ * @brief An epoll based multiplexer.
+ * @details epoll_multiplexer is a drop-in replacement for
+ * `io::execution::poll_multiplexer`. Unlike poll, the cost of a call to
+ * `wait_for()` scales with the number of file descriptors that are ready
+ * rather than with the number of file descriptors that are registered,
+ * which makes it the better choice for services that hold many mostly
+ * idle connections. Descriptors are registered with `EPOLLONESHOT` so that
+ * a descriptor number that is recycled by the kernel after `close()` never
+ * inherits a stale registration.
+ * @code
+ * using context = basic_async_context<net::execution::epoll_multiplexer>;
+ * @endcode
+ */
+class epoll_multiplexer : net::detail::immovable {
+public:
+  /** @brief The multiplexer event type. */
+  using event_type = ::epoll_event;
+  /** @brief The wait interval type (milliseconds). */
+  using interval_type = int;
+  /** @brief The size type. */
+  using size_type = std::size_t;
+  /** @brief The native socket type. */
+  using socket_type = io::socket::native_socket_type;
+  /** @brief The socket handle type. */
+  using socket_handle = io::socket::socket_handle;
+  /** @brief The execution trigger type. */
+  using trigger = io::execution::execution_trigger;
+
+  /**
+   * @brief A trigger that only waits for a socket error or a hangup. A
+   * socket with unread data is always readable, so this is how the socket
+   * error queue is waited on.
+   */
+  static constexpr auto ERRORS = static_cast<trigger>(
+      std::numeric_limits<std::underlying_type_t<trigger>>::max());
+
+  /**
+   * @brief A sender that completes when a socket is ready and the supplied
+   * function has been executed without blocking.
+   * @tparam Fn A callable that returns a signed integral. A negative return
+   * value indicates failure, and the error is read from errno.
+   */
+  template <typename Fn> class sender;
+
+  /**
+   * @brief Constructs the epoll instance.
+   * @throws std::system_error if the epoll instance can't be created.
+   */
+  epoll_multiplexer();
+
+  /**
+   * @brief Returns a sender that executes `exec` when `socket` is ready for
+   * `event`.
+   * @details If `exec` fails with `EAGAIN` or `EWOULDBLOCK` the operation
+   * is re-armed and waits for the next readiness notification.
+   * @tparam Fn The function type.
+   * @param socket The socket to wait on. Its lifetime is extended until the
+   * operation completes.
+   * @param event The execution trigger to wait for.
+   * @param exec The function to run once the socket is ready.
+   * @returns A sender that completes with the result of `exec`.
+   */
+  template <typename Fn>
+    requires std::is_invocable_v<Fn &>
+  auto set(std::shared_ptr<socket_handle> socket, trigger event,
+           Fn &&exec) -> sender<std::decay_t<Fn>>;
+
+  /**
+   * @brief Waits for io events and completes any ready operations.
+   * @param interval The maximum time in milliseconds to block for. A
+   * negative interval blocks indefinitely.
+   * @returns The number of io events that were handled.
+   */
+  auto wait_for(interval_type interval) -> size_type;
+
+  /** @brief Closes the epoll instance. */
+  ~epoll_multiplexer();
+
+private:
+  /** @brief Type-erased base of all pending operations. */
+  struct operation_base {
+    /** @brief Completion function type. */
+    using complete_fn = auto(operation_base *) noexcept -> bool;
+    /** @brief Stopped function type. */
+    using stopped_fn = auto(operation_base *) noexcept -> void;
+    /** @brief Error function type. */
+    using error_fn = auto(operation_base *, int) noexcept -> void;
+
+    /** @brief Runs the operation, returns false if it would block. */
+    complete_fn *complete = nullptr;
+    /** @brief Completes the operation with set_stopped. */
+    stopped_fn *stopped = nullptr;
+    /** @brief Completes the operation with set_error. */
+    error_fn *error = nullptr;
+    /** @brief The native file descriptor. */
+    socket_type fd = io::socket::INVALID_SOCKET;
+    /** @brief The trigger the operation is waiting for. */
+    trigger event{};
+    /** @brief The next operation waiting on the same descriptor. */
+    operation_base *next = nullptr;
+    /** @brief The previous operation waiting on the same descriptor. */
+    operation_base *prev = nullptr;
+    /** @brief Whether the operation is linked into a wait list. */
+    bool linked = false;
+    /** @brief Set when a stop is requested before the operation is armed. */
+    bool cancelled = false;
+  };
+
+  template <typename Fn, typename Receiver> class operation;
+
+  /** @brief Per file descriptor wait state. */
+  struct descriptor {
+    /** @brief The head of the list of waiting operations. */
+    operation_base *head = nullptr;
+    /** @brief The tail of the list of waiting operations. */
+    operation_base *tail = nullptr;
+    /** @brief The events currently armed in the epoll instance. */
+    std::uint32_t armed = 0;
+    /** @brief Whether the descriptor has been added to the epoll set. */
+    bool registered = false;
+  };
+
+  /**
+   * @brief Adds an operation to the wait list of its descriptor, arming
+   * the descriptor if it isn't armed already.
+   * @param op The operation to add.
+   */
+  auto arm_(operation_base *op) noexcept -> void;
+  /**
+   * @brief Removes an operation from the wait list, if it is still linked.
+   * @param op The operation to cancel.
+   */
+  auto cancel_(operation_base *op) noexcept -> void;
+  /**
+   * @brief Unlinks an operation from its descriptor wait list. Must be
+   * called while holding the lock.
+   * @param desc The descriptor the operation is waiting on.
+   * @param op The operation to unlink.
+   */
+  static auto unlink_(descriptor &desc, operation_base *op) noexcept -> void;
+  /**
+   * @brief Computes the epoll events needed by the waiters on a descriptor.
+   * @param desc The descriptor.
+   * @returns The union of epoll events.
+   */
+  static auto interest_(const descriptor &desc) noexcept -> std::uint32_t;
+  /**
+   * @brief Re-arms a descriptor in the epoll instance. Must be called while
+   * holding the lock.
+   * @param fd The native file descriptor.
+   * @param desc The descriptor state.
+   * @returns 0 on success, otherwise the errno of the failed epoll_ctl.
+   */
+  auto rearm_(socket_type fd, descriptor &desc) noexcept -> int;
+
+  /** @brief Per file descriptor state, indexed by file descriptor. */
+  std::vector<descriptor> descriptors_;
+  /** @brief Scratch buffer for epoll_wait. */
+  std::vector<event_type> events_;
+  /** @brief Mutex for thread-safety. */
+  std::mutex mtx_;
+  /** @brief The epoll file descriptor. */
+  int epfd_{-1};
+};
+
+} // namespace net::execution
+
+#include "impl/epoll_multiplexer_impl.hpp" // IWYU pragma: export
+
+#endif // CPPNET_EPOLL_MULTIPLEXER_HPP
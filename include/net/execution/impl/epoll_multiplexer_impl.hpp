@@ -0,0 +1,411 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file epoll_multiplexer_impl.hpp
+ * @brief This file defines the epoll based io multiplexer.
+ */
+#pragma once
+#ifndef CPPNET_EPOLL_MULTIPLEXER_IMPL_HPP
+#define CPPNET_EPOLL_MULTIPLEXER_IMPL_HPP
+#include "net/execution/epoll_multiplexer.hpp"
+
+#include <cerrno>
+#include <functional>
+#include <span>
+#include <system_error>
+#include <utility>
+namespace net::execution {
+/**
+ * @brief The operation state of an epoll_multiplexer::sender.
+ * @tparam Fn The function to execute once the socket is ready.
+ * @tparam Receiver The receiver type.
+ */
+template <typename Fn, typename Receiver>
+class epoll_multiplexer::operation : operation_base {
+public:
+  /**
+   * @brief Constructor.
+   * @param mux The multiplexer to wait on.
+   * @param socket The socket to wait on.
+   * @param event The execution trigger to wait for.
+   * @param exec The function to execute once the socket is ready.
+   * @param receiver The receiver to complete.
+   */
+  operation(epoll_multiplexer *mux, std::shared_ptr<socket_handle> socket,
+            trigger event, Fn exec, Receiver receiver) noexcept
+      : operation_base{.complete = complete_,
+                       .stopped = stopped_,
+                       .error = error_,
+                       .fd = static_cast<socket_type>(*socket),
+                       .event = event},
+        mux_{mux}, socket_{std::move(socket)}, exec_{std::move(exec)},
+        receiver_{std::move(receiver)}
+  {}
+  /** @brief Deleted copy constructor. */
+  operation(const operation &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const operation &) -> operation & = delete;
+
+  /** @brief Arms the operation in the multiplexer. */
+  auto start() & noexcept -> void
+  {
+    auto token = stdexec::get_stop_token(stdexec::get_env(receiver_));
+    if (token.stop_requested())
+    {
+      stdexec::set_stopped(std::move(receiver_));
+      return;
+    }
+
+    on_stop_.emplace(token, on_stop{this});
+    mux_->arm_(this);
+  }
+
+  /** @brief Default destructor. */
+  ~operation() = default;
+
+private:
+  /** @brief Cancels the operation when a stop is requested. */
+  struct on_stop {
+    /** @brief The operation to cancel. */
+    operation *self;
+    /** @brief Cancels the operation. */
+    auto operator()() const noexcept -> void
+    {
+      self->mux_->cancel_(static_cast<operation_base *>(self));
+    }
+  };
+  /** @brief The receiver stop token type. */
+  using stop_token_type =
+      stdexec::stop_token_of_t<stdexec::env_of_t<Receiver>>;
+  /** @brief The stop callback type. */
+  using stop_callback_type =
+      stdexec::stop_callback_for_t<stop_token_type, on_stop>;
+
+  /** @brief Runs exec, returns false if exec would block. */
+  static auto complete_(operation_base *base) noexcept -> bool
+  {
+    auto *self = static_cast<operation *>(base);
+    auto result = std::invoke(self->exec_);
+    if (result < 0)
+    {
+      auto error = errno;
+      if (error == EAGAIN || error == EWOULDBLOCK)
+        return false;
+
+      error_(base, error);
+      return true;
+    }
+
+    self->on_stop_.reset();
+    stdexec::set_value(std::move(self->receiver_), std::move(result));
+    return true;
+  }
+
+  /** @brief Completes the receiver with set_stopped. */
+  static auto stopped_(operation_base *base) noexcept -> void
+  {
+    auto *self = static_cast<operation *>(base);
+    self->on_stop_.reset();
+    stdexec::set_stopped(std::move(self->receiver_));
+  }
+
+  /** @brief Completes the receiver with set_error. */
+  static auto error_(operation_base *base, int error) noexcept -> void
+  {
+    auto *self = static_cast<operation *>(base);
+    self->on_stop_.reset();
+    stdexec::set_error(std::move(self->receiver_), std::move(error));
+  }
+
+  /** @brief The multiplexer. */
+  epoll_multiplexer *mux_;
+  /** @brief The socket. */
+  std::shared_ptr<socket_handle> socket_;
+  /** @brief The function to run when the socket is ready. */
+  Fn exec_;
+  /** @brief The receiver. */
+  Receiver receiver_;
+  /** @brief The stop callback. */
+  std::optional<stop_callback_type> on_stop_;
+};
+
+/**
+ * @brief A sender that executes a function when a socket becomes ready.
+ * @tparam Fn The function type.
+ */
+template <typename Fn> class epoll_multiplexer::sender {
+public:
+  /** @brief The sender concept. */
+  using sender_concept = stdexec::sender_t;
+  /** @brief The completion signatures. */
+  using completion_signatures = stdexec::completion_signatures<
+      stdexec::set_value_t(std::invoke_result_t<Fn &>),
+      stdexec::set_error_t(int), stdexec::set_stopped_t()>;
+
+  /**
+   * @brief Constructor.
+   * @param mux The multiplexer to wait on.
+   * @param socket The socket to wait on.
+   * @param event The execution trigger to wait for.
+   * @param exec The function to execute once the socket is ready.
+   */
+  sender(epoll_multiplexer *mux, std::shared_ptr<socket_handle> socket,
+         trigger event, Fn exec) noexcept
+      : mux_{mux}, socket_{std::move(socket)}, event_{event},
+        exec_{std::move(exec)}
+  {}
+
+  /**
+   * @brief Connects the sender to a receiver.
+   * @tparam Receiver The receiver type.
+   * @param receiver The receiver.
+   * @returns The operation state.
+   */
+  template <stdexec::receiver Receiver>
+  auto connect(Receiver receiver) && -> operation<Fn, Receiver>
+  {
+    return {mux_, std::move(socket_), event_, std::move(exec_),
+            std::move(receiver)};
+  }
+
+  /**
+   * @brief Connects a copy of the sender to a receiver.
+   * @tparam Receiver The receiver type.
+   * @param receiver The receiver.
+   * @returns The operation state.
+   */
+  template <stdexec::receiver Receiver>
+    requires std::copy_constructible<Fn>
+  auto connect(Receiver receiver) const & -> operation<Fn, Receiver>
+  {
+    return {mux_, socket_, event_, exec_, std::move(receiver)};
+  }
+
+private:
+  /** @brief The multiplexer. */
+  epoll_multiplexer *mux_;
+  /** @brief The socket. */
+  std::shared_ptr<socket_handle> socket_;
+  /** @brief The execution trigger. */
+  trigger event_;
+  /** @brief The function to run when the socket is ready. */
+  Fn exec_;
+};
+
+inline epoll_multiplexer::epoll_multiplexer()
+    : epfd_{::epoll_create1(EPOLL_CLOEXEC)}
+{
+  static constexpr auto EVENTS = 64UL;
+  if (epfd_ < 0)
+    throw std::system_error(errno, std::system_category(), "epoll_create1");
+
+  events_.resize(EVENTS);
+}
+
+template <typename Fn>
+  requires std::is_invocable_v<Fn &>
+auto epoll_multiplexer::set(std::shared_ptr<socket_handle> socket,
+                            trigger event,
+                            Fn &&exec) -> sender<std::decay_t<Fn>>
+{
+  return {this, std::move(socket), event, std::forward<Fn>(exec)};
+}
+
+inline auto epoll_multiplexer::wait_for(interval_type interval) -> size_type
+{
+  using enum trigger;
+  static constexpr std::uint32_t READABLE =
+      EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR;
+  static constexpr std::uint32_t WRITABLE = EPOLLOUT | EPOLLHUP | EPOLLERR;
+  static constexpr std::uint32_t FAILED = EPOLLHUP | EPOLLERR;
+
+  auto num = ::epoll_wait(epfd_, events_.data(),
+                          static_cast<int>(events_.size()), interval);
+  if (num <= 0)
+    return 0;
+
+  const auto count = static_cast<size_type>(num);
+  for (const auto &event : std::span{events_.data(), count})
+  {
+    const auto fd = event.data.fd;
+    operation_base *ready = nullptr;
+    operation_base **tail = &ready;
+
+    {
+      auto lock = std::lock_guard{mtx_};
+      auto &desc = descriptors_[fd];
+      desc.armed = 0;
+      for (auto *op = desc.head; op != nullptr;)
+      {
+        auto *next = op->next;
+        auto mask = (op->event == ERRORS) ? FAILED
+                    : (op->event == READ)   ? READABLE
+                                            : WRITABLE;
+        if (event.events & mask)
+        {
+          unlink_(desc, op);
+          *tail = op;
+          tail = &op->next;
+        }
+        op = next;
+      }
+    }
+
+    // Operations are completed without holding the lock, since
+    // completing a receiver may start new operations.
+    while (ready)
+    {
+      auto *op = std::exchange(ready, ready->next);
+      op->next = nullptr;
+      if (!op->complete(op))
+        arm_(op);
+    }
+    tail = &ready;
+
+    // Re-arm the descriptor for any remaining waiters.
+    int error = 0;
+    {
+      auto lock = std::lock_guard{mtx_};
+      auto &desc = descriptors_[fd];
+      if (desc.head && (error = rearm_(fd, desc)))
+      {
+        while (auto *op = desc.head)
+        {
+          unlink_(desc, op);
+          *tail = op;
+          tail = &op->next;
+        }
+      }
+    }
+
+    while (ready)
+    {
+      auto *op = std::exchange(ready, ready->next);
+      op->error(op, error);
+    }
+  }
+
+  if (count == events_.size())
+    events_.resize(count * 2);
+
+  return count;
+}
+
+inline auto epoll_multiplexer::arm_(operation_base *op) noexcept -> void
+{
+  auto lock = std::unique_lock{mtx_};
+  if (op->cancelled)
+  {
+    lock.unlock();
+    op->stopped(op);
+    return;
+  }
+
+  const auto fd = static_cast<std::size_t>(op->fd);
+  if (fd >= descriptors_.size())
+    descriptors_.resize(fd + 1);
+
+  auto &desc = descriptors_[fd];
+  op->prev = desc.tail;
+  op->next = nullptr;
+  (desc.tail ? desc.tail->next : desc.head) = op;
+  desc.tail = op;
+  op->linked = true;
+
+  if (auto error = rearm_(op->fd, desc))
+  {
+    unlink_(desc, op);
+    lock.unlock();
+    op->error(op, error);
+  }
+}
+
+inline auto epoll_multiplexer::cancel_(operation_base *op) noexcept -> void
+{
+  {
+    auto lock = std::lock_guard{mtx_};
+    op->cancelled = true;
+    if (!op->linked)
+      return;
+
+    // The descriptor may be closed and its number recycled before the
+    // next wait, so the next wait must not trust the armed events.
+    auto &desc = descriptors_[op->fd];
+    unlink_(desc, op);
+    desc.armed = 0;
+  }
+  op->stopped(op);
+}
+
+inline auto epoll_multiplexer::unlink_(descriptor &desc,
+                                       operation_base *op) noexcept -> void
+{
+  (op->prev ? op->prev->next : desc.head) = op->next;
+  (op->next ? op->next->prev : desc.tail) = op->prev;
+  op->next = op->prev = nullptr;
+  op->linked = false;
+}
+
+inline auto
+epoll_multiplexer::interest_(const descriptor &desc) noexcept -> std::uint32_t
+{
+  using enum trigger;
+  std::uint32_t events = 0;
+  for (auto *op = desc.head; op != nullptr; op = op->next)
+  {
+    // epoll always reports errors, but an error-only wait still needs
+    // some interest for the descriptor to be armed.
+    events |= (op->event == ERRORS) ? EPOLLERR
+              : (op->event == READ) ? (EPOLLIN | EPOLLRDHUP)
+                                    : EPOLLOUT;
+  }
+
+  return events;
+}
+
+inline auto epoll_multiplexer::rearm_(socket_type fd,
+                                      descriptor &desc) noexcept -> int
+{
+  auto events = interest_(desc);
+  if (!events || (events & desc.armed) == events)
+    return 0;
+
+  auto event = event_type{.events = events | EPOLLONESHOT, .data = {.fd = fd}};
+  auto [first, second] = desc.registered
+                             ? std::pair{EPOLL_CTL_MOD, EPOLL_CTL_ADD}
+                             : std::pair{EPOLL_CTL_ADD, EPOLL_CTL_MOD};
+
+  // A registration can go stale if the descriptor number was closed and
+  // recycled, so fall back to the other operation before giving up.
+  if (::epoll_ctl(epfd_, first, fd, &event) &&
+      ::epoll_ctl(epfd_, second, fd, &event))
+  {
+    return errno;
+  }
+
+  desc.registered = true;
+  desc.armed = events;
+  return 0;
+}
+
+inline epoll_multiplexer::~epoll_multiplexer()
+{
+  if (epfd_ >= 0)
+    ::close(epfd_);
+}
+
+} // namespace net::execution
+#endif // CPPNET_EPOLL_MULTIPLEXER_IMPL_HPP
@@ -0,0 +1,744 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file io_uring_multiplexer_impl.hpp
+ * @brief This file defines the io_uring based io multiplexer.
+ */
+#pragma once
+#ifndef CPPNET_IO_URING_MULTIPLEXER_IMPL_HPP
+#define CPPNET_IO_URING_MULTIPLEXER_IMPL_HPP
+#include "net/execution/io_uring_multiplexer.hpp"
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <functional>
+#include <system_error>
+#include <utility>
+namespace net::execution {
+/**
+ * @brief The operation state of an io_uring_multiplexer::sender.
+ * @tparam Fn The function to execute once the socket is ready.
+ * @tparam Receiver The receiver type.
+ */
+template <typename Fn, typename Receiver>
+class io_uring_multiplexer::poll_operation : operation_base {
+public:
+  /**
+   * @brief Constructor.
+   * @param mux The multiplexer to wait on.
+   * @param socket The socket to wait on.
+   * @param event The execution trigger to wait for.
+   * @param exec The function to execute once the socket is ready.
+   * @param receiver The receiver to complete.
+   */
+  poll_operation(io_uring_multiplexer *mux,
+                 std::shared_ptr<socket_handle> socket, trigger event,
+                 Fn exec, Receiver receiver) noexcept
+      : operation_base{.complete = complete_,
+                       .stop_requested = stop_requested_},
+        mux_{mux}, socket_{std::move(socket)}, event_{event},
+        exec_{std::move(exec)}, receiver_{std::move(receiver)}
+  {}
+  /** @brief Deleted copy constructor. */
+  poll_operation(const poll_operation &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const poll_operation &) -> poll_operation & = delete;
+
+  /** @brief Submits a poll request for the socket. */
+  auto start() & noexcept -> void
+  {
+    auto token = stdexec::get_stop_token(stdexec::get_env(receiver_));
+    if (token.stop_requested())
+    {
+      stdexec::set_stopped(std::move(receiver_));
+      return;
+    }
+
+    on_stop_.emplace(token, on_stop{this});
+    arm_();
+  }
+
+  /** @brief Default destructor. */
+  ~poll_operation() = default;
+
+private:
+  /** @brief Cancels the operation when a stop is requested. */
+  struct on_stop {
+    /** @brief The operation to cancel. */
+    poll_operation *self;
+    /** @brief Cancels the operation. */
+    auto operator()() const noexcept -> void { self->mux_->cancel_(self); }
+  };
+  /** @brief The receiver stop token type. */
+  using stop_token_type =
+      stdexec::stop_token_of_t<stdexec::env_of_t<Receiver>>;
+  /** @brief The stop callback type. */
+  using stop_callback_type =
+      stdexec::stop_callback_for_t<stop_token_type, on_stop>;
+
+  /** @brief Queues a poll request, or completes with set_stopped. */
+  auto arm_() noexcept -> void
+  {
+    using enum trigger;
+    auto sqe = ::io_uring_sqe{};
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = static_cast<socket_type>(*socket_);
+    sqe.poll32_events = (event_ == ERRORS) ? POLLERR
+                        : (event_ == READ)  ? (POLLIN | POLLRDHUP)
+                                            : POLLOUT;
+    sqe.user_data =
+        reinterpret_cast<std::uint64_t>(static_cast<operation_base *>(this));
+
+    if (auto error = mux_->submit_(this, sqe))
+    {
+      on_stop_.reset();
+      if (error == ECANCELED)
+        return stdexec::set_stopped(std::move(receiver_));
+
+      stdexec::set_error(std::move(receiver_), std::move(error));
+    }
+  }
+
+  /** @brief Runs exec once the poll request completes. */
+  static auto complete_(operation_base *base, int res) noexcept -> void
+  {
+    auto *self = static_cast<poll_operation *>(base);
+    // A cancelled request is re-armed, which completes the receiver with
+    // set_stopped if the cancellation was requested by the receiver.
+    if (res == -ECANCELED)
+      return self->arm_();
+
+    if (res < 0)
+      return self->error_(-res);
+
+    auto result = std::invoke(self->exec_);
+    if (result < 0)
+    {
+      auto error = errno;
+      if (error == EAGAIN || error == EWOULDBLOCK)
+        return self->arm_();
+
+      return self->error_(error);
+    }
+
+    self->on_stop_.reset();
+    stdexec::set_value(std::move(self->receiver_), std::move(result));
+  }
+
+  /** @brief Returns true if the receiver has requested a stop. */
+  static auto stop_requested_(const operation_base *base) noexcept -> bool
+  {
+    const auto *self = static_cast<const poll_operation *>(base);
+    return stdexec::get_stop_token(stdexec::get_env(self->receiver_))
+        .stop_requested();
+  }
+
+  /** @brief Completes the receiver with set_error. */
+  auto error_(int error) noexcept -> void
+  {
+    on_stop_.reset();
+    stdexec::set_error(std::move(receiver_), std::move(error));
+  }
+
+  /** @brief The multiplexer. */
+  io_uring_multiplexer *mux_;
+  /** @brief The socket. */
+  std::shared_ptr<socket_handle> socket_;
+  /** @brief The execution trigger. */
+  trigger event_;
+  /** @brief The function to run when the socket is ready. */
+  Fn exec_;
+  /** @brief The receiver. */
+  Receiver receiver_;
+  /** @brief The stop callback. */
+  std::optional<stop_callback_type> on_stop_;
+};
+
+/**
+ * @brief The operation state of an io_uring_multiplexer::io_sender.
+ * @details The operation state owns the msghdr and iovec that are handed to
+ * the kernel, so they remain valid for as long as the request is in flight.
+ * @tparam Receiver The receiver type.
+ */
+template <typename Receiver>
+class io_uring_multiplexer::io_operation : operation_base {
+public:
+  /**
+   * @brief Constructor.
+   * @param mux The multiplexer to submit to.
+   * @param req The io request.
+   * @param receiver The receiver to complete.
+   */
+  io_operation(io_uring_multiplexer *mux, request req,
+               Receiver receiver) noexcept
+      : operation_base{.complete = complete_,
+                       .stop_requested = stop_requested_},
+        mux_{mux}, request_{std::move(req)}, receiver_{std::move(receiver)}
+  {}
+  /** @brief Deleted copy constructor. */
+  io_operation(const io_operation &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const io_operation &) -> io_operation & = delete;
+
+  /** @brief Submits the request. */
+  auto start() & noexcept -> void
+  {
+    auto token = stdexec::get_stop_token(stdexec::get_env(receiver_));
+    if (token.stop_requested())
+    {
+      stdexec::set_stopped(std::move(receiver_));
+      return;
+    }
+
+    on_stop_.emplace(token, on_stop{this});
+    submit_();
+  }
+
+  /** @brief Default destructor. */
+  ~io_operation() = default;
+
+private:
+  /** @brief Cancels the operation when a stop is requested. */
+  struct on_stop {
+    /** @brief The operation to cancel. */
+    io_operation *self;
+    /** @brief Cancels the operation. */
+    auto operator()() const noexcept -> void { self->mux_->cancel_(self); }
+  };
+  /** @brief The receiver stop token type. */
+  using stop_token_type =
+      stdexec::stop_token_of_t<stdexec::env_of_t<Receiver>>;
+  /** @brief The stop callback type. */
+  using stop_callback_type =
+      stdexec::stop_callback_for_t<stop_token_type, on_stop>;
+
+  /** @brief Queues the request, or completes with set_stopped. */
+  auto submit_() noexcept -> void
+  {
+    polling_ = false;
+    using enum request_kind;
+    auto sqe = ::io_uring_sqe{};
+    sqe.fd = static_cast<socket_type>(*request_.socket);
+    sqe.user_data =
+        reinterpret_cast<std::uint64_t>(static_cast<operation_base *>(this));
+
+    if (request_.kind == ACCEPT)
+    {
+      sqe.opcode = IORING_OP_ACCEPT;
+      sqe.accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    }
+    else
+    {
+      iov_.iov_base = request_.buffer.data();
+      iov_.iov_len = request_.buffer.size();
+      msg_ = {};
+      msg_.msg_name = request_.address;
+      msg_.msg_namelen = request_.addrlen;
+      msg_.msg_iov = &iov_;
+      msg_.msg_iovlen = 1;
+
+      sqe.opcode =
+          (request_.kind == RECVMSG) ? IORING_OP_RECVMSG : IORING_OP_SENDMSG;
+      sqe.addr = reinterpret_cast<std::uint64_t>(&msg_);
+      sqe.len = 1;
+      sqe.msg_flags = static_cast<std::uint32_t>(request_.flags);
+    }
+
+    queue_(sqe);
+  }
+
+  /**
+   * @brief Waits for the socket to become ready before the request is
+   * submitted again.
+   */
+  auto poll_() noexcept -> void
+  {
+    auto sqe = ::io_uring_sqe{};
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = static_cast<socket_type>(*request_.socket);
+    sqe.poll32_events = (request_.kind == request_kind::SENDMSG)
+                            ? POLLOUT
+                            : (POLLIN | POLLRDHUP);
+    sqe.user_data =
+        reinterpret_cast<std::uint64_t>(static_cast<operation_base *>(this));
+
+    polling_ = true;
+    queue_(sqe);
+  }
+
+  /** @brief Queues a submission, or completes the receiver. */
+  auto queue_(const ::io_uring_sqe &sqe) noexcept -> void
+  {
+    if (auto error = mux_->submit_(this, sqe))
+    {
+      on_stop_.reset();
+      if (error == ECANCELED)
+        return stdexec::set_stopped(std::move(receiver_));
+
+      stdexec::set_error(std::move(receiver_), std::move(error));
+    }
+  }
+
+  /** @brief Completes the receiver with the result of the request. */
+  static auto complete_(operation_base *base, int res) noexcept -> void
+  {
+    auto *self = static_cast<io_operation *>(base);
+    // A socket that would block is polled instead of resubmitting the
+    // request straight away, which would spin until it becomes ready.
+    if (std::exchange(self->polling_, false))
+    {
+      if (res >= 0 || res == -ECANCELED || res == -EINTR)
+        return self->submit_();
+    }
+    else if (res == -EAGAIN)
+    {
+      return self->poll_();
+    }
+    // Cancelled and interrupted requests are resubmitted, which completes
+    // the receiver with set_stopped if the receiver requested the stop.
+    else if (res == -ECANCELED || res == -EINTR)
+    {
+      return self->submit_();
+    }
+
+    self->on_stop_.reset();
+    if (res < 0)
+      return stdexec::set_error(std::move(self->receiver_), -res);
+
+    if (self->request_.addrlen_out)
+      *self->request_.addrlen_out = self->msg_.msg_namelen;
+
+    stdexec::set_value(std::move(self->receiver_), std::move(res));
+  }
+
+  /** @brief Returns true if the receiver has requested a stop. */
+  static auto stop_requested_(const operation_base *base) noexcept -> bool
+  {
+    const auto *self = static_cast<const io_operation *>(base);
+    return stdexec::get_stop_token(stdexec::get_env(self->receiver_))
+        .stop_requested();
+  }
+
+  /** @brief The multiplexer. */
+  io_uring_multiplexer *mux_;
+  /** @brief The request. */
+  request request_;
+  /** @brief The receiver. */
+  Receiver receiver_;
+  /** @brief The message header handed to the kernel. */
+  ::msghdr msg_{};
+  /** @brief The io vector handed to the kernel. */
+  ::iovec iov_{};
+  /** @brief True while the operation waits for the socket to be ready. */
+  bool polling_ = false;
+  /** @brief The stop callback. */
+  std::optional<stop_callback_type> on_stop_;
+};
+
+/**
+ * @brief A sender that executes a function when a socket becomes ready.
+ * @tparam Fn The function type.
+ */
+template <typename Fn> class io_uring_multiplexer::sender {
+public:
+  /** @brief The sender concept. */
+  using sender_concept = stdexec::sender_t;
+  /** @brief The completion signatures. */
+  using completion_signatures = stdexec::completion_signatures<
+      stdexec::set_value_t(std::invoke_result_t<Fn &>),
+      stdexec::set_error_t(int), stdexec::set_stopped_t()>;
+
+  /**
+   * @brief Constructor.
+   * @param mux The multiplexer to wait on.
+   * @param socket The socket to wait on.
+   * @param event The execution trigger to wait for.
+   * @param exec The function to execute once the socket is ready.
+   */
+  sender(io_uring_multiplexer *mux, std::shared_ptr<socket_handle> socket,
+         trigger event, Fn exec) noexcept
+      : mux_{mux}, socket_{std::move(socket)}, event_{event},
+        exec_{std::move(exec)}
+  {}
+
+  /**
+   * @brief Connects the sender to a receiver.
+   * @tparam Receiver The receiver type.
+   * @param receiver The receiver.
+   * @returns The operation state.
+   */
+  template <stdexec::receiver Receiver>
+  auto connect(Receiver receiver) && -> poll_operation<Fn, Receiver>
+  {
+    return {mux_, std::move(socket_), event_, std::move(exec_),
+            std::move(receiver)};
+  }
+
+  /**
+   * @brief Connects a copy of the sender to a receiver.
+   * @tparam Receiver The receiver type.
+   * @param receiver The receiver.
+   * @returns The operation state.
+   */
+  template <stdexec::receiver Receiver>
+    requires std::copy_constructible<Fn>
+  auto connect(Receiver receiver) const & -> poll_operation<Fn, Receiver>
+  {
+    return {mux_, socket_, event_, exec_, std::move(receiver)};
+  }
+
+private:
+  /** @brief The multiplexer. */
+  io_uring_multiplexer *mux_;
+  /** @brief The socket. */
+  std::shared_ptr<socket_handle> socket_;
+  /** @brief The execution trigger. */
+  trigger event_;
+  /** @brief The function to run when the socket is ready. */
+  Fn exec_;
+};
+
+/** @brief A sender for a request that is submitted directly to the ring. */
+class io_uring_multiplexer::io_sender {
+public:
+  /** @brief The sender concept. */
+  using sender_concept = stdexec::sender_t;
+  /** @brief The completion signatures. */
+  using completion_signatures =
+      stdexec::completion_signatures<stdexec::set_value_t(int),
+                                     stdexec::set_error_t(int),
+                                     stdexec::set_stopped_t()>;
+
+  /**
+   * @brief Constructor.
+   * @param mux The multiplexer to submit to.
+   * @param req The io request.
+   */
+  io_sender(io_uring_multiplexer *mux, request req) noexcept
+      : mux_{mux}, request_{std::move(req)}
+  {}
+
+  /**
+   * @brief Connects the sender to a receiver.
+   * @tparam Receiver The receiver type.
+   * @param receiver The receiver.
+   * @returns The operation state.
+   */
+  template <stdexec::receiver Receiver>
+  auto connect(Receiver receiver) && -> io_operation<Receiver>
+  {
+    return {mux_, std::move(request_), std::move(receiver)};
+  }
+
+  /**
+   * @brief Connects a copy of the sender to a receiver.
+   * @tparam Receiver The receiver type.
+   * @param receiver The receiver.
+   * @returns The operation state.
+   */
+  template <stdexec::receiver Receiver>
+  auto connect(Receiver receiver) const & -> io_operation<Receiver>
+  {
+    return {mux_, request_, std::move(receiver)};
+  }
+
+private:
+  /** @brief The multiplexer. */
+  io_uring_multiplexer *mux_;
+  /** @brief The request. */
+  request request_;
+};
+
+inline io_uring_multiplexer::io_uring_multiplexer(unsigned entries)
+{
+  static constexpr unsigned CQ_FACTOR = 4;
+  auto params = ::io_uring_params{};
+  params.flags = IORING_SETUP_CLAMP | IORING_SETUP_CQSIZE;
+  params.cq_entries = entries * CQ_FACTOR;
+
+  ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+  if (ring_fd_ < 0)
+    throw std::system_error(errno, std::system_category(), "io_uring_setup");
+
+  if (!(params.features & IORING_FEAT_EXT_ARG))
+  {
+    release_();
+    throw std::system_error(ENOSYS, std::system_category(), "io_uring_setup");
+  }
+
+  auto map = [&](std::size_t size, std::uint64_t offset) {
+    auto *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_,
+                       static_cast<::off_t>(offset));
+    if (ptr == MAP_FAILED)
+    {
+      auto error = errno;
+      release_();
+      throw std::system_error(error, std::system_category(), "mmap");
+    }
+    return std::span{static_cast<std::byte *>(ptr), size};
+  };
+
+  auto sq_size = params.sq_off.array + (params.sq_entries * sizeof(unsigned));
+  auto cq_size =
+      params.cq_off.cqes + (params.cq_entries * sizeof(::io_uring_cqe));
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    sq_size = cq_size = std::max(sq_size, cq_size);
+
+  mappings_[0] = map(sq_size, IORING_OFF_SQ_RING);
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+    mappings_[1] = map(cq_size, IORING_OFF_CQ_RING);
+  mappings_[2] =
+      map(params.sq_entries * sizeof(::io_uring_sqe), IORING_OFF_SQES);
+
+  auto *sq = mappings_[0].data();
+  auto *cq = mappings_[1].empty() ? sq : mappings_[1].data();
+  auto field = [](std::byte *base, std::uint32_t offset) {
+    return reinterpret_cast<unsigned *>(base + offset);
+  };
+
+  sq_.head = field(sq, params.sq_off.head);
+  sq_.tail = field(sq, params.sq_off.tail);
+  sq_.mask = *field(sq, params.sq_off.ring_mask);
+  sq_.entries = params.sq_entries;
+  sq_.array = field(sq, params.sq_off.array);
+  sq_.sqes = reinterpret_cast<::io_uring_sqe *>(mappings_[2].data());
+  sq_.local_tail = *sq_.tail;
+
+  cq_.head = field(cq, params.cq_off.head);
+  cq_.tail = field(cq, params.cq_off.tail);
+  cq_.mask = *field(cq, params.cq_off.ring_mask);
+  cq_.cqes = reinterpret_cast<::io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+template <typename Fn>
+  requires std::is_invocable_v<Fn &>
+auto io_uring_multiplexer::set(std::shared_ptr<socket_handle> socket,
+                               trigger event,
+                               Fn &&exec) -> sender<std::decay_t<Fn>>
+{
+  return {this, std::move(socket), event, std::forward<Fn>(exec)};
+}
+
+inline auto io_uring_multiplexer::recvmsg(std::shared_ptr<socket_handle> socket,
+                                          std::span<std::byte> buffer,
+                                          int flags, ::sockaddr *address,
+                                          ::socklen_t *addrlen) -> io_sender
+{
+  return {this, {.kind = request_kind::RECVMSG,
+                 .socket = std::move(socket),
+                 .buffer = buffer,
+                 .flags = flags,
+                 .address = address,
+                 .addrlen = addrlen ? *addrlen : ::socklen_t{0},
+                 .addrlen_out = addrlen}};
+}
+
+inline auto io_uring_multiplexer::sendmsg(std::shared_ptr<socket_handle> socket,
+                                          std::span<const std::byte> buffer,
+                                          int flags, const ::sockaddr *address,
+                                          ::socklen_t addrlen) -> io_sender
+{
+  // The kernel never writes through the buffer or the address of a
+  // sendmsg, they are only stored as mutable to share the request type.
+  // NOLINTBEGIN(cppcoreguidelines-pro-type-const-cast)
+  return {this,
+          {.kind = request_kind::SENDMSG,
+           .socket = std::move(socket),
+           .buffer = {const_cast<std::byte *>(buffer.data()), buffer.size()},
+           .flags = flags,
+           .address = const_cast<::sockaddr *>(address),
+           .addrlen = addrlen}};
+  // NOLINTEND(cppcoreguidelines-pro-type-const-cast)
+}
+
+inline auto
+io_uring_multiplexer::accept(std::shared_ptr<socket_handle> socket) -> io_sender
+{
+  return {this, {.kind = request_kind::ACCEPT, .socket = std::move(socket)}};
+}
+
+inline auto io_uring_multiplexer::wait_for(interval_type interval) -> size_type
+{
+  static constexpr auto MSEC_PER_SEC = 1000;
+  static constexpr auto NSEC_PER_MSEC = 1000000LL;
+  owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+  unsigned pending = 0;
+  {
+    auto lock = std::lock_guard{mtx_};
+    pending = sq_.local_tail -
+              std::atomic_ref(*sq_.head).load(std::memory_order_acquire);
+  }
+
+  const bool ready =
+      std::atomic_ref(*cq_.tail).load(std::memory_order_acquire) !=
+      *cq_.head;
+  const unsigned wait = (interval == 0 || ready) ? 0 : 1;
+
+  // Every submission queued since the last iteration is submitted by the
+  // same system call that waits for completions.
+  if (pending || wait)
+  {
+    auto timeout = ::__kernel_timespec{
+        .tv_sec = interval / MSEC_PER_SEC,
+        .tv_nsec = (interval % MSEC_PER_SEC) * NSEC_PER_MSEC};
+    auto arg = ::io_uring_getevents_arg{};
+    if (interval >= 0)
+      arg.ts = reinterpret_cast<std::uint64_t>(&timeout);
+
+    enter_(pending, wait, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+           sizeof(arg));
+  }
+
+  return reap_();
+}
+
+inline auto
+io_uring_multiplexer::submit_(const operation_base *op,
+                              const ::io_uring_sqe &sqe) noexcept -> int
+{
+  auto lock = std::lock_guard{mtx_};
+  if (op->stop_requested(op))
+    return ECANCELED;
+
+  return push_(sqe);
+}
+
+inline auto
+io_uring_multiplexer::cancel_(const operation_base *op) noexcept -> void
+{
+  auto sqe = ::io_uring_sqe{};
+  sqe.opcode = IORING_OP_ASYNC_CANCEL;
+  sqe.fd = -1;
+  sqe.addr = reinterpret_cast<std::uint64_t>(op);
+
+  // A cancellation that can't be queued is dropped, and the operation
+  // completes normally instead.
+  auto lock = std::lock_guard{mtx_};
+  static_cast<void>(push_(sqe));
+}
+
+inline auto io_uring_multiplexer::push_(const ::io_uring_sqe &sqe) noexcept
+    -> int
+{
+  auto head = std::atomic_ref(*sq_.head);
+  if (sq_.local_tail - head.load(std::memory_order_acquire) >= sq_.entries)
+  {
+    if (auto error = flush_())
+      return error;
+
+    if (sq_.local_tail - head.load(std::memory_order_acquire) >= sq_.entries)
+      return EBUSY;
+  }
+
+  const auto index = sq_.local_tail & sq_.mask;
+  sq_.sqes[index] = sqe;
+  sq_.array[index] = index;
+  std::atomic_ref(*sq_.tail).store(++sq_.local_tail,
+                                   std::memory_order_release);
+
+  // The submission is already queued, so if it can't be submitted now the
+  // next wait_for() submits it.
+  if (owner_.load(std::memory_order_relaxed) != std::this_thread::get_id())
+    static_cast<void>(flush_());
+
+  return 0;
+}
+
+inline auto io_uring_multiplexer::flush_() noexcept -> int
+{
+  auto error = 0;
+  for (auto attempt = 0; attempt < FLUSH_ATTEMPTS; ++attempt)
+  {
+    const auto pending =
+        sq_.local_tail -
+        std::atomic_ref(*sq_.head).load(std::memory_order_acquire);
+    if (!pending || enter_(pending, 0, 0, nullptr, 0) >= 0)
+      return 0;
+
+    error = errno;
+    if (error != EINTR && error != EBUSY && error != EAGAIN)
+      return error;
+
+    // The completion queue is overflowing. Asking for events moves the
+    // overflowed completions into the queue as the event loop reaps it,
+    // which lets the kernel accept submissions again.
+    if (error == EBUSY)
+      enter_(0, 0, IORING_ENTER_GETEVENTS, nullptr, 0);
+  }
+
+  return error;
+}
+
+inline auto io_uring_multiplexer::reap_() noexcept -> size_type
+{
+  auto head = std::atomic_ref(*cq_.head);
+  auto current = head.load(std::memory_order_relaxed);
+  const auto tail =
+      std::atomic_ref(*cq_.tail).load(std::memory_order_acquire);
+
+  size_type count = 0;
+  while (current != tail)
+  {
+    // The cqe is copied out and the slot released before completing the
+    // operation, since completions may queue more work.
+    const auto cqe = cq_.cqes[current & cq_.mask];
+    head.store(++current, std::memory_order_release);
+
+    if (auto *op = reinterpret_cast<operation_base *>(cqe.user_data))
+    {
+      op->complete(op, cqe.res);
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+inline auto io_uring_multiplexer::enter_(unsigned to_submit,
+                                         unsigned min_complete, unsigned flags,
+                                         const void *arg,
+                                         std::size_t argsz) const noexcept
+    -> int
+{
+  return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+                                    min_complete, flags, arg, argsz));
+}
+
+inline auto io_uring_multiplexer::release_() noexcept -> void
+{
+  for (auto &mapping : mappings_)
+  {
+    if (!mapping.empty())
+      ::munmap(mapping.data(), mapping.size());
+    mapping = {};
+  }
+
+  if (ring_fd_ >= 0)
+    ::close(std::exchange(ring_fd_, -1));
+}
+
+inline io_uring_multiplexer::~io_uring_multiplexer() { release_(); }
+
+} // namespace net::execution
+#endif // CPPNET_IO_URING_MULTIPLEXER_IMPL_HPP
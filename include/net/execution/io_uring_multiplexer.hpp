@@ -0,0 +1,300 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file io_uring_multiplexer.hpp
+ * @brief This file declares an io_uring based io multiplexer.
+ */
+#pragma once
+#ifndef CPPNET_IO_URING_MULTIPLEXER_HPP
+#define CPPNET_IO_URING_MULTIPLEXER_HPP
+#include "net/detail/immovable.hpp"
+
+#include <io/io.hpp>
+#include <linux/io_uring.h>
+#include <stdexec/execution.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+/** @brief This namespace is for cppnet execution backends. */
+namespace net::execution {
+/**
+ * @brief An io_uring based multiplexer.
+ * @details io_uring_multiplexer is a completion based drop-in replacement
+ * for `io::execution::poll_multiplexer`. Generic readiness operations are
+ * submitted as `IORING_OP_POLL_ADD` requests, while `recvmsg()`, `sendmsg()`
+ * and `accept()` are submitted to the kernel directly and complete from the
+ * completion queue without a separate readiness wait. Submissions made on
+ * the event loop thread are batched, and are all submitted by the single
+ * `io_uring_enter` call made by each `wait_for()`. Submissions made from any
+ * other thread are submitted immediately, so operations should be started
+ * from the thread that runs the event loop wherever possible.
+ * @note Requires Linux 5.11 or later (`IORING_FEAT_EXT_ARG`).
+ * @code
+ * using context = basic_async_context<net::execution::io_uring_multiplexer>;
+ * @endcode
+ */
+class io_uring_multiplexer : net::detail::immovable {
+public:
+  /** @brief The multiplexer event type. */
+  using event_type = ::io_uring_cqe;
+  /** @brief The wait interval type (milliseconds). */
+  using interval_type = int;
+  /** @brief The size type. */
+  using size_type = std::size_t;
+  /** @brief The native socket type. */
+  using socket_type = io::socket::native_socket_type;
+  /** @brief The socket handle type. */
+  using socket_handle = io::socket::socket_handle;
+  /** @brief The execution trigger type. */
+  using trigger = io::execution::execution_trigger;
+
+  /**
+   * @brief A trigger that only waits for a socket error or a hangup. A
+   * socket with unread data is always readable, so this is how the socket
+   * error queue is waited on.
+   */
+  static constexpr auto ERRORS = static_cast<trigger>(
+      std::numeric_limits<std::underlying_type_t<trigger>>::max());
+
+  /** @brief The default number of submission queue entries. */
+  static constexpr unsigned DEFAULT_ENTRIES = 256;
+  /** @brief The most io_uring_enter attempts made by one flush. */
+  static constexpr int FLUSH_ATTEMPTS = 4;
+
+  /**
+   * @brief A sender that completes when a socket is ready and the supplied
+   * function has been executed without blocking.
+   * @tparam Fn A callable that returns a signed integral. A negative return
+   * value indicates failure, and the error is read from errno.
+   */
+  template <typename Fn> class sender;
+  /**
+   * @brief A sender for an io request that is submitted directly to the
+   * ring. It completes with the (non-negative) result of the request.
+   */
+  class io_sender;
+
+  /**
+   * @brief Sets up the ring.
+   * @param entries The number of submission queue entries.
+   * @throws std::system_error if the ring can't be set up.
+   */
+  explicit io_uring_multiplexer(unsigned entries = DEFAULT_ENTRIES);
+
+  /**
+   * @brief Returns a sender that executes `exec` when `socket` is ready for
+   * `event`.
+   * @tparam Fn The function type.
+   * @param socket The socket to wait on.
+   * @param event The execution trigger to wait for.
+   * @param exec The function to run once the socket is ready.
+   * @returns A sender that completes with the result of `exec`.
+   */
+  template <typename Fn>
+    requires std::is_invocable_v<Fn &>
+  auto set(std::shared_ptr<socket_handle> socket, trigger event,
+           Fn &&exec) -> sender<std::decay_t<Fn>>;
+
+  /**
+   * @brief Submits a recvmsg directly to the ring.
+   * @param socket The socket to read from.
+   * @param buffer The buffer to read into. Must outlive the operation.
+   * @param flags The recvmsg flags.
+   * @param address Storage for the peer address, or nullptr.
+   * @param addrlen On input, the size of the address storage. On
+   * completion, the size of the peer address that the kernel wrote. May be
+   * nullptr if address is nullptr. Must outlive the operation.
+   * @returns A sender that completes with the number of bytes read.
+   */
+  auto recvmsg(std::shared_ptr<socket_handle> socket,
+               std::span<std::byte> buffer, int flags,
+               ::sockaddr *address = nullptr,
+               ::socklen_t *addrlen = nullptr) -> io_sender;
+
+  /**
+   * @brief Submits a sendmsg directly to the ring.
+   * @param socket The socket to write to.
+   * @param buffer The bytes to send. Must outlive the operation.
+   * @param flags The sendmsg flags.
+   * @param address The destination address, or nullptr.
+   * @param addrlen The size of the destination address.
+   * @returns A sender that completes with the number of bytes sent.
+   */
+  auto sendmsg(std::shared_ptr<socket_handle> socket,
+               std::span<const std::byte> buffer, int flags,
+               const ::sockaddr *address = nullptr,
+               ::socklen_t addrlen = 0) -> io_sender;
+
+  /**
+   * @brief Submits an accept directly to the ring.
+   * @details Accepted sockets are created with `SOCK_NONBLOCK` and
+   * `SOCK_CLOEXEC`.
+   * @param socket The listening socket.
+   * @returns A sender that completes with the accepted native socket.
+   */
+  auto accept(std::shared_ptr<socket_handle> socket) -> io_sender;
+
+  /**
+   * @brief Submits all queued requests and completes any finished ones.
+   * @param interval The maximum time in milliseconds to block for. A
+   * negative interval blocks indefinitely.
+   * @returns The number of completions that were handled.
+   */
+  auto wait_for(interval_type interval) -> size_type;
+
+  /** @brief Tears down the ring. */
+  ~io_uring_multiplexer();
+
+private:
+  /** @brief Type-erased base of all submitted operations. */
+  struct operation_base {
+    /** @brief Completion function type. */
+    using complete_fn = auto(operation_base *, int) noexcept -> void;
+    /** @brief Stop requested function type. */
+    using stop_requested_fn = auto(const operation_base *) noexcept -> bool;
+
+    /** @brief Completes the operation with the result of a cqe. */
+    complete_fn *complete = nullptr;
+    /** @brief Returns true if a stop has been requested. */
+    stop_requested_fn *stop_requested = nullptr;
+  };
+
+  /** @brief The kinds of request that an io_sender can submit. */
+  enum class request_kind : std::uint8_t { RECVMSG, SENDMSG, ACCEPT };
+
+  /** @brief A direct io request. */
+  struct request {
+    /** @brief The request kind. */
+    request_kind kind{};
+    /** @brief The socket. */
+    std::shared_ptr<socket_handle> socket;
+    /** @brief The data buffer. */
+    std::span<std::byte> buffer;
+    /** @brief The message flags. */
+    int flags = 0;
+    /** @brief The peer address. */
+    ::sockaddr *address = nullptr;
+    /** @brief The peer address length. */
+    ::socklen_t addrlen = 0;
+    /** @brief Receives the length of the peer address of a recvmsg. */
+    ::socklen_t *addrlen_out = nullptr;
+  };
+
+  template <typename Fn, typename Receiver> class poll_operation;
+  template <typename Receiver> class io_operation;
+
+  /**
+   * @brief Queues a submission for an operation unless a stop has been
+   * requested for it.
+   * @details The stop check and the queueing happen under the same lock
+   * that `cancel_()` takes, so a cancellation can never be queued ahead of
+   * the submission it is meant to cancel.
+   * @param op The operation.
+   * @param sqe The submission.
+   * @returns 0 if the submission was queued, `ECANCELED` if a stop was
+   * requested, or the errno value that prevented the submission.
+   */
+  auto submit_(const operation_base *op,
+               const ::io_uring_sqe &sqe) noexcept -> int;
+  /**
+   * @brief Queues an asynchronous cancellation of an operation.
+   * @param op The operation to cancel.
+   */
+  auto cancel_(const operation_base *op) noexcept -> void;
+  /**
+   * @brief Copies a submission into the submission queue. Submissions made
+   * from threads other than the event loop are submitted immediately. Must
+   * be called while holding the lock.
+   * @param sqe The submission to queue.
+   * @returns 0 if the submission was queued, or the errno value of the
+   * `io_uring_enter` that failed to make room for it.
+   */
+  auto push_(const ::io_uring_sqe &sqe) noexcept -> int;
+  /**
+   * @brief Submits every queued submission. Must be called while holding
+   * the lock.
+   * @details A kernel that is busy with an overflowing completion queue is
+   * asked to flush its overflow and retried a bounded number of times.
+   * @returns 0 on success, otherwise the errno value of io_uring_enter.
+   */
+  auto flush_() noexcept -> int;
+  /**
+   * @brief Completes every operation in the completion queue.
+   * @returns The number of operations completed.
+   */
+  auto reap_() noexcept -> size_type;
+  /**
+   * @brief Calls io_uring_enter.
+   * @returns The result of the system call.
+   */
+  auto enter_(unsigned to_submit, unsigned min_complete, unsigned flags,
+              const void *arg, std::size_t argsz) const noexcept -> int;
+  /** @brief Unmaps the rings and closes the ring file descriptor. */
+  auto release_() noexcept -> void;
+
+  /** @brief Submission queue pointers. */
+  struct {
+    /** @brief The kernel consumer head. */
+    unsigned *head = nullptr;
+    /** @brief The producer tail. */
+    unsigned *tail = nullptr;
+    /** @brief The ring mask. */
+    unsigned mask = 0;
+    /** @brief The number of entries. */
+    unsigned entries = 0;
+    /** @brief The index array. */
+    unsigned *array = nullptr;
+    /** @brief The submission queue entries. */
+    ::io_uring_sqe *sqes = nullptr;
+    /** @brief The locally cached tail. */
+    unsigned local_tail = 0;
+  } sq_;
+
+  /** @brief Completion queue pointers. */
+  struct {
+    /** @brief The consumer head. */
+    unsigned *head = nullptr;
+    /** @brief The kernel producer tail. */
+    unsigned *tail = nullptr;
+    /** @brief The ring mask. */
+    unsigned mask = 0;
+    /** @brief The completion queue entries. */
+    ::io_uring_cqe *cqes = nullptr;
+  } cq_;
+
+  /** @brief The mapped ring regions. */
+  std::array<std::span<std::byte>, 3> mappings_{};
+  /** @brief The thread that last called wait_for. */
+  std::atomic<std::thread::id> owner_;
+  /** @brief Mutex that guards the submission queue. */
+  std::mutex mtx_;
+  /** @brief The ring file descriptor. */
+  int ring_fd_{-1};
+};
+
+} // namespace net::execution
+
+#include "impl/io_uring_multiplexer_impl.hpp" // IWYU pragma: export
+
+#endif // CPPNET_IO_URING_MULTIPLEXER_HPP
@@ -22,7 +22,9 @@
 #ifndef CPPNET_ASYNC_CONTEXT_HPP
 #define CPPNET_ASYNC_CONTEXT_HPP
 #include "net/detail/immovable.hpp"
+#include "net/detail/mpsc_queue.hpp"
 #include "net/timers/timers.hpp"
+#include "net/timers/timing_wheel.hpp"
 
 #include <exec/async_scope.hpp>
 #include <io/io.hpp>
@@ -32,33 +34,55 @@
 /** @brief This namespace is for network services. */
 namespace net::service {
 
-/** @brief An asynchronous execution context. */
-struct async_context : detail::immovable {
+/**
+ * @brief Signals and states that are shared by every asynchronous context
+ * type.
+ */
+struct async_context_base {
+  /** @brief An enum of all valid async context signals. */
+  enum signals : std::uint8_t { terminate = 0, user1, END };
+  /** @brief An enum of valid context states. */
+  enum context_states : std::uint8_t { PENDING = 0, STARTED, STOPPED };
+};
+
+/**
+ * @brief An asynchronous execution context.
+ * @tparam Multiplexer The io multiplexer that drives the event loop. The
+ * default is `io::execution::poll_multiplexer`, services with many idle
+ * connections should prefer `net::execution::epoll_multiplexer`.
+ * @tparam Timers The event loop timers engine. The default is the binary
+ * heap backed `timers::timers`, contexts that arm and cancel large numbers
+ * of timers should prefer `timers::timing_wheel`.
+ */
+template <typename Multiplexer = io::execution::poll_multiplexer,
+          typename Timers =
+              timers::timers<timers::default_interrupt_source_t>>
+struct basic_async_context : async_context_base, detail::immovable {
   /** @brief Asynchronous scope type. */
   using async_scope = exec::async_scope;
   /** @brief The io multiplexer type. */
-  using multiplexer_type = io::execution::poll_multiplexer;
+  using multiplexer_type = Multiplexer;
   /** @brief The io triggers type. */
   using triggers = io::execution::basic_triggers<multiplexer_type>;
   /** @brief The socket dialog type. */
-  using socket_dialog = triggers::socket_dialog;
+  using socket_dialog = typename triggers::socket_dialog;
   /** @brief The socket type. */
   using socket_type = io::socket::native_socket_type;
   /** @brief The signal mask type. */
   using signal_mask = std::uint64_t;
-  /** @brief Interrupt source type. */
-  using interrupt_source = timers::socketpair_interrupt_source_t;
   /** @brief The timers type. */
-  using timers_type = timers::timers<interrupt_source>;
+  using timers_type = Timers;
+  /** @brief Interrupt source type. */
+  using interrupt_source = typename timers_type::interrupt_source_t;
   /** @brief The clock type. */
   using clock = std::chrono::steady_clock;
   /** @brief The duration type. */
   using duration = std::chrono::milliseconds;
-
-  /** @brief An enum of all valid async context signals. */
-  enum signals : std::uint8_t { terminate = 0, user1, END };
-  /** @brief An enum of valid context states. */
-  enum context_states : std::uint8_t { PENDING = 0, STARTED, STOPPED };
+  /**
+   * @brief A stdexec scheduler that completes on the thread that runs the
+   * event loop.
+   */
+  class scheduler;
 
   /** @brief The event loop timers. */
   timers_type timers;
@@ -70,29 +94,37 @@ struct async_context : detail::immovable {
   std::atomic<signal_mask> sigmask;
   /** @brief A counter that tracks the context state. */
   std::atomic<context_states> state{PENDING};
+  /**
+   * @brief Services set SO_REUSEPORT on their socket if true, so that the
+   * services of several contexts can bind the same address. Must be set
+   * before the service is started.
+   */
+  bool reuse_port{false};
 
   /**
    * @brief Sets the signal mask, then interrupts the service.
    * @param signum The signal to send. Must be in range of
    *               enum signals.
    */
-  inline auto signal(int signum) -> void;
+  auto signal(int signum) -> void;
 
   /** @brief Calls the timers interrupt. */
-  inline auto interrupt() const noexcept -> void;
+  auto interrupt() const noexcept -> void;
 
   /**
    * @brief An interrupt service routine for the poller.
    * @details When invoked, `isr()` installs an event
-   * handler on socket events received on `socket`. The routine will be
-   * continuously re-installed in a loop until it returns false.
+   * handler on socket events received on `socket`. Pending interrupts are
+   * consumed with `interrupt_source::drain()` before the routine runs. The
+   * routine will be continuously re-installed in a loop until it returns
+   * false.
    * @tparam Fn A callable to run upon receiving an interrupt.
-   * @param socket The listening socket for interrupts. Its lifetime is
+   * @param socket The listener of the interrupt source. Its lifetime is
    * tied to the lifetime of `routine`.
    * @param routine The routine to run upon receiving a poll interrupt on
    * `socket`.
    * @code
-   * isr(poller.emplace(sockets[0]), [&]() noexcept {
+   * isr(poller.emplace(timers.listener()), [&]() noexcept {
    *   auto sigmask_ = sigmask.exchange(0);
    *   for (int signum = 0; auto mask = (sigmask_ >> signum); ++signum)
    *   {
@@ -107,10 +139,130 @@ struct async_context : detail::immovable {
     requires std::is_invocable_r_v<bool, Fn>
   auto isr(const socket_dialog &socket, Fn routine) -> void;
 
-  /** @brief Runs the event loop. */
-  inline auto run() -> void;
+  /**
+   * @brief Returns a scheduler for this context.
+   * @details Work scheduled on the returned scheduler from any thread runs
+   * on the thread that runs the event loop. Scheduling neither takes a lock
+   * nor allocates: the operation state is linked into a lock-free queue
+   * that `run()` drains on every iteration.
+   * @code
+   * sender auto reply = schedule(ctx.get_scheduler()) |
+   *                     then([&] { submit_recv(ctx, socket, rctx); });
+   * @endcode
+   */
+  auto get_scheduler() noexcept -> scheduler;
+
+  /**
+   * @brief Runs a function on the thread that runs the event loop.
+   * @details `post()` is safe to call from any thread. It spawns the
+   * function into `scope` on `get_scheduler()`, so it is discarded if the
+   * scope has been stopped by the time the event loop reaches it.
+   * @tparam Fn The function type.
+   * @param func The function to run.
+   */
+  template <typename Fn>
+    requires std::is_invocable_v<Fn &>
+  auto post(Fn &&func) -> void;
+
+  /**
+   * @brief Runs the event loop.
+   * @details The poller waits with millisecond precision. Deadlines that
+   * are less than a millisecond away are waited for on a timerfd, so they
+   * are honoured to within the kernel timer slack instead of being rounded
+   * to a whole millisecond.
+   */
+  auto run() -> void;
+
+  /**
+   * @brief Destructor. Operations that were scheduled but never run are
+   * completed with `set_stopped`.
+   */
+  ~basic_async_context();
+
+private:
+  /** @brief The base of an operation that is scheduled on the context. */
+  struct posted_operation : net::detail::mpsc_node {
+    /** @brief Execute function type. */
+    using execute_fn = auto(posted_operation *, bool) noexcept -> void;
+
+    /**
+     * @brief Completes the operation. The second argument is true if the
+     * operation must complete with `set_stopped`.
+     */
+    execute_fn *execute = nullptr;
+  };
+
+  /**
+   * @brief Queues an operation and interrupts the event loop if the queue
+   * was empty.
+   * @param operation The operation to queue.
+   */
+  auto post_(posted_operation *operation) noexcept -> void;
+  /**
+   * @brief Runs every queued operation.
+   * @param stopped Completes every operation with `set_stopped` if true.
+   */
+  auto run_posted_(bool stopped = false) noexcept -> void;
+  /**
+   * @brief Computes the interval that the poller waits for before the next
+   * timer expires.
+   * @details Timeouts of a millisecond or more are rounded down, so the
+   * poller never wakes up late. Shorter timeouts arm a high resolution
+   * wakeup with `arm_wakeup_()` and wait for at most one millisecond, so
+   * the event loop neither wakes up late nor spins on zero timeouts.
+   * @param timeout The time until the next timer expires, or a negative
+   * duration if no timer is armed.
+   * @returns The poller wait interval in milliseconds.
+   */
+  auto wait_interval_(timers::duration timeout) -> int;
+  /**
+   * @brief Arms a timerfd that wakes the poller after `timeout`.
+   * @details The timerfd is created and registered with the poller by the
+   * first wakeup. It stays registered until the scope is stopped, so every
+   * later wakeup only re-arms it with `timerfd_settime()`.
+   * @param timeout The time until the wakeup.
+   * @returns false if a high resolution wakeup isn't available.
+   */
+  auto arm_wakeup_(timers::duration timeout) -> bool;
+  /**
+   * @brief Waits for the wakeup timerfd to expire, then waits again until
+   * the scope is stopped.
+   * @param socket The wakeup timerfd.
+   */
+  auto wait_wakeup_(const socket_dialog &socket) -> void;
+
+  /** @brief Operations that are waiting to run on the event loop. */
+  net::detail::mpsc_queue<posted_operation> posted_;
+  /** @brief The timerfd of the high resolution wakeup. */
+  std::weak_ptr<io::socket::socket_handle> wakeup_;
+};
+
+/** @brief The default asynchronous execution context. */
+using async_context = basic_async_context<>;
+
+/**
+ * @brief Selects the asynchronous context type that a service runs on.
+ * @details Services that export an `async_context` member type run on that
+ * context type, all other services run on the default `async_context`.
+ * @tparam Service The service type.
+ */
+template <typename Service> struct context_of {
+  /** @brief The context type. */
+  using type = async_context;
 };
 
+/** @brief Specialization for services that export an async_context type. */
+template <typename Service>
+  requires requires { typename Service::async_context; }
+struct context_of<Service> {
+  /** @brief The context type. */
+  using type = typename Service::async_context;
+};
+
+/** @brief The asynchronous context type that a service runs on. */
+template <typename Service>
+using context_of_t = typename context_of<Service>::type;
+
 } // namespace net::service
 
 #include "impl/async_context_impl.hpp" // IWYU pragma: export
@@ -0,0 +1,290 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file async_tcp_client.hpp
+ * @brief This file declares an asynchronous tcp client.
+ */
+#pragma once
+#ifndef CPPNET_ASYNC_TCP_CLIENT_HPP
+#define CPPNET_ASYNC_TCP_CLIENT_HPP
+#include "async_context.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <netinet/in.h>
+/** @brief This namespace is for network services. */
+namespace net::service {
+/**
+ * @brief A sender that connects a TCP socket without blocking.
+ * @details The socket is opened in non-blocking mode and connected, and
+ * the sender then waits for it to become writable through the context's
+ * poller. With a connect timeout, a timer on the context's timers shuts
+ * the socket down once the timeout expires.
+ *
+ * The sender completes with the connected socket dialog. It completes with
+ * an errno value if the connection fails, and with `ETIMEDOUT` if the
+ * timeout expires first. A sender that is constructed from a socket dialog
+ * completes with that dialog immediately, which is how pooled connections
+ * are handed out. The sender must be started on the thread that runs its
+ * context.
+ * @tparam AsyncContext The asynchronous context type.
+ */
+template <typename AsyncContext> class connect_sender {
+  template <typename Receiver> class operation;
+
+public:
+  /** @brief The asynchronous context type. */
+  using async_context = AsyncContext;
+  /** @brief The socket dialog type. */
+  using socket_dialog = typename async_context::socket_dialog;
+  /** @brief The socket address type. */
+  using socket_address = io::socket::socket_address<sockaddr_in6>;
+  /** @brief The sender concept. */
+  using sender_concept = stdexec::sender_t;
+  /** @brief The completion signatures. */
+  using completion_signatures =
+      stdexec::completion_signatures<stdexec::set_value_t(socket_dialog),
+                                     stdexec::set_error_t(int),
+                                     stdexec::set_stopped_t()>;
+
+  /** @brief Options for new connections. */
+  struct options_type {
+    /** @brief Fails the connect after this long. 0 waits indefinitely. */
+    std::chrono::milliseconds timeout{0};
+    /** @brief Sets TCP_NODELAY on the socket if true. */
+    bool nodelay = true;
+  };
+
+  /**
+   * @brief Constructs a sender that opens a new connection.
+   * @param ctx The context to connect on.
+   * @param address The address to connect to.
+   * @param options The connection options.
+   */
+  connect_sender(async_context &ctx, const socket_address &address,
+                 options_type options) noexcept;
+  /**
+   * @brief Constructs a sender that completes with a connected socket.
+   * @param socket The connected socket.
+   */
+  explicit connect_sender(socket_dialog socket) noexcept;
+
+  /**
+   * @brief Connects the sender to a receiver.
+   * @tparam Receiver The receiver type.
+   * @param receiver The receiver.
+   * @returns The operation state.
+   */
+  template <stdexec::receiver Receiver>
+  auto connect(Receiver receiver) && -> operation<Receiver>;
+
+private:
+  /** @brief The context, or null if the socket is already connected. */
+  async_context *ctx_ = nullptr;
+  /** @brief The address to connect to. */
+  socket_address address_;
+  /** @brief The connection options. */
+  options_type options_;
+  /** @brief The connected socket. */
+  socket_dialog socket_;
+};
+
+/**
+ * @brief An asynchronous TCP client with a pool of keep-alive connections.
+ * @details `checkout()` hands out an idle connection to the destination if
+ * the pool has one, and otherwise connects a new one. `checkin()` returns
+ * a connection to the pool once its request is done, so the next request
+ * to the same destination skips the handshake. Destinations are keyed on
+ * their address family, address, port and scope.
+ *
+ * Idle connections are checked with a non-blocking `MSG_PEEK` before they
+ * are handed out. Connections that the peer closed, or that have unread
+ * bytes, are dropped. A client must only be used on the thread that runs
+ * its context, but its counters can be read from any thread.
+ * @code
+ * sender auto request =
+ *     client.checkout(ctx, address) |
+ *     let_value([&](const socket_dialog &socket) {
+ *       return io::sendmsg(socket, msg, 0) | then([&, socket](auto) {
+ *                // Read the response, then:
+ *                client.checkin(address, socket);
+ *              });
+ *     });
+ * ctx.scope.spawn(std::move(request));
+ * @endcode
+ * @tparam Multiplexer The io multiplexer of the async context that the
+ * client runs on.
+ * @tparam Timers The timers engine of the async context that the client
+ * runs on.
+ */
+template <typename Multiplexer = async_context::multiplexer_type,
+          typename Timers = async_context::timers_type>
+class async_tcp_client {
+public:
+  /** @brief Templated socket address type. */
+  template <typename T> using socket_address = io::socket::socket_address<T>;
+  /** @brief The async context type. */
+  using async_context = basic_async_context<Multiplexer, Timers>;
+  /** @brief The socket dialog type. */
+  using socket_dialog = io::socket::socket_dialog<Multiplexer>;
+  /** @brief The connect sender type. */
+  using sender_type = connect_sender<async_context>;
+
+  /** @brief Client options. */
+  struct options_type {
+    /** @brief The options for new connections. */
+    typename sender_type::options_type connect{};
+    /** @brief The most idle connections that are kept per destination. */
+    std::size_t max_idle = DEFAULT_MAX_IDLE;
+  };
+
+  /** @brief The connection pool counters. */
+  struct pool_stats {
+    /** @brief The checkouts that reused an idle connection. */
+    std::size_t hits = 0;
+    /** @brief The checkouts that opened a new connection. */
+    std::size_t misses = 0;
+    /** @brief The idle connections in the pool. */
+    std::size_t idle = 0;
+    /** @brief The connections that were closed instead of pooled. */
+    std::size_t discarded = 0;
+
+    /** @returns The fraction of checkouts that reused a connection. */
+    [[nodiscard]] auto hit_rate() const noexcept -> double;
+  };
+
+  /**
+   * @brief Constructor.
+   * @param options The client options.
+   */
+  explicit async_tcp_client(options_type options = {}) noexcept;
+  /** @brief Deleted copy constructor. */
+  async_tcp_client(const async_tcp_client &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const async_tcp_client &) -> async_tcp_client & = delete;
+
+  /**
+   * @brief Opens a new connection that bypasses the pool.
+   * @tparam T The socket address type.
+   * @param ctx The context to connect on.
+   * @param address The address to connect to.
+   * @returns A connect_sender.
+   */
+  template <typename T>
+  auto connect(async_context &ctx, const socket_address<T> &address) const
+      -> sender_type;
+  /**
+   * @brief Checks out a connection to a destination.
+   * @tparam T The socket address type.
+   * @param ctx The context to connect on.
+   * @param address The destination address.
+   * @returns A connect_sender that completes with an idle connection from
+   * the pool, or with a new connection.
+   */
+  template <typename T>
+  auto checkout(async_context &ctx, const socket_address<T> &address)
+      -> sender_type;
+  /**
+   * @brief Returns a connection to the pool.
+   * @details Only connections whose last response was read in full may be
+   * returned. A connection that failed must be dropped instead. The
+   * connection is closed if the destination already has `max_idle` idle
+   * connections.
+   * @tparam T The socket address type.
+   * @param address The destination address.
+   * @param socket The connection.
+   */
+  template <typename T>
+  auto checkin(const socket_address<T> &address, socket_dialog socket)
+      -> void;
+  /** @brief Closes every idle connection. */
+  auto clear() -> void;
+  /**
+   * @brief Reads the connection pool counters.
+   * @details The counters can be read from any thread.
+   * @returns A snapshot of the counters.
+   */
+  [[nodiscard]] auto stats() const noexcept -> pool_stats;
+
+  /** @brief Default destructor. */
+  ~async_tcp_client() = default;
+
+  /** @brief The default most idle connections per destination. */
+  static constexpr std::size_t DEFAULT_MAX_IDLE = 16;
+
+private:
+  /** @brief A normalized destination address. */
+  struct destination {
+    /** @brief The IPv4 or IPv6 address bytes. */
+    std::array<std::uint8_t, sizeof(in6_addr)> addr{};
+    /** @brief The IPv6 scope id. */
+    std::uint32_t scope = 0;
+    /** @brief The port in network byte order. */
+    std::uint16_t port = 0;
+    /** @brief The address family. */
+    sa_family_t family = 0;
+
+    /** @brief Destinations compare equal if every field is equal. */
+    auto operator==(const destination &) const noexcept -> bool = default;
+  };
+
+  /** @brief Hashes a destination. */
+  struct destination_hash {
+    /** @returns The hash of the destination. */
+    auto operator()(const destination &dest) const noexcept -> std::size_t;
+  };
+
+  /**
+   * @param address A socket address.
+   * @returns The destination of the address.
+   */
+  static auto key_(const socket_address<sockaddr_in6> &address) noexcept
+      -> destination;
+  /**
+   * @param socket An idle connection.
+   * @returns true if the connection is open and has no unread bytes.
+   */
+  static auto alive_(const socket_dialog &socket) noexcept -> bool;
+
+  /** @brief The client options. */
+  options_type options_;
+  /** @brief The idle connections of every destination. */
+  std::unordered_map<destination, std::vector<socket_dialog>,
+                     destination_hash>
+      idle_;
+  /** @brief The number of checkouts that reused a connection. */
+  std::atomic<std::size_t> hits_{0};
+  /** @brief The number of checkouts that opened a connection. */
+  std::atomic<std::size_t> misses_{0};
+  /** @brief The number of idle connections. */
+  std::atomic<std::size_t> idle_count_{0};
+  /** @brief The number of connections closed instead of pooled. */
+  std::atomic<std::size_t> discarded_{0};
+};
+
+} // namespace net::service
+
+#include "impl/async_tcp_client_impl.hpp" // IWYU pragma: export
+
+#endif // CPPNET_ASYNC_TCP_CLIENT_HPP
@@ -21,12 +21,24 @@
 #ifndef CPPNET_ASYNC_TCP_SERVICE_HPP
 #define CPPNET_ASYNC_TCP_SERVICE_HPP
 #include "async_context.hpp"
+#include "write_queue.hpp"
+#include "zerocopy.hpp"
+#include "net/detail/buffer_pool.hpp"
+#include "net/detail/slab_pool.hpp"
+
+#include <chrono>
+#include <vector>
 namespace net::service {
 /**
  * @brief A ServiceLike Async TCP Service.
  * @tparam StreamHandler The StreamHandler type that derives from
  * async_tcp_service.
- * @tparam Size The socket read buffer size. (Default 64KiB).
+ * @tparam Size The socket read buffer size. (Default 64KiB). With adaptive
+ * read buffers this is the largest read buffer size.
+ * @tparam Multiplexer The io multiplexer of the async context that the
+ * service runs on.
+ * @tparam Timers The timers engine of the async context that the service
+ * runs on.
  * @note The default constructor of async_tcp_service is protected
  * so async_tcp_service can't be constructed without a stream handler
  * (which would be UB).
@@ -71,37 +83,215 @@ namespace net::service {
  * @endcode
  */
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
-template <typename TCPStreamHandler, std::size_t Size = 64 * 1024UL>
+template <typename TCPStreamHandler, std::size_t Size = 64 * 1024UL,
+          typename Multiplexer = async_context::multiplexer_type,
+          typename Timers = async_context::timers_type>
 class async_tcp_service {
 public:
   /** @brief Templated socket address type. */
   template <typename T> using socket_address = io::socket::socket_address<T>;
   /** @brief The async context type. */
-  using async_context = service::async_context;
+  using async_context = basic_async_context<Multiplexer, Timers>;
   /** @brief The async scope type. */
-  using async_scope = async_context::async_scope;
+  using async_scope = typename async_context::async_scope;
   /** @brief The io multiplexer type. */
-  using multiplexer_type = async_context::multiplexer_type;
+  using multiplexer_type = Multiplexer;
   /** @brief The socket handle type. */
   using socket_handle = io::socket::socket_handle;
   /** @brief The socket dialog type. */
   using socket_dialog = io::socket::socket_dialog<multiplexer_type>;
   /** @brief Re-export the async_context signals. */
-  using enum async_context::signals;
+  using enum async_context_base::signals;
+  /** @brief The read context pool occupancy counters. */
+  using pool_stats = net::detail::slab_pool::stats_type;
+  /** @brief The read buffer pool occupancy counters. */
+  using buffer_stats = net::detail::buffer_pool::stats_type;
+  /** @brief The zero-copy send tracker type. */
+  using zerocopy_type = zerocopy_tracker<async_context>;
+  /** @brief The write queue type. */
+  using write_queue_type = write_queue<async_context>;
+
+  /** @brief Options that control how connections size their read buffers. */
+  struct read_buffer_options {
+    /**
+     * @brief Size read buffers adaptively if true. Each connection starts
+     * with a `min_size` buffer, which doubles whenever a read fills it and
+     * halves whenever a read uses less than a quarter of it. Readiness
+     * based multiplexers also return the buffer to the pool while the
+     * connection waits for data, so idle connections hold no buffer.
+     * Otherwise every connection holds a `Size` buffer until it closes.
+     */
+    bool adaptive = false;
+    /** @brief The smallest adaptive read buffer size. */
+    std::size_t min_size = 512;
+    /**
+     * @brief Sizes adaptive reads with FIONREAD if true, so a connection
+     * that receives a burst grows its buffer in one step.
+     */
+    bool use_fionread = true;
+  };
+
+  /** @brief TCP options for the listener and accepted connections. */
+  struct tcp_options {
+    /** @brief The listen backlog. */
+    int backlog = SOMAXCONN;
+    /**
+     * @brief Sets TCP_DEFER_ACCEPT on the listener to this many seconds if
+     * it is positive, so that connections are only accepted once the first
+     * data segment arrives.
+     */
+    int defer_accept = 0;
+    /**
+     * @brief Sets the server TCP_FASTOPEN queue length on the listener if
+     * it is positive.
+     */
+    int fastopen = 0;
+    /** @brief Sets TCP_NODELAY on every accepted connection if true. */
+    bool nodelay = false;
+  };
+
+  /**
+   * @brief Flow control options. Reads on a connection pause while it has
+   * too many bytes queued for sending. A high water mark of 0 disables the
+   * limit.
+   */
+  struct backpressure_options {
+    /**
+     * @brief Pauses reads on a connection once more than this many bytes
+     * are queued on its write queue.
+     */
+    std::size_t high_water = 0;
+    /** @brief Resumes reads once the write queue is back at this size. */
+    std::size_t low_water = 0;
+    /**
+     * @brief Pauses reads on every connection that submits a read while
+     * the write queues of the service hold more than this many bytes.
+     */
+    std::size_t service_high_water = 0;
+    /** @brief Resumes reads once the write queues are back at this size. */
+    std::size_t service_low_water = 0;
+  };
+
+  /** @brief The write queue occupancy counters. */
+  struct write_stats {
+    /** @brief The bytes queued on every write queue of the service. */
+    std::size_t queued = 0;
+    /** @brief The number of connections with paused reads. */
+    std::size_t paused = 0;
+  };
 
-  /** @brief A read context. */
+  /**
+   * @brief Connection deadlines. A connection that misses a deadline is
+   * shut down, which completes its pending read with end of file so the
+   * stream handler closes it and its buffers go back to the pools. A
+   * deadline of 0 is disabled.
+   */
+  struct timeout_options {
+    /**
+     * @brief Shuts down a connection once it has read nothing for this
+     * long. A connection whose reads are paused by backpressure keeps
+     * aging, so a peer that stops reading its responses is also reaped.
+     */
+    std::chrono::milliseconds idle{0};
+    /**
+     * @brief Shuts down a connection that hasn't called header_received()
+     * this long after it was accepted, however often it reads. This bounds
+     * how long a peer that trickles its request in can hold a connection.
+     */
+    std::chrono::milliseconds header{0};
+  };
+
+  /** @brief The connection deadline counters. */
+  struct reap_stats {
+    /** @brief The number of armed connection deadline timers. */
+    std::size_t tracked = 0;
+    /** @brief The number of connections that were shut down. */
+    std::size_t expired = 0;
+  };
+
+  /** @brief Service options. */
+  struct options_type {
+    /** @brief The read buffer options. */
+    read_buffer_options read_buffers{};
+    /**
+     * @brief The most connections to accept per readiness event. With a
+     * budget of 1 each accept waits for its own readiness event. Larger
+     * budgets drain the listen queue with non-blocking `accept4()` calls
+     * until it is empty or the budget is spent, and emit every accepted
+     * connection from the same completion.
+     */
+    std::size_t accept_budget = 1;
+    /** @brief The TCP options. */
+    tcp_options tcp{};
+    /** @brief The options of every connection's write queue. */
+    typename write_queue_type::options_type writes{};
+    /** @brief The flow control options. */
+    backpressure_options backpressure{};
+    /** @brief The connection deadlines. */
+    timeout_options timeouts{};
+  };
+
+  /**
+   * @brief A read context.
+   * @details Read contexts and their buffers are allocated from pools that
+   * belong to the service, and are returned to them when the last reference
+   * is dropped. The last reference must be dropped on the thread that runs
+   * the service's context.
+   */
   struct read_context {
-    /** @brief The read buffer type. */
-    using buffer_type = std::array<std::byte, Size>;
     /** @brief The socket message type. */
     using socket_message = io::socket::socket_message<>;
+    /** @brief The size type. */
+    using size_type = std::size_t;
+
+    /**
+     * @brief Constructor.
+     * @param pool The pool to take read buffers from.
+     * @param size The size of the first read buffer.
+     */
+    read_context(std::shared_ptr<net::detail::buffer_pool> pool,
+                 size_type size) noexcept;
+    /** @brief Deleted copy constructor. */
+    read_context(const read_context &) = delete;
+    /** @brief Deleted copy assignment. */
+    auto operator=(const read_context &) -> read_context & = delete;
 
-    /** @brief The read buffer. */
-    buffer_type read_buffer{};
-    /** @brief An assignable read buffer span. */
-    std::span<std::byte> buffer{read_buffer};
+    /**
+     * @brief Takes a buffer from the pool if the context has none.
+     * @param size The minimum size of the buffer.
+     */
+    auto reserve(size_type size) -> void;
+    /** @brief Returns the buffer to the pool. */
+    auto release() noexcept -> void;
+    /**
+     * @brief Adjusts `next_size` after a read.
+     * @param len The number of bytes that were read into `buffer`.
+     */
+    auto fit(size_type len) noexcept -> void;
+
+    /** @brief Returns the buffer to the pool. */
+    ~read_context();
+
+    /** @brief The read buffer, which is empty if the context has none. */
+    std::span<std::byte> buffer;
     /** @brief The read socket message. */
     socket_message msg{.buffers = buffer};
+    /** @brief The size of the next read buffer. */
+    size_type next_size;
+    /**
+     * @brief Tracks the zero-copy sends of the connection. It is created by
+     * the first call to send_zerocopy().
+     */
+    std::shared_ptr<zerocopy_type> zerocopy;
+    /**
+     * @brief The outbound queue of the connection. It is created by the
+     * first call to enqueue().
+     */
+    std::shared_ptr<write_queue_type> writes;
+
+  private:
+    /** @brief The buffer pool. */
+    std::shared_ptr<net::detail::buffer_pool> pool_;
   };
 
   /**
@@ -116,12 +306,84 @@ public:
   auto start(async_context &ctx) noexcept -> void;
   /**
    * @brief Submits an asynchronous socket recv.
+   * @details The read buffer may be returned to the pool or overwritten as
+   * soon as the recv is submitted, so the bytes from the previous read must
+   * not be used afterwards.
    * @param ctx The async context to start the reader on.
    * @param socket the socket to read data from.
    * @param rctx A shared pointer to a mutable read buffer.
    */
   auto submit_recv(async_context &ctx, const socket_dialog &socket,
                    std::shared_ptr<read_context> rctx) -> void;
+  /**
+   * @brief Sends a message on a connection without copying it.
+   * @details The buffers of the message must stay alive and unmodified
+   * until the returned sender completes. See zerocopy_tracker.
+   * @tparam Message The socket message type.
+   * @param ctx The async context that the connection runs on.
+   * @param socket The connection socket.
+   * @param rctx The read context of the connection.
+   * @param msg The message to send.
+   * @returns A sender that completes with the number of bytes sent once
+   * the kernel has released the message.
+   */
+  template <typename Message>
+  auto send_zerocopy(async_context &ctx, const socket_dialog &socket,
+                     const std::shared_ptr<read_context> &rctx, Message msg);
+  /**
+   * @brief Appends a buffer to the write queue of a connection.
+   * @details Buffers are sent in the order they are enqueued, and every
+   * buffer enqueued during one event loop iteration is sent by a single
+   * `sendmsg`. See write_queue.
+   * @param ctx The async context that the connection runs on.
+   * @param socket The connection socket.
+   * @param rctx The read context of the connection.
+   * @param buffer The buffer to send. The queue takes ownership of it.
+   */
+  auto enqueue(async_context &ctx, const socket_dialog &socket,
+               const std::shared_ptr<read_context> &rctx,
+               typename write_queue_type::buffer_type buffer) -> void;
+  /**
+   * @brief Appends a copy of a buffer to the write queue of a connection.
+   * @param ctx The async context that the connection runs on.
+   * @param socket The connection socket.
+   * @param rctx The read context of the connection.
+   * @param buffer The bytes to send.
+   */
+  auto enqueue(async_context &ctx, const socket_dialog &socket,
+               const std::shared_ptr<read_context> &rctx,
+               std::span<const std::byte> buffer) -> void;
+  /**
+   * @brief Clears the header deadline of a connection.
+   * @details Stream handlers call this once a connection has read a
+   * complete request header. Afterwards only the idle deadline applies.
+   * @param socket The connection socket.
+   */
+  auto header_received(const socket_dialog &socket) noexcept -> void;
+  /**
+   * @brief Reads the read context pool occupancy counters.
+   * @details The counters can be read from any thread.
+   * @returns A snapshot of the counters.
+   */
+  [[nodiscard]] auto read_pool_stats() const noexcept -> pool_stats;
+  /**
+   * @brief Reads the read buffer pool occupancy counters.
+   * @details The counters can be read from any thread.
+   * @returns A snapshot of the counters.
+   */
+  [[nodiscard]] auto read_buffer_stats() const noexcept -> buffer_stats;
+  /**
+   * @brief Reads the write queue occupancy counters.
+   * @details The counters can be read from any thread.
+   * @returns A snapshot of the counters.
+   */
+  [[nodiscard]] auto write_queue_stats() const noexcept -> write_stats;
+  /**
+   * @brief Reads the connection deadline counters.
+   * @details The counters can be read from any thread.
+   * @returns A snapshot of the counters.
+   */
+  [[nodiscard]] auto reaper_stats() const noexcept -> reap_stats;
 
 protected:
   /** @brief Default constructor. */
@@ -133,17 +395,145 @@ protected:
    */
   template <typename T>
   explicit async_tcp_service(socket_address<T> address) noexcept;
+  /**
+   * @brief Socket address and options constructor.
+   * @tparam T The socket address type.
+   * @param address The service address to bind.
+   * @param options The service options.
+   */
+  template <typename T>
+  async_tcp_service(socket_address<T> address, options_type options);
 
 private:
   /** @brief The native socket type. */
   using socket_type = io::socket::native_socket_type;
 
+  /** @brief The deadlines of one connection. */
+  struct connection_entry {
+    /** @brief The deadline timer, or INVALID_TIMER if none is armed. */
+    net::timers::timer_id timer = net::timers::INVALID_TIMER;
+    /** @brief The time of the last read. */
+    net::timers::timestamp last_active{};
+    /** @brief The header deadline. */
+    net::timers::timestamp header_deadline = net::timers::timestamp::max();
+    /** @brief True once the connection was shut down by a deadline. */
+    bool expired = false;
+  };
+
+  /** @brief A connection with paused reads. */
+  struct paused_read {
+    /** @brief The connection socket. */
+    socket_dialog socket;
+    /** @brief The read context of the connection. */
+    std::shared_ptr<read_context> rctx;
+  };
+
   /**
    * @brief Accept new connections on a listening socket.
    * @param ctx The async context to start the acceptor on.
    * @param socket The socket to listen for connections on.
    */
   auto acceptor(async_context &ctx, const socket_dialog &socket) -> void;
+  /**
+   * @brief Accepts pending connections into `accepted_` without blocking.
+   * @param socket The native listening socket.
+   * @param budget The most connections to accept.
+   * @returns The number of accepted connections, or -1 with errno set if
+   * none could be accepted.
+   */
+  auto accept_batch_(socket_type socket, std::size_t budget) -> int;
+  /**
+   * @brief Emits every connection in `accepted_`.
+   * @param ctx The async context.
+   */
+  auto emit_accepted_(async_context &ctx) -> void;
+  /**
+   * @brief Pauses reads on a connection if its write queue, or the write
+   * queues of the service, are above their high water marks. The read is
+   * submitted again once the queues are back at their low water marks.
+   * @param ctx The async context.
+   * @param socket The connection socket.
+   * @param rctx The read context of the connection.
+   * @returns true if reads are paused.
+   */
+  auto pause_reads_(async_context &ctx, const socket_dialog &socket,
+                    const std::shared_ptr<read_context> &rctx) -> bool;
+  /**
+   * @brief Submits the read of a paused connection again.
+   * @details Does nothing if `rctx` isn't the read context that is paused
+   * on `fd`, so a callback that outlives its pause is harmless.
+   * @param ctx The async context.
+   * @param fd The native socket of the connection.
+   * @param rctx The read context that was paused.
+   */
+  auto resume_reads_(async_context &ctx, std::size_t fd,
+                     const std::shared_ptr<read_context> &rctx) -> void;
+  /**
+   * @brief Applies the connection options to an accepted connection, then
+   * emits it with a new read context.
+   * @param ctx The async context.
+   * @param socket The accepted connection.
+   */
+  auto on_accept_(async_context &ctx, const socket_dialog &socket) -> void;
+  /**
+   * @brief Adds an accepted connection to the connection table and arms
+   * its deadline timer, if any deadline is enabled.
+   * @param ctx The async context.
+   * @param socket The accepted connection.
+   */
+  auto track_(async_context &ctx, const socket_dialog &socket) -> void;
+  /**
+   * @brief Removes a closing connection from the connection table and
+   * disarms its deadline timer.
+   * @param ctx The async context.
+   * @param socket The connection socket.
+   */
+  auto untrack_(async_context &ctx, const socket_dialog &socket) -> void;
+  /**
+   * @brief Records a read on a connection, which pushes its idle deadline
+   * back without touching its timer.
+   * @param socket The connection socket.
+   */
+  auto touch_(const socket_dialog &socket) noexcept -> void;
+  /**
+   * @param entry A connection table entry.
+   * @returns The earliest deadline of the connection.
+   */
+  [[nodiscard]] auto deadline_(const connection_entry &entry) const noexcept
+      -> net::timers::timestamp;
+  /**
+   * @brief Arms the deadline timer of a connection.
+   * @param ctx The async context.
+   * @param socket The connection socket.
+   * @param when The deadline.
+   */
+  auto arm_deadline_(async_context &ctx,
+                     const std::shared_ptr<socket_handle> &socket,
+                     net::timers::timestamp when) -> void;
+  /**
+   * @brief Shuts down a connection if it missed its deadline, otherwise
+   * re-arms the timer for the deadline that it has now.
+   * @details A connection with paused reads has its read submitted again,
+   * so that it sees the shutdown.
+   * @param ctx The async context.
+   * @param tid The timer that fired.
+   * @param fd The connection table index of the connection.
+   * @param socket The connection socket.
+   */
+  auto on_deadline_(async_context &ctx, net::timers::timer_id tid,
+                    std::size_t fd,
+                    const std::weak_ptr<socket_handle> &socket) -> void;
+  /** @returns A read context allocated from the read context pool. */
+  auto make_read_context_() -> std::shared_ptr<read_context>;
+  /**
+   * @brief Reads from a socket into an adaptive read buffer.
+   * @details Sizes the read buffer, takes it from the pool and reads into
+   * it. If the read fails the buffer is returned to the pool.
+   * @param rctx The read context.
+   * @param socket The native socket to read from.
+   * @returns The number of bytes read, or -1 with errno set on error.
+   */
+  auto adaptive_recv_(read_context &rctx, socket_type socket) -> ssize_t;
   /**
    * @brief Emits a span of bytes buf read from socket that must be handled by
    * the derived stream handler.
@@ -161,13 +551,23 @@ private:
    * @brief Initializes the server socket with options. Delegates to
    * StreamHandler::initialize if it is defined.
    * @details The base class initialize_ always sets the SO_REUSEADDR flag,
-   * so that the TCP server can be restarted quickly.
+   * so that the TCP server can be restarted quickly. It also applies the
+   * listener options in `options_.tcp`.
    * @param socket The socket handle to configure.
+   * @param reuse_port Also sets the SO_REUSEPORT flag if true.
    * @return A default constructed error code if successful, otherwise a system
    * error code.
    */
-  [[nodiscard]] auto
-  initialize_(const socket_handle &socket) -> std::error_code;
+  [[nodiscard]] auto initialize_(const socket_handle &socket,
+                                 bool reuse_port = false) -> std::error_code;
+  /**
+   * @brief Applies the listener options in `options_.tcp`.
+   * @param socket The listening socket.
+   * @returns A default constructed error code if successful, otherwise a
+   * system error code.
+   */
+  [[nodiscard]] auto set_listener_options_(const socket_handle &socket)
+      -> std::error_code;
 
   /** @brief Stop the service. */
   auto stop_() -> void;
@@ -179,6 +579,41 @@ private:
   socket_address<sockaddr_in6> address_;
   /** @brief The native acceptor socket handle. */
   std::atomic<socket_type> acceptor_sockfd_ = io::socket::INVALID_SOCKET;
+  /** @brief The service options. */
+  options_type options_;
+  /** @brief Connections accepted by the last accept_batch_(). */
+  std::vector<socket_type> accepted_;
+  /** @brief Recycles read contexts across connections. */
+  std::shared_ptr<net::detail::slab_pool> read_pool_ =
+      std::make_shared<net::detail::slab_pool>();
+  /** @brief Recycles read buffers across connections. */
+  std::shared_ptr<net::detail::buffer_pool> buffer_pool_ =
+      std::make_shared<net::detail::buffer_pool>(
+          options_.read_buffers.adaptive ? options_.read_buffers.min_size
+                                         : Size,
+          Size);
+  /** @brief Accounts for the bytes on every write queue. */
+  std::shared_ptr<write_budget> write_budget_ = std::make_shared<write_budget>(
+      options_.backpressure.service_high_water,
+      options_.backpressure.service_low_water);
+  /** @brief The number of connections with paused reads. */
+  std::atomic<std::size_t> paused_{0};
+  /**
+   * @brief Connections with paused reads, indexed by native socket. The
+   * service owns their read contexts while they are paused, so the
+   * callbacks that resume them only hold weak references. It is only used
+   * on the thread that runs the service's context.
+   */
+  std::vector<paused_read> paused_reads_;
+  /**
+   * @brief The connection table, indexed by native socket. It is only
+   * used on the thread that runs the service's context.
+   */
+  std::vector<connection_entry> connections_;
+  /** @brief The number of armed deadline timers. */
+  std::atomic<std::size_t> tracked_{0};
+  /** @brief The number of connections shut down by a deadline. */
+  std::atomic<std::size_t> expired_{0};
 };
 
 } // namespace net::service
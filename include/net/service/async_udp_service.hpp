@@ -21,12 +21,25 @@
 #ifndef CPPNET_ASYNC_UDP_SERVICE_HPP
 #define CPPNET_ASYNC_UDP_SERVICE_HPP
 #include "async_context.hpp"
+#include "datagram_queue.hpp"
+#include "zerocopy.hpp"
+
+#include <array>
+#include <vector>
+
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 namespace net::service {
 /**
  * @brief A ServiceLike Async UDP Service.
  * @tparam StreamHandler The StreamHandler type that derives from
  * async_udp_service.
  * @tparam Size The socket read buffer size. (Default 64KiB).
+ * @tparam Multiplexer The io multiplexer of the async context that the
+ * service runs on.
+ * @tparam Timers The timers engine of the async context that the service
+ * runs on.
  * @note The default constructor of async_udp_service is protected
  * so async_udp_service can't be constructed without a stream handler
  * (which would be UB).
@@ -64,23 +77,71 @@ namespace net::service {
  * @endcode
  */
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
-template <typename UDPStreamHandler, std::size_t Size = 64 * 1024UL>
+template <typename UDPStreamHandler, std::size_t Size = 64 * 1024UL,
+          typename Multiplexer = async_context::multiplexer_type,
+          typename Timers = async_context::timers_type>
 class async_udp_service {
 public:
   /** @brief Templated socket address type. */
   template <typename T> using socket_address = io::socket::socket_address<T>;
   /** @brief The async context type. */
-  using async_context = service::async_context;
+  using async_context = basic_async_context<Multiplexer, Timers>;
   /** @brief The async scope type. */
-  using async_scope = async_context::async_scope;
+  using async_scope = typename async_context::async_scope;
   /** @brief The io multiplexer type. */
-  using multiplexer_type = async_context::multiplexer_type;
+  using multiplexer_type = Multiplexer;
   /** @brief The socket handle type. */
   using socket_handle = io::socket::socket_handle;
   /** @brief The socket dialog type. */
   using socket_dialog = io::socket::socket_dialog<multiplexer_type>;
   /** @brief Re-export the async_context signals. */
-  using enum async_context::signals;
+  using enum async_context_base::signals;
+  /** @brief The zero-copy send tracker type. */
+  using zerocopy_type = zerocopy_tracker<async_context>;
+  /** @brief The datagram queue type. */
+  using datagram_queue_type = datagram_queue<async_context>;
+
+  /** @brief Service options. */
+  struct options_type {
+    /**
+     * @brief The most datagrams to read per readiness event. With a batch
+     * size of 1 each datagram is read by its own `recvmsg` and emitted with
+     * its own read context. Larger batches are read by a single `recvmmsg`
+     * and emitted together as a read_batch, which requires the stream
+     * handler to define the read_batch overload of `service`. start()
+     * stops the context if it doesn't.
+     */
+    std::size_t recv_batch = 1;
+    /**
+     * @brief The largest datagram that a slot of a read batch holds. The
+     * slots of a batch are slices of one buffer of `recv_batch` times this
+     * many bytes, so batches of small datagrams can use far less memory
+     * than `Size` bytes per slot. Longer datagrams are truncated by the
+     * kernel and dropped from the batch.
+     */
+    std::size_t datagram_size = Size;
+    /**
+     * @brief The number of reads that are kept in flight on the service
+     * socket. Each read has its own read context, or read batch, and is
+     * re-armed independently when the stream handler calls `submit_recv`,
+     * so the socket keeps draining while handlers hold on to their
+     * buffers. With a depth above 1, datagrams may be handled out of
+     * order.
+     */
+    std::size_t recv_depth = 1;
+    /**
+     * @brief Enables UDP generic receive offload if true. The kernel then
+     * coalesces consecutive datagrams from the same peer into one read,
+     * and the read context records their segment size. GRO requires a
+     * readiness multiplexer and is ignored by completion multiplexers,
+     * whose reads carry no control messages. Reads must be at least
+     * `GRO_READ_SIZE` bytes, so start() stops the context if `Size`, or
+     * the `datagram_size` of a batch, is smaller.
+     */
+    bool gro = false;
+    /** @brief The options of the outbound datagram queue. */
+    typename datagram_queue_type::options_type sends{};
+  };
 
   /** @brief A read context. */
   struct read_context {
@@ -105,6 +166,98 @@ public:
     std::span<std::byte> buffer{read_buffer};
     /** @brief The read socket message. */
     socket_message msg{.address = socket_address{}, .buffers = buffer};
+    /** @brief The size of the peer address written by the last read. */
+    ::socklen_t address_size = sizeof(sockaddr_in6);
+    /** @brief The control buffer of a GRO read. */
+    alignas(::cmsghdr) std::array<unsigned char, CMSG_SPACE(sizeof(int))>
+        control{};
+    /**
+     * @brief The segment size of the last read, or 0 if the read holds a
+     * single datagram.
+     */
+    std::size_t segment_size = 0;
+
+    /**
+     * @brief Calls func with every datagram of a read.
+     * @details A GRO read holds several datagrams of `segment_size` bytes,
+     * except for the last one, which may be shorter. Any other read holds
+     * exactly one datagram.
+     * @tparam Fn A callable that accepts a `std::span<const std::byte>`.
+     * @param buf The bytes of the read.
+     * @param func The callable.
+     */
+    template <typename Fn>
+    auto for_each_segment(std::span<const std::byte> buf, Fn &&func) const
+        -> void;
+  };
+
+  /**
+   * @brief A batch of datagrams that are filled by one `recvmmsg`.
+   * @details Slot `i` holds the `i`th datagram of the last read and its
+   * peer address in `msg.address`. The batch is re-used by every read, so
+   * the datagrams must not be used after the next read is submitted.
+   */
+  struct read_batch {
+    /** @brief The size type. */
+    using size_type = std::size_t;
+
+    /** @brief A datagram of a batch. */
+    struct slot {
+      /** @brief The bytes of the slot, a slice of the batch buffer. */
+      std::span<std::byte> buffer;
+      /** @brief The socket message, which holds the peer address. */
+      typename read_context::socket_message msg{
+          .address = typename read_context::socket_address{}};
+      /** @brief The control buffer of a GRO read. */
+      alignas(::cmsghdr) std::array<unsigned char, CMSG_SPACE(sizeof(int))>
+          control{};
+      /** @brief The segment size of the datagram, or 0. */
+      std::size_t segment_size = 0;
+
+      /**
+       * @brief Calls func with every datagram of a GRO read.
+       * @tparam Fn A callable that accepts a `std::span<const std::byte>`.
+       * @param buf The bytes of the slot.
+       * @param func The callable.
+       */
+      template <typename Fn>
+      auto for_each_segment(std::span<const std::byte> buf, Fn &&func) const
+          -> void;
+    };
+
+    /**
+     * @brief Constructor.
+     * @param size The number of slots.
+     * @param datagram_size The size of each slot.
+     */
+    explicit read_batch(size_type size, size_type datagram_size = Size);
+    /** @brief Deleted copy constructor. */
+    read_batch(const read_batch &) = delete;
+    /** @brief Deleted copy assignment. */
+    auto operator=(const read_batch &) -> read_batch & = delete;
+
+    /** @returns The number of datagrams read by the last read. */
+    [[nodiscard]] auto size() const noexcept -> size_type;
+    /**
+     * @param index The index of a datagram.
+     * @returns The bytes of the datagram.
+     */
+    [[nodiscard]] auto buffer(size_type index) const noexcept
+        -> std::span<const std::byte>;
+
+    /** @brief Default destructor. */
+    ~read_batch() = default;
+
+    /** @brief The buffer that the slots are slices of. */
+    std::vector<std::byte> storage;
+    /** @brief The slots. */
+    std::vector<slot> slots;
+    /** @brief The message headers passed to `recvmmsg`. */
+    std::vector<::mmsghdr> headers;
+    /** @brief The iovec of each slot. */
+    std::vector<::iovec> iovecs;
+    /** @brief The number of datagrams read by the last read. */
+    size_type count = 0;
   };
 
   /**
@@ -125,6 +278,70 @@ public:
    */
   auto submit_recv(async_context &ctx, const socket_dialog &socket,
                    std::shared_ptr<read_context> rctx) -> void;
+  /**
+   * @brief Submits an asynchronous read of up to one datagram per slot of
+   * a batch.
+   * @param ctx The async context to start the reader on.
+   * @param socket the socket to read data from.
+   * @param batch A shared pointer to the batch to read into.
+   */
+  auto submit_recv(async_context &ctx, const socket_dialog &socket,
+                   std::shared_ptr<read_batch> batch) -> void;
+  /**
+   * @brief Sends a datagram on the service socket without copying it.
+   * @details The buffers of the message must stay alive and unmodified
+   * until the returned sender completes. See zerocopy_tracker.
+   * @tparam Message The socket message type.
+   * @param ctx The async context that the service runs on.
+   * @param socket The service socket.
+   * @param msg The message to send, addressed to the peer.
+   * @returns A sender that completes with the number of bytes sent once
+   * the kernel has released the message.
+   */
+  template <typename Message>
+  auto send_zerocopy(async_context &ctx, const socket_dialog &socket,
+                     Message msg);
+  /**
+   * @brief Appends a datagram to the outbound queue of the service socket.
+   * @details Every datagram enqueued during one event loop iteration is
+   * sent by a single `sendmmsg`. See datagram_queue.
+   * @param ctx The async context that the service runs on.
+   * @param socket The service socket.
+   * @param address The destination address.
+   * @param buffer The datagram. The queue takes ownership of it.
+   * @param segment_size The GSO segment size. A non-zero segment size
+   * sends the buffer as datagrams of `segment_size` bytes with one
+   * message. 0 sends the buffer as a single datagram.
+   */
+  auto enqueue(async_context &ctx, const socket_dialog &socket,
+               const socket_address<sockaddr_in6> &address,
+               typename datagram_queue_type::buffer_type buffer,
+               std::size_t segment_size = 0) -> void;
+  /**
+   * @brief Appends a copy of a datagram to the outbound queue of the
+   * service socket.
+   * @param ctx The async context that the service runs on.
+   * @param socket The service socket.
+   * @param address The destination address.
+   * @param buffer The bytes of the datagram.
+   * @param segment_size The GSO segment size, or 0.
+   */
+  auto enqueue(async_context &ctx, const socket_dialog &socket,
+               const socket_address<sockaddr_in6> &address,
+               std::span<const std::byte> buffer,
+               std::size_t segment_size = 0) -> void;
+  /**
+   * @returns The outbound datagram queue, or null if nothing was enqueued
+   * yet.
+   */
+  [[nodiscard]] auto send_queue() const noexcept
+      -> const std::shared_ptr<datagram_queue_type> &;
+
+  /**
+   * @brief The smallest read that holds any GRO read. A truncated GRO read
+   * has lost its segment boundaries.
+   */
+  static constexpr std::size_t GRO_READ_SIZE = 65535;
 
 protected:
   /** @brief Default constructor. */
@@ -136,6 +353,14 @@ protected:
    */
   template <typename T>
   explicit async_udp_service(socket_address<T> address) noexcept;
+  /**
+   * @brief Socket address and options constructor.
+   * @tparam T The socket address type.
+   * @param address The service address to bind.
+   * @param options The service options.
+   */
+  template <typename T>
+  async_udp_service(socket_address<T> address, options_type options);
 
 private:
   /** @brief The native socket type. */
@@ -153,6 +378,56 @@ private:
   auto emit(async_context &ctx, const socket_dialog &socket,
             std::shared_ptr<read_context> rctx = {},
             std::span<const std::byte> buf = {}) -> void;
+  /**
+   * @brief Emits a batch of datagrams that must be handled by the derived
+   * stream handler.
+   * @param ctx The async context.
+   * @param socket The socket the datagrams were read from.
+   * @param batch The batch, or null if the read failed.
+   */
+  auto emit(async_context &ctx, const socket_dialog &socket,
+            std::shared_ptr<read_batch> batch) -> void;
+  /**
+   * @brief Reads up to one datagram into every slot of a batch without
+   * blocking.
+   * @details Truncated datagrams are dropped, and the rest are moved to
+   * the front of the batch in the order they were read.
+   * @param batch The batch to read into.
+   * @param socket The native socket to read from.
+   * @returns The number of datagrams read, or -1 with errno set.
+   */
+  static auto recv_batch_(read_batch &batch, socket_type socket) -> int;
+  /**
+   * @brief Reads one datagram, or one GRO read, and its control messages
+   * without blocking.
+   * @param rctx The read context to read into.
+   * @param socket The native socket to read from.
+   * @returns The number of bytes read, or -1 with errno set. A truncated
+   * read fails with EMSGSIZE.
+   */
+  static auto recv_gro_(read_context &rctx, socket_type socket) -> ssize_t;
+  /**
+   * @param hdr The message header of a completed read.
+   * @returns The GRO segment size of the read, or 0.
+   */
+  static auto segment_size_(::msghdr &hdr) noexcept -> std::size_t;
+  /**
+   * @brief Calls func with every datagram of a read.
+   * @tparam Fn A callable that accepts a `std::span<const std::byte>`.
+   * @param buf The bytes of the read.
+   * @param segment_size The GRO segment size of the read, or 0.
+   * @param func The callable.
+   */
+  template <typename Fn>
+  static auto for_each_segment_(std::span<const std::byte> buf,
+                                std::size_t segment_size, Fn &&func) -> void;
+  /**
+   * @brief Trims a peer address to the size that the kernel wrote.
+   * @param address The peer address of a completed read.
+   * @param size The size of the address reported by the kernel.
+   */
+  static auto peer_address_(socket_address<sockaddr_in6> &address,
+                            ::socklen_t size) noexcept -> void;
 
   /**
    * @brief Initializes the server socket with options. Delegates to
@@ -160,11 +435,12 @@ private:
    * @details The base class initialize_ always sets the SO_REUSEADDR flag,
    * so that the UDP server can be restarted quickly.
    * @param socket The socket handle to configure.
+   * @param reuse_port Also sets the SO_REUSEPORT flag if true.
    * @return A default constructed error code if successful, otherwise a system
    * error code.
    */
-  [[nodiscard]] auto
-  initialize_(const socket_handle &socket) -> std::error_code;
+  [[nodiscard]] auto initialize_(const socket_handle &socket,
+                                 bool reuse_port = false) -> std::error_code;
 
   /** @brief Stop the service. */
   auto stop_() -> void;
@@ -176,6 +452,12 @@ private:
   socket_address<sockaddr_in6> address_;
   /** @brief The native server socket handle. */
   std::atomic<socket_type> server_sockfd_ = io::socket::INVALID_SOCKET;
+  /** @brief The service options. */
+  options_type options_;
+  /** @brief Tracks the zero-copy sends of the service socket. */
+  std::shared_ptr<zerocopy_type> zerocopy_;
+  /** @brief The outbound datagram queue of the service socket. */
+  std::shared_ptr<datagram_queue_type> sends_;
 };
 
 } // namespace net::service
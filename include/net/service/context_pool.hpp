@@ -0,0 +1,149 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file context_pool.hpp
+ * @brief This file declares a pool of context threads.
+ */
+#pragma once
+#ifndef CPPNET_CONTEXT_POOL_HPP
+#define CPPNET_CONTEXT_POOL_HPP
+#include "context_thread.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+/** @brief This namespace is for network services. */
+namespace net::service {
+/**
+ * @brief Runs one instance of a service on each of several threads.
+ * @details Every thread has its own asynchronous context and its own
+ * service instance. Services are started with `reuse_port` set on their
+ * context, so each one binds its own `SO_REUSEPORT` socket to the same
+ * address and the kernel load balances connections and datagrams between
+ * them. Since every service binds the same address, the address must have
+ * a fixed, non-zero port.
+ * @code
+ * auto pool = context_pool<echo_service>(4);
+ * pool.start(address);
+ * // ...
+ * pool.stop();
+ * @endcode
+ * A pool can also pin each of its threads to a CPU, so that every service
+ * and its buffers stay on one core and its local NUMA node:
+ * @code
+ * using pool_type = context_pool<echo_service>;
+ * auto pool = pool_type(pool_type::pinned());
+ * @endcode
+ * @tparam Service The service to run.
+ */
+template <ServiceLike Service> class context_pool {
+public:
+  /** @brief The context thread type. */
+  using thread_type = context_thread<Service>;
+  /** @brief The asynchronous context type. */
+  using context_type = typename thread_type::context_type;
+  /** @brief The size type. */
+  using size_type = std::size_t;
+
+  /**
+   * @brief Constructor.
+   * @param size The number of context threads. Defaults to the number of
+   * hardware threads.
+   */
+  explicit context_pool(size_type size = default_size());
+  /**
+   * @brief Constructs one context thread for each set of thread options.
+   * @param options The placement options of each thread.
+   */
+  explicit context_pool(std::vector<thread_options> options);
+  /** @brief Deleted copy constructor. */
+  context_pool(const context_pool &) = delete;
+  /** @brief Deleted move constructor. */
+  context_pool(context_pool &&) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const context_pool &) -> context_pool & = delete;
+  /** @brief Deleted move assignment. */
+  auto operator=(context_pool &&) -> context_pool & = delete;
+
+  /**
+   * @brief Starts a service on every context thread.
+   * @details Each thread constructs its own service from a copy of `args`.
+   * `start` returns once every service has either started or stopped.
+   * @tparam Args Argument types for constructing the Service.
+   * @param args The arguments to copy to each Service constructor.
+   * @throws std::invalid_argument if the pool has already been started.
+   */
+  template <typename... Args> auto start(const Args &...args) -> void;
+
+  /**
+   * @brief Sends a signal to every context in the pool.
+   * @param signum The signal to send.
+   */
+  auto signal(int signum) -> void;
+
+  /**
+   * @brief Sends the terminate signal to every context, then waits for
+   * every context to stop.
+   */
+  auto stop() -> void;
+
+  /**
+   * @brief Checks that every service in the pool started.
+   * @returns true if every context is in the STARTED state.
+   */
+  [[nodiscard]] auto started() const noexcept -> bool;
+
+  /**
+   * @brief Builds options that pin each of `size` threads to one CPU.
+   * @details Thread `i` is pinned to the `i`-th CPU that the calling thread
+   * may run on. If there are more threads than CPUs, the CPUs are reused in
+   * the same order.
+   * @param size The number of threads.
+   * @returns The thread options, which are left unpinned if the allowed
+   * CPUs can't be read.
+   */
+  [[nodiscard]] static auto pinned(size_type size = default_size())
+      -> std::vector<thread_options>;
+
+  /** @returns The number of context threads. */
+  [[nodiscard]] auto size() const noexcept -> size_type;
+
+  /**
+   * @brief Accesses a context thread.
+   * @param index The thread index. Must be less than `size()`.
+   * @returns The context thread.
+   */
+  auto operator[](size_type index) noexcept -> thread_type &;
+
+  /** @brief The destructor stops and joins every context thread. */
+  ~context_pool() = default;
+
+private:
+  /** @returns The number of hardware threads, or 1 if it is unknown. */
+  static auto default_size() noexcept -> size_type;
+
+  /** @brief The context threads. */
+  std::vector<std::unique_ptr<thread_type>> threads_;
+  /** @brief Flag that guards against starting the pool twice. */
+  bool started_{false};
+};
+
+} // namespace net::service
+
+#include "impl/context_pool_impl.hpp" // IWYU pragma: export
+
+#endif // CPPNET_CONTEXT_POOL_HPP
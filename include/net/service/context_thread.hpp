@@ -23,21 +23,58 @@
 #include "async_context.hpp"
 
 #include <mutex>
+#include <system_error>
 #include <thread>
+#include <vector>
 /** @brief This namespace is for network services. */
 namespace net::service {
+/** @brief Options that control where a context thread runs. */
+struct thread_options {
+  /**
+   * @brief The CPUs that the thread may run on. The thread isn't pinned if
+   * the set is empty.
+   */
+  std::vector<int> cpus;
+};
+
+/**
+ * @brief Lists the CPUs that the calling thread is allowed to run on.
+ * @returns The allowed CPUs in ascending order, or an empty vector if they
+ * can't be read on this platform.
+ */
+inline auto allowed_cpus() -> std::vector<int>;
+
 /**
  * @brief A threaded asynchronous service.
  *
  * This class runs the provided service in a separate thread
- * with an asynchronous context.
+ * with an asynchronous context. The context type is selected
+ * with `context_of_t<Service>`.
+ *
+ * If `thread_options::cpus` is set, the thread pins itself to those CPUs
+ * before it constructs the service. Linux places memory on the NUMA node
+ * of the CPU that first touches it, so the service and everything that it
+ * allocates on the thread, such as its read buffers, are then placed on
+ * the node that the thread runs on. The context_thread itself, and so its
+ * base context, is constructed by the caller and stays where the caller
+ * put it. If the thread can't be pinned it stops without starting the
+ * service, and error() reports why.
  *
  * @tparam Service The service to run.
  */
-template <ServiceLike Service> class context_thread : public async_context {
+template <ServiceLike Service>
+class context_thread : public context_of_t<Service> {
 public:
+  /** @brief The asynchronous context type. */
+  using context_type = context_of_t<Service>;
+
   /** @brief Default constructor. */
   context_thread() = default;
+  /**
+   * @brief Constructs a context thread with placement options.
+   * @param options The thread placement options.
+   */
+  explicit context_thread(thread_options options) noexcept;
   /** @brief Deleted copy constructor. */
   context_thread(const context_thread &) = delete;
   /** @brief Deleted move constructor. */
@@ -56,6 +93,31 @@ public:
    */
   template <typename... Args> auto start(Args &&...args) -> void;
 
+  /** @returns The id of the thread, or a default id if it isn't running. */
+  [[nodiscard]] auto thread_id() const noexcept -> std::thread::id;
+
+  /**
+   * @brief Reads the CPUs that the thread may run on from the kernel.
+   * @details The thread pins itself before it leaves the PENDING state, so
+   * wait for the state to change before reading the affinity.
+   * @returns The CPUs, or an empty vector if the thread isn't running or
+   * the affinity can't be read on this platform.
+   */
+  [[nodiscard]] auto affinity() const -> std::vector<int>;
+
+  /** @returns The placement options of the thread. */
+  [[nodiscard]] auto options() const noexcept -> const thread_options &;
+
+  /**
+   * @brief Reads the error that stopped the thread before it could start
+   * the service.
+   * @details The error is set before the thread leaves the PENDING state,
+   * so wait for the state to change before reading it.
+   * @returns The error of pinning the thread, or a default constructed
+   * error code if there was none.
+   */
+  [[nodiscard]] auto error() const noexcept -> std::error_code;
+
   /** @brief The destructor signals the thread before joining it. */
   ~context_thread();
 
@@ -66,9 +128,19 @@ private:
   std::mutex mtx_;
   /** @brief Flag that guards against starting a thread twice. */
   bool started_{false};
+  /** @brief The thread placement options. */
+  thread_options options_;
+  /** @brief The error that stopped the thread from starting. */
+  std::error_code error_;
 
   /** @brief Called when the async_service is stopped. */
   auto stop() noexcept -> void;
+  /**
+   * @brief Pins the calling thread to `options_.cpus`.
+   * @returns A default constructed error code if successful, otherwise a
+   * system error code.
+   */
+  auto pin_() const noexcept -> std::error_code;
 };
 
 } // namespace net::service
@@ -0,0 +1,228 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file datagram_queue.hpp
+ * @brief This file declares an outbound datagram queue for one socket.
+ */
+#pragma once
+#ifndef CPPNET_DATAGRAM_QUEUE_HPP
+#define CPPNET_DATAGRAM_QUEUE_HPP
+#include "async_context.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+/** @brief This namespace is for network services. */
+namespace net::service {
+/**
+ * @brief An outbound datagram queue for one datagram socket.
+ * @details Datagrams are appended to the queue with their destination
+ * address. The first push into an empty queue waits for the socket to
+ * become writable through the context's poller, so every datagram pushed
+ * during the same event loop iteration is sent by a single `sendmmsg` once
+ * the poller runs the wait. A queue that reaches `max_batch` datagrams is
+ * flushed immediately instead.
+ *
+ * `sendmmsg` may send only part of a batch. The rest is sent by the next
+ * call, or once the socket is writable again if it would block. A datagram
+ * that the kernel refuses, for instance because it is too large or its
+ * destination is unreachable, is dropped without affecting the others.
+ *
+ * A datagram pushed with a segment size is a GSO super-buffer. It is sent
+ * as one message with a `UDP_SEGMENT` control message, and the kernel, or
+ * the NIC, splits it into datagrams of `segment_size` bytes, so a single
+ * `sendmmsg` can carry thousands of datagrams. Super-buffers are split into
+ * messages of at most `MAX_GSO_SEGMENTS` segments and `MAX_GSO_BYTES`
+ * bytes. If the kernel refuses segmentation offload, the queue falls back
+ * to sending every segment as its own datagram.
+ *
+ * A datagram_queue must only be used on the thread that runs its context.
+ * @tparam AsyncContext The asynchronous context type.
+ */
+template <typename AsyncContext>
+class datagram_queue
+    : public std::enable_shared_from_this<datagram_queue<AsyncContext>> {
+public:
+  /** @brief The asynchronous context type. */
+  using async_context = AsyncContext;
+  /** @brief The socket dialog type. */
+  using socket_dialog = typename async_context::socket_dialog;
+  /** @brief The destination address type. */
+  using socket_address = io::socket::socket_address<sockaddr_in6>;
+  /** @brief The size type. */
+  using size_type = std::size_t;
+  /** @brief The queued datagram type. */
+  using buffer_type = std::vector<std::byte>;
+
+  /** @brief Options that control how the queue is flushed. */
+  struct options_type {
+    /**
+     * @brief The largest number of datagrams that are sent by one
+     * `sendmmsg`. A queue that holds this many datagrams is flushed
+     * without waiting for the end of the event loop iteration.
+     */
+    size_type max_batch = DEFAULT_MAX_BATCH;
+  };
+
+  /**
+   * @brief Constructor.
+   * @param options The queue options.
+   */
+  explicit datagram_queue(options_type options = {}) noexcept;
+  /** @brief Deleted copy constructor. */
+  datagram_queue(const datagram_queue &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const datagram_queue &) -> datagram_queue & = delete;
+
+  /**
+   * @brief Appends a datagram to the queue.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket to send on.
+   * @param address The destination address.
+   * @param buffer The datagram. The queue takes ownership of it.
+   * @param segment_size The GSO segment size, or 0 to send the buffer as
+   * a single datagram.
+   */
+  auto push(async_context &ctx, const socket_dialog &socket,
+            const socket_address &address, buffer_type buffer,
+            size_type segment_size = 0) -> void;
+  /**
+   * @brief Appends a copy of a datagram to the queue.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket to send on.
+   * @param address The destination address.
+   * @param buffer The bytes of the datagram.
+   * @param segment_size The GSO segment size, or 0 to send the buffer as
+   * a single datagram.
+   */
+  auto push(async_context &ctx, const socket_dialog &socket,
+            const socket_address &address, std::span<const std::byte> buffer,
+            size_type segment_size = 0) -> void;
+
+  /** @returns The number of messages that are queued but not sent yet. */
+  [[nodiscard]] auto queued() const noexcept -> size_type;
+  /**
+   * @returns The number of messages that were sent. A GSO super-buffer
+   * counts as one message.
+   */
+  [[nodiscard]] auto sent() const noexcept -> size_type;
+  /** @returns The number of messages that were dropped. */
+  [[nodiscard]] auto dropped() const noexcept -> size_type;
+  /** @returns The number of sendmmsg calls that the queue has made. */
+  [[nodiscard]] auto syscalls() const noexcept -> size_type;
+
+  /** @brief Default destructor. */
+  ~datagram_queue() = default;
+
+  /** @brief The default largest number of datagrams per sendmmsg. */
+  static constexpr size_type DEFAULT_MAX_BATCH = 64;
+  /** @brief The most segments the kernel accepts in one GSO message. */
+  static constexpr size_type MAX_GSO_SEGMENTS = 64;
+  /**
+   * @brief The most bytes in one GSO message, which keeps it below the 64
+   * KiB IP datagram limit once the headers are added.
+   */
+  static constexpr size_type MAX_GSO_BYTES = 65000;
+
+private:
+  /** @brief The native socket type. */
+  using socket_type = io::socket::native_socket_type;
+
+  /** @brief A queued datagram. */
+  struct datagram {
+    /** @brief The destination address. */
+    socket_address address;
+    /** @brief The bytes of the datagram. */
+    buffer_type buffer;
+    /** @brief The GSO segment size, or 0. */
+    std::uint16_t segment_size = 0;
+  };
+
+  /** @brief The control buffer of one GSO message. */
+  struct gso_control {
+    /** @brief The `UDP_SEGMENT` control message. */
+    alignas(::cmsghdr) std::array<unsigned char,
+                                  CMSG_SPACE(sizeof(std::uint16_t))> data{};
+  };
+
+  /**
+   * @brief Appends a GSO super-buffer to the queue, split into messages
+   * that the kernel accepts.
+   * @param address The destination address.
+   * @param buffer The super-buffer.
+   * @param segment_size The segment size.
+   */
+  auto append_segments_(const socket_address &address, buffer_type buffer,
+                        size_type segment_size) -> void;
+  /**
+   * @brief Replaces the GSO message at the front of the queue with one
+   * datagram per segment.
+   */
+  auto split_front_() -> void;
+
+  /**
+   * @brief Sends queued datagrams until the queue is empty or the socket
+   * would block.
+   * @param socket The native socket.
+   * @returns The number of datagrams sent, or -1 with errno set.
+   */
+  auto flush_(socket_type socket) -> ssize_t;
+  /**
+   * @brief Waits for the socket to become writable and flushes the queue,
+   * if the wait isn't armed already.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket.
+   */
+  auto arm_(async_context &ctx, const socket_dialog &socket) -> void;
+
+  /** @brief The queue options. */
+  options_type options_;
+  /** @brief The queued datagrams. */
+  std::deque<datagram> datagrams_;
+  /** @brief The message headers of the current sendmmsg. */
+  std::vector<::mmsghdr> headers_;
+  /** @brief The iovecs of the current sendmmsg. */
+  std::vector<::iovec> iovecs_;
+  /** @brief The control buffers of the current sendmmsg. */
+  std::vector<gso_control> controls_;
+  /** @brief The number of datagrams sent. */
+  size_type sent_ = 0;
+  /** @brief The number of datagrams dropped. */
+  size_type dropped_ = 0;
+  /** @brief The number of sendmmsg calls. */
+  size_type syscalls_ = 0;
+  /** @brief True while the writable wait is armed. */
+  bool armed_ = false;
+  /** @brief False once the kernel refused segmentation offload. */
+  bool gso_ = true;
+};
+
+} // namespace net::service
+
+#include "impl/datagram_queue_impl.hpp" // IWYU pragma: export
+
+#endif // CPPNET_DATAGRAM_QUEUE_HPP
@@ -0,0 +1,268 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file flow_table.hpp
+ * @brief This file declares a table of per-peer flow state.
+ */
+#pragma once
+#ifndef CPPNET_FLOW_TABLE_HPP
+#define CPPNET_FLOW_TABLE_HPP
+#include "async_context.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <netinet/in.h>
+/** @brief This namespace is for network services. */
+namespace net::service {
+/**
+ * @brief A fixed capacity table of per-peer state for datagram services.
+ * @details Flows are keyed on the peer address of a datagram, normalized so
+ * that an IPv4 peer and its IPv4-mapped IPv6 address are the same flow. The
+ * table is an open-addressing hash table with linear probing. Its slots are
+ * allocated once by the constructor and hold the flow state inline, so
+ * lookups, insertions and removals never allocate and touch a handful of
+ * adjacent slots at most.
+ *
+ * Idle expiry is driven by a periodic timer on the context's timers. Each
+ * tick advances the table's clock and checks one slice of the slots, so a
+ * flow expires between `idle` and twice `idle` after it was last used,
+ * without ever stalling the event loop on a full scan. Looking a flow up
+ * marks it as used. When the table is full, inserting a new flow evicts the
+ * least recently used of the flows that are probed next to it.
+ *
+ * Insertions and removals move flows between slots, so a pointer to a
+ * flow's state is only valid until the next call that inserts, erases or
+ * expires a flow. A flow_table must only be used on the thread that runs
+ * its context, but its counters can be read from any thread.
+ * @code
+ * using flows_type = flow_table<session>;
+ * auto flows = std::make_shared<flows_type>(flows_type::options_type{
+ *     .capacity = 1 << 20, .idle = std::chrono::seconds(30)});
+ * flows->start(ctx);
+ *
+ * auto [state, inserted] = flows->try_emplace(*rctx->msg.address);
+ * @endcode
+ * @tparam State The flow state type. It must be default constructible and
+ * move assignable.
+ * @tparam AsyncContext The asynchronous context type.
+ */
+template <typename State, typename AsyncContext = async_context>
+class flow_table
+    : public std::enable_shared_from_this<flow_table<State, AsyncContext>> {
+public:
+  /** @brief The asynchronous context type. */
+  using async_context = AsyncContext;
+  /** @brief The flow state type. */
+  using state_type = State;
+  /** @brief The size type. */
+  using size_type = std::size_t;
+  /** @brief The peer address type. */
+  using socket_address = io::socket::socket_address<sockaddr_in6>;
+
+  /** @brief Table options. */
+  struct options_type {
+    /** @brief The most flows that the table holds. */
+    size_type capacity = DEFAULT_CAPACITY;
+    /** @brief Expires flows that are idle for this long. 0 never expires. */
+    std::chrono::milliseconds idle{0};
+  };
+
+  /** @brief A snapshot of the table counters. */
+  struct stats_type {
+    /** @brief The number of flows in the table. */
+    size_type flows = 0;
+    /** @brief The number of flows that were inserted. */
+    size_type inserted = 0;
+    /** @brief The number of flows that expired. */
+    size_type expired = 0;
+    /** @brief The number of flows evicted to make room for new flows. */
+    size_type evicted = 0;
+  };
+
+  /**
+   * @brief Constructor.
+   * @param options The table options.
+   */
+  explicit flow_table(options_type options = {});
+  /** @brief Deleted copy constructor. */
+  flow_table(const flow_table &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const flow_table &) -> flow_table & = delete;
+
+  /**
+   * @brief Looks up the flow of a peer and marks it as used.
+   * @param address The peer address.
+   * @returns A pointer to the flow state, or null if the peer has no flow.
+   */
+  [[nodiscard]] auto find(const socket_address &address) noexcept
+      -> state_type *;
+  /**
+   * @brief Looks up the flow of a peer, and inserts a default constructed
+   * flow if it has none.
+   * @details A full table evicts a flow first.
+   * @param address The peer address.
+   * @returns A pointer to the flow state, and true if it was inserted.
+   */
+  auto try_emplace(const socket_address &address)
+      -> std::pair<state_type *, bool>;
+  /**
+   * @brief Removes the flow of a peer.
+   * @param address The peer address.
+   * @returns true if the peer had a flow.
+   */
+  auto erase(const socket_address &address) -> bool;
+  /** @brief Removes every flow. */
+  auto clear() -> void;
+
+  /**
+   * @brief Starts expiring idle flows with the context's timers.
+   * @details Does nothing if `idle` is 0. The timer holds a weak reference
+   * to the table, so the table must be owned by a `std::shared_ptr`.
+   * @param ctx The context that the table is used on.
+   */
+  auto start(async_context &ctx) -> void;
+  /**
+   * @brief Stops expiring idle flows.
+   * @param ctx The context that the table was started on.
+   */
+  auto stop(async_context &ctx) noexcept -> void;
+  /**
+   * @brief Advances the table clock and expires the idle flows of the next
+   * slice of slots.
+   * @details This is called by the timer that start() arms. A flow is idle
+   * once more than `SWEEP_SLICES` ticks have passed since it was last used.
+   * @returns The number of flows that expired.
+   */
+  auto tick() -> size_type;
+
+  /** @returns The number of flows in the table. */
+  [[nodiscard]] auto size() const noexcept -> size_type;
+  /** @returns The most flows that the table holds. */
+  [[nodiscard]] auto capacity() const noexcept -> size_type;
+  /**
+   * @brief Reads the table counters.
+   * @details The counters can be read from any thread.
+   * @returns A snapshot of the counters.
+   */
+  [[nodiscard]] auto stats() const noexcept -> stats_type;
+
+  /** @brief Default destructor. */
+  ~flow_table() = default;
+
+  /** @brief The default most flows in a table. */
+  static constexpr size_type DEFAULT_CAPACITY = 1024;
+  /** @brief The number of ticks it takes to check every slot. */
+  static constexpr size_type SWEEP_SLICES = 8;
+  /** @brief The most flows that are compared to pick an eviction. */
+  static constexpr size_type EVICTION_PROBES = 8;
+
+private:
+  /** @brief A normalized peer address. */
+  struct flow_key {
+    /** @brief The IPv4 or IPv6 address bytes. */
+    std::array<std::uint8_t, sizeof(in6_addr)> addr{};
+    /** @brief The IPv6 scope id. */
+    std::uint32_t scope = 0;
+    /** @brief The port in network byte order. */
+    std::uint16_t port = 0;
+    /** @brief The address family. */
+    sa_family_t family = 0;
+
+    /** @brief Keys compare equal if every field is equal. */
+    auto operator==(const flow_key &) const noexcept -> bool = default;
+  };
+
+  /** @brief A slot of the table. */
+  struct slot {
+    /** @brief The hash of the key. */
+    std::size_t hash = 0;
+    /** @brief The peer of the flow. */
+    flow_key key;
+    /** @brief The table clock when the flow was last used. */
+    std::uint32_t last_used = 0;
+    /** @brief True if the slot holds a flow. */
+    bool occupied = false;
+    /** @brief The flow state. */
+    state_type state{};
+  };
+
+  /**
+   * @param address A peer address.
+   * @returns The normalized key of the address.
+   */
+  static auto key_(const socket_address &address) noexcept -> flow_key;
+  /**
+   * @param key A normalized key.
+   * @returns The hash of the key.
+   */
+  static auto hash_(const flow_key &key) noexcept -> std::size_t;
+  /**
+   * @brief Probes for a key.
+   * @param key The key.
+   * @param hash The hash of the key.
+   * @returns The index of the slot that holds the key, or of the empty slot
+   * that ends its probe sequence.
+   */
+  [[nodiscard]] auto probe_(const flow_key &key,
+                            std::size_t hash) const noexcept -> size_type;
+  /**
+   * @brief Empties a slot and shifts the rest of its probe sequence back,
+   * so that lookups never need tombstones.
+   * @param index The index of an occupied slot.
+   */
+  auto erase_at_(size_type index) -> void;
+  /**
+   * @brief Evicts the least recently used flow of the first
+   * `EVICTION_PROBES` flows from a slot onwards.
+   * @param index The index to start from.
+   */
+  auto evict_(size_type index) -> void;
+
+  /** @brief The table options. */
+  options_type options_;
+  /** @brief The slots. Their number is a power of two. */
+  std::vector<slot> slots_;
+  /** @brief The number of slots less one. */
+  size_type mask_ = 0;
+  /** @brief The table clock, in ticks. */
+  std::uint32_t now_ = 0;
+  /** @brief The next slot for tick() to check. */
+  size_type cursor_ = 0;
+  /** @brief The expiry timer. */
+  net::timers::timer_id timer_ = net::timers::INVALID_TIMER;
+  /** @brief The number of flows. */
+  std::atomic<size_type> size_{0};
+  /** @brief The number of flows inserted. */
+  std::atomic<size_type> inserted_{0};
+  /** @brief The number of flows expired. */
+  std::atomic<size_type> expired_{0};
+  /** @brief The number of flows evicted. */
+  std::atomic<size_type> evicted_{0};
+};
+
+} // namespace net::service
+
+#include "impl/flow_table_impl.hpp" // IWYU pragma: export
+
+#endif // CPPNET_FLOW_TABLE_HPP
@@ -23,7 +23,14 @@
 #define CPPNET_ASYNC_CONTEXT_IMPL_HPP
 #include "net/service/async_context.hpp"
 
+#if __has_include(<sys/timerfd.h>)
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
 #include <cassert>
+#include <cstdint>
+#include <functional>
 namespace net::service {
 /** @brief Internal net::service implementation details. */
 namespace detail {
@@ -51,7 +58,130 @@ auto to_millis(std::chrono::duration<Rep, Period> duration) -> int
 }
 } // namespace detail.
 
-inline auto async_context::signal(int signum) -> void
+/**
+ * @details The scheduler holds a pointer to its context, so it must not
+ * outlive the context. Operations that are stopped while they are queued
+ * complete with `set_stopped` when the event loop reaches them.
+ */
+template <typename Multiplexer, typename Timers>
+class basic_async_context<Multiplexer, Timers>::scheduler {
+  /** @brief The operation state of a schedule sender. */
+  template <typename Receiver> class operation : posted_operation {
+  public:
+    /**
+     * @brief Constructor.
+     * @param ctx The context to run on.
+     * @param receiver The receiver to complete.
+     */
+    operation(basic_async_context *ctx, Receiver receiver) noexcept
+        : posted_operation{{}, execute_}, ctx_{ctx},
+          receiver_{std::move(receiver)}
+    {}
+    /** @brief Deleted copy constructor. */
+    operation(const operation &) = delete;
+    /** @brief Deleted copy assignment. */
+    auto operator=(const operation &) -> operation & = delete;
+
+    /** @brief Queues the operation on the context. */
+    auto start() & noexcept -> void { ctx_->post_(this); }
+
+    /** @brief Default destructor. */
+    ~operation() = default;
+
+  private:
+    /** @brief Completes the receiver on the event loop thread. */
+    static auto execute_(posted_operation *base, bool stopped) noexcept -> void
+    {
+      auto *self = static_cast<operation *>(base);
+      auto token = stdexec::get_stop_token(stdexec::get_env(self->receiver_));
+      if (stopped || token.stop_requested())
+        return stdexec::set_stopped(std::move(self->receiver_));
+
+      stdexec::set_value(std::move(self->receiver_));
+    }
+
+    /** @brief The context. */
+    basic_async_context *ctx_;
+    /** @brief The receiver. */
+    Receiver receiver_;
+  };
+
+public:
+  /** @brief The scheduler concept. */
+  using scheduler_concept = stdexec::scheduler_t;
+
+  /** @brief A sender that completes on the event loop thread. */
+  class sender {
+  public:
+    /** @brief The sender concept. */
+    using sender_concept = stdexec::sender_t;
+    /** @brief The completion signatures. */
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(),
+                                       stdexec::set_stopped_t()>;
+
+    /** @brief The sender environment. */
+    struct env {
+      /** @brief The context. */
+      basic_async_context *ctx;
+
+      /** @returns The scheduler that the sender completes on. */
+      template <typename CPO>
+      auto query(stdexec::get_completion_scheduler_t<CPO> /*unused*/)
+          const noexcept -> scheduler
+      {
+        return scheduler{ctx};
+      }
+    };
+
+    /**
+     * @brief Constructor.
+     * @param ctx The context to run on.
+     */
+    explicit sender(basic_async_context *ctx) noexcept : ctx_{ctx} {}
+
+    /** @returns The sender environment. */
+    [[nodiscard]] auto get_env() const noexcept -> env { return {ctx_}; }
+
+    /**
+     * @brief Connects the sender to a receiver.
+     * @tparam Receiver The receiver type.
+     * @param receiver The receiver.
+     * @returns The operation state.
+     */
+    template <stdexec::receiver Receiver>
+    auto connect(Receiver receiver) const noexcept -> operation<Receiver>
+    {
+      return {ctx_, std::move(receiver)};
+    }
+
+  private:
+    /** @brief The context. */
+    basic_async_context *ctx_;
+  };
+
+  /**
+   * @brief Constructor.
+   * @param ctx The context to run on.
+   */
+  explicit scheduler(basic_async_context *ctx) noexcept : ctx_{ctx} {}
+
+  /** @returns A sender that completes on the event loop thread. */
+  [[nodiscard]] auto schedule() const noexcept -> sender
+  {
+    return sender{ctx_};
+  }
+
+  /** @brief Schedulers are equal if they run on the same context. */
+  auto operator==(const scheduler &other) const noexcept -> bool = default;
+
+private:
+  /** @brief The context. */
+  basic_async_context *ctx_;
+};
+
+template <typename Multiplexer, typename Timers>
+auto basic_async_context<Multiplexer, Timers>::signal(int signum) -> void
 {
   assert(signum >= 0 && signum < END && "signum must be a valid signal.");
   sigmask.fetch_or(1 << signum);
@@ -59,35 +189,87 @@ inline auto async_context::signal(int signum) -> void
 }
 
 /** @brief Calls the timers interrupt. */
-inline auto async_context::interrupt() const noexcept -> void
+template <typename Multiplexer, typename Timers>
+auto basic_async_context<Multiplexer, Timers>::interrupt() const noexcept
+    -> void
 {
-  static_cast<const timers_type::interrupt_source_t &>(timers).interrupt();
+  using interrupt_source_t = typename timers_type::interrupt_source_t;
+  static_cast<const interrupt_source_t &>(timers).interrupt();
 }
 
+template <typename Multiplexer, typename Timers>
 template <typename Fn>
   requires std::is_invocable_r_v<bool, Fn>
-auto async_context::isr(const socket_dialog &socket, Fn routine) -> void
+auto basic_async_context<Multiplexer, Timers>::isr(
+    const socket_dialog &socket, Fn routine) -> void
 {
-  using namespace io::socket;
   using namespace stdexec;
-  using socket_message = socket_message<sockaddr_in>;
-
-  static constexpr auto BUFLEN = 1024UL;
-  static auto buffer = std::array<std::byte, BUFLEN>{};
-  static auto msg = socket_message{.buffers = buffer};
+  using enum io::execution::execution_trigger;
 
   if (!routine())
     return;
 
-  sender auto recvmsg = io::recvmsg(socket, msg, 0) |
-                        then([this, socket, func = std::move(routine)](auto) {
-                          isr(socket, std::move(func));
-                        }) |
-                        upon_error([](auto) noexcept {});
-  scope.spawn(std::move(recvmsg));
+  auto mux = socket.multiplexer.lock();
+  if (!mux)
+    return;
+
+  sender auto drain =
+      mux->set(socket.socket, READ,
+               [listener = static_cast<socket_type>(*socket.socket)] {
+                 return interrupt_source::drain(listener);
+               }) |
+      then([this, socket, func = std::move(routine)](auto) {
+        isr(socket, std::move(func));
+      }) |
+      upon_error([](auto) noexcept {});
+  scope.spawn(std::move(drain));
+}
+
+template <typename Multiplexer, typename Timers>
+auto basic_async_context<Multiplexer, Timers>::get_scheduler() noexcept
+    -> scheduler
+{
+  return scheduler{this};
+}
+
+template <typename Multiplexer, typename Timers>
+template <typename Fn>
+  requires std::is_invocable_v<Fn &>
+auto basic_async_context<Multiplexer, Timers>::post(Fn &&func) -> void
+{
+  using namespace stdexec;
+  scope.spawn(schedule(get_scheduler()) |
+              then([func = std::forward<Fn>(func)]() mutable {
+                std::invoke(func);
+              }));
+}
+
+template <typename Multiplexer, typename Timers>
+auto basic_async_context<Multiplexer, Timers>::post_(
+    posted_operation *operation) noexcept -> void
+{
+  // Only the push that finds the queue empty needs to wake the event loop,
+  // every later push is drained by the same run() iteration.
+  if (posted_.push(operation))
+    interrupt();
+}
+
+template <typename Multiplexer, typename Timers>
+auto basic_async_context<Multiplexer, Timers>::run_posted_(
+    bool stopped) noexcept -> void
+{
+  auto *operation = posted_.take();
+  while (operation)
+  {
+    // Completing an operation may destroy it.
+    auto *next = static_cast<posted_operation *>(operation->next);
+    operation->execute(operation, stopped);
+    operation = next;
+  }
 }
 
-inline auto async_context::run() -> void
+template <typename Multiplexer, typename Timers>
+auto basic_async_context<Multiplexer, Timers>::run() -> void
 {
   using namespace stdexec;
   using namespace std::chrono;
@@ -97,7 +279,99 @@ inline auto async_context::run() -> void
   scope.spawn(poller.on_empty() |
               then([&]() noexcept { is_empty.test_and_set(); }));
 
-  while (poller.wait_for(to_millis(timers.resolve())) || !is_empty.test());
+  do
+    run_posted_();
+  while (poller.wait_for(wait_interval_(timers.resolve())) ||
+         !is_empty.test());
+}
+
+template <typename Multiplexer, typename Timers>
+auto basic_async_context<Multiplexer, Timers>::wait_interval_(
+    timers::duration timeout) -> int
+{
+  using namespace std::chrono;
+  using detail::to_millis;
+
+  if (timeout <= timers::duration::zero() || timeout >= milliseconds(1))
+    return to_millis(timeout);
+
+  // Without a high resolution wakeup, rounding up is still better than
+  // spinning on zero timeouts until the deadline passes.
+  arm_wakeup_(timeout);
+  return 1;
+}
+
+template <typename Multiplexer, typename Timers>
+auto basic_async_context<Multiplexer, Timers>::arm_wakeup_(
+    timers::duration timeout) -> bool
+{
+#if __has_include(<sys/timerfd.h>)
+  using namespace std::chrono;
+
+  const auto nsec = duration_cast<nanoseconds>(timeout).count();
+  const auto spec = ::itimerspec{
+      .it_interval = {},
+      .it_value = {.tv_sec = 0, .tv_nsec = static_cast<long>(nsec)}};
+
+  if (auto handle = wakeup_.lock())
+  {
+    const auto fd = static_cast<socket_type>(*handle);
+    return ::timerfd_settime(fd, 0, &spec, nullptr) == 0;
+  }
+
+  // A stopped scope can't wait for the wakeup.
+  if (scope.get_stop_token().stop_requested())
+    return false;
+
+  const auto fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  // The poller owns the timerfd, and closes it once the scope is stopped.
+  auto socket = poller.emplace(fd);
+  if (::timerfd_settime(fd, 0, &spec, nullptr))
+    return false;
+
+  wakeup_ = socket.socket;
+  wait_wakeup_(socket);
+  return true;
+#else
+  return false;
+#endif
+}
+
+template <typename Multiplexer, typename Timers>
+auto basic_async_context<Multiplexer, Timers>::wait_wakeup_(
+    const socket_dialog &socket) -> void
+{
+#if __has_include(<sys/timerfd.h>)
+  using namespace stdexec;
+  using enum io::execution::execution_trigger;
+
+  if (scope.get_stop_token().stop_requested())
+    return;
+
+  auto mux = socket.multiplexer.lock();
+  if (!mux)
+    return;
+
+  sender auto wakeup =
+      mux->set(socket.socket, READ,
+               [fd = static_cast<socket_type>(*socket.socket)] {
+                 auto expirations = std::uint64_t{};
+                 return ::read(fd, &expirations, sizeof(expirations));
+               }) |
+      then([this, socket](auto) { wait_wakeup_(socket); }) |
+      upon_error([](auto) noexcept {});
+  scope.spawn(std::move(wakeup));
+#endif
+}
+
+template <typename Multiplexer, typename Timers>
+basic_async_context<Multiplexer, Timers>::~basic_async_context()
+{
+  while (!posted_.empty())
+    run_posted_(true);
 }
 
 } // namespace net::service
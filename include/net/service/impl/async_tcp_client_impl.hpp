@@ -0,0 +1,444 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file async_tcp_client_impl.hpp
+ * @brief This file defines an asynchronous tcp client.
+ */
+#pragma once
+#ifndef CPPNET_ASYNC_TCP_CLIENT_IMPL_HPP
+#define CPPNET_ASYNC_TCP_CLIENT_IMPL_HPP
+#include "net/service/async_tcp_client.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#if __has_include(<netinet/tcp.h>)
+#include <netinet/tcp.h>
+#endif
+namespace net::service {
+
+/**
+ * @details The operation waits for the socket to become writable through
+ * the multiplexer, then reads the outcome of the connect from `SO_ERROR`.
+ */
+template <typename AsyncContext>
+template <typename Receiver>
+class connect_sender<AsyncContext>::operation {
+  /** @brief The native socket type. */
+  using socket_type = io::socket::native_socket_type;
+  /** @brief The multiplexer type. */
+  using multiplexer_type = typename async_context::multiplexer_type;
+
+  /** @brief Reads the outcome of the connect once the socket is writable. */
+  struct connect_fn {
+    /** @brief The operation. */
+    operation *self;
+    /** @returns 0 once connected, or -1 with errno set. */
+    auto operator()() const noexcept -> int { return self->finish_(); }
+  };
+
+  /** @brief Receives the completion of the multiplexer wait. */
+  struct receiver {
+    /** @brief The receiver concept. */
+    using receiver_concept = stdexec::receiver_t;
+
+    /** @brief Completes with the connected socket. */
+    auto set_value(auto && /*result*/) && noexcept -> void
+    {
+      self->cancel_timeout_();
+      stdexec::set_value(std::move(self->receiver_),
+                         std::move(self->socket_));
+    }
+
+    /** @brief Completes with the connect error. */
+    auto set_error(int error) && noexcept -> void
+    {
+      self->cancel_timeout_();
+      self->socket_ = {};
+      stdexec::set_error(std::move(self->receiver_), error);
+    }
+
+    /** @brief Completes with set_stopped. */
+    auto set_stopped() && noexcept -> void
+    {
+      self->cancel_timeout_();
+      self->socket_ = {};
+      stdexec::set_stopped(std::move(self->receiver_));
+    }
+
+    /** @returns The environment of the outer receiver. */
+    [[nodiscard]] auto get_env() const noexcept
+    {
+      return stdexec::get_env(self->receiver_);
+    }
+
+    /** @brief The operation. */
+    operation *self;
+  };
+
+  /** @brief The multiplexer wait sender type. */
+  using wait_sender = decltype(std::declval<multiplexer_type &>().set(
+      std::declval<std::shared_ptr<io::socket::socket_handle>>(),
+      io::execution::execution_trigger::WRITE, std::declval<connect_fn>()));
+  /** @brief The multiplexer wait operation type. */
+  using wait_operation = stdexec::connect_result_t<wait_sender, receiver>;
+
+  /**
+   * @brief Constructs an immovable operation state in place from the
+   * result of a function.
+   */
+  template <typename Fn> struct emplace_from {
+    /** @brief The function. */
+    Fn fn;
+    /** @returns The result of the function. */
+    operator std::invoke_result_t<Fn>() && // NOLINT
+    {
+      return std::move(fn)();
+    }
+  };
+
+public:
+  /**
+   * @brief Constructor.
+   * @param sender The sender that is connected.
+   * @param receiver The receiver to complete.
+   */
+  operation(connect_sender &&sender, Receiver receiver) noexcept
+      : ctx_{sender.ctx_}, address_{sender.address_},
+        options_{sender.options_}, socket_{std::move(sender.socket_)},
+        receiver_{std::move(receiver)}
+  {}
+  /** @brief Deleted copy constructor. */
+  operation(const operation &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const operation &) -> operation & = delete;
+
+  /** @brief Starts the connect. */
+  auto start() & noexcept -> void
+  {
+    using enum io::execution::execution_trigger;
+
+    if (!ctx_)
+      return stdexec::set_value(std::move(receiver_), std::move(socket_));
+
+    if (auto error = open_())
+      return stdexec::set_error(std::move(receiver_), error);
+
+    auto mux = socket_.multiplexer.lock();
+    if (!mux)
+      return stdexec::set_error(std::move(receiver_), ENOTCONN);
+
+    try
+    {
+      wait_.emplace(emplace_from{[&] {
+        return stdexec::connect(
+            mux->set(socket_.socket, WRITE, connect_fn{this}),
+            receiver{this});
+      }});
+    }
+    catch (const std::system_error &error)
+    {
+      socket_ = {};
+      return stdexec::set_error(std::move(receiver_), error.code().value());
+    }
+    catch (...)
+    {
+      socket_ = {};
+      return stdexec::set_error(std::move(receiver_), ENOMEM);
+    }
+
+    if (options_.timeout.count() > 0)
+    {
+      timer_ = ctx_->timers.add(options_.timeout,
+                                [this](auto) { on_timeout_(); });
+    }
+    stdexec::start(*wait_);
+  }
+
+  /** @brief Default destructor. */
+  ~operation() = default;
+
+private:
+  /**
+   * @brief Opens a non-blocking socket and starts connecting it.
+   * @returns 0 if the connect is under way, otherwise an errno value.
+   */
+  auto open_() noexcept -> int
+  {
+    using namespace io::socket;
+
+    try
+    {
+      auto sock = socket_handle(address_->sin6_family, SOCK_STREAM, 0);
+      const auto sockfd = static_cast<socket_type>(sock);
+      if (::fcntl(sockfd, F_SETFL, ::fcntl(sockfd, F_GETFL) | O_NONBLOCK))
+        return errno;
+
+      // TCP_NODELAY is best effort, like it is for accepted connections.
+      if (options_.nodelay)
+      {
+        auto nodelay = socket_option<int>(1);
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, nodelay);
+      }
+
+      // sockaddr_in6 starts with its family, like every sockaddr.
+      const auto *addr =
+          reinterpret_cast<const sockaddr *>(&address_->sin6_family);
+      const auto len = address_->sin6_family == AF_INET
+                           ? socklen_t{sizeof(sockaddr_in)}
+                           : socklen_t{sizeof(sockaddr_in6)};
+      if (::connect(sockfd, addr, len) && errno != EINPROGRESS)
+        return errno;
+
+      socket_ = ctx_->poller.emplace(std::move(sock));
+      return 0;
+    }
+    catch (const std::system_error &error)
+    {
+      return error.code().value();
+    }
+    catch (...)
+    {
+      return ENOMEM;
+    }
+  }
+
+  /** @returns 0 once connected, or -1 with errno set. */
+  auto finish_() noexcept -> int
+  {
+    if (timed_out_)
+    {
+      errno = ETIMEDOUT;
+      return -1;
+    }
+
+    auto error = 0;
+    auto len = socklen_t{sizeof(error)};
+    const auto sockfd = static_cast<socket_type>(*socket_.socket);
+    if (::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &len))
+      return -1;
+
+    if (error)
+    {
+      errno = error;
+      return -1;
+    }
+    return 0;
+  }
+
+  /**
+   * @brief Shuts the socket down when the timeout expires, which wakes the
+   * multiplexer wait.
+   */
+  auto on_timeout_() noexcept -> void
+  {
+    timer_ = net::timers::INVALID_TIMER;
+    timed_out_ = true;
+    ::shutdown(static_cast<socket_type>(*socket_.socket), SHUT_RDWR);
+  }
+
+  /** @brief Removes the timeout timer if it is armed. */
+  auto cancel_timeout_() noexcept -> void
+  {
+    if (timer_ != net::timers::INVALID_TIMER)
+      timer_ = ctx_->timers.remove(timer_);
+  }
+
+  /** @brief The context. */
+  async_context *ctx_;
+  /** @brief The address to connect to. */
+  socket_address address_;
+  /** @brief The connection options. */
+  options_type options_;
+  /** @brief The socket. */
+  socket_dialog socket_;
+  /** @brief The receiver. */
+  Receiver receiver_;
+  /** @brief The timeout timer. */
+  net::timers::timer_id timer_ = net::timers::INVALID_TIMER;
+  /** @brief True once the timeout has expired. */
+  bool timed_out_ = false;
+  /** @brief The multiplexer wait. */
+  std::optional<wait_operation> wait_;
+};
+
+template <typename AsyncContext>
+connect_sender<AsyncContext>::connect_sender(async_context &ctx,
+                                             const socket_address &address,
+                                             options_type options) noexcept
+    : ctx_{&ctx}, address_{address}, options_{options}
+{}
+
+template <typename AsyncContext>
+connect_sender<AsyncContext>::connect_sender(socket_dialog socket) noexcept
+    : socket_{std::move(socket)}
+{}
+
+template <typename AsyncContext>
+template <stdexec::receiver Receiver>
+auto connect_sender<AsyncContext>::connect(Receiver receiver) &&
+    -> operation<Receiver>
+{
+  return {std::move(*this), std::move(receiver)};
+}
+
+template <typename Multiplexer, typename Timers>
+auto async_tcp_client<Multiplexer, Timers>::pool_stats::hit_rate()
+    const noexcept -> double
+{
+  const auto checkouts = hits + misses;
+  if (checkouts == 0)
+    return 0.0;
+
+  return static_cast<double>(hits) / static_cast<double>(checkouts);
+}
+
+template <typename Multiplexer, typename Timers>
+async_tcp_client<Multiplexer, Timers>::async_tcp_client(
+    options_type options) noexcept
+    : options_{options}
+{}
+
+template <typename Multiplexer, typename Timers>
+template <typename T>
+auto async_tcp_client<Multiplexer, Timers>::connect(
+    async_context &ctx, const socket_address<T> &address) const -> sender_type
+{
+  return {ctx, socket_address<sockaddr_in6>(address), options_.connect};
+}
+
+template <typename Multiplexer, typename Timers>
+template <typename T>
+auto async_tcp_client<Multiplexer, Timers>::checkout(
+    async_context &ctx, const socket_address<T> &address) -> sender_type
+{
+  const auto dest = socket_address<sockaddr_in6>(address);
+  if (auto it = idle_.find(key_(dest)); it != idle_.end())
+  {
+    // The most recently returned connection is the least likely to have
+    // been closed by the peer.
+    auto &sockets = it->second;
+    while (!sockets.empty())
+    {
+      auto socket = std::move(sockets.back());
+      sockets.pop_back();
+      idle_count_.fetch_sub(1, std::memory_order_relaxed);
+      if (alive_(socket))
+      {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return sender_type(std::move(socket));
+      }
+      discarded_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  return {ctx, dest, options_.connect};
+}
+
+template <typename Multiplexer, typename Timers>
+template <typename T>
+auto async_tcp_client<Multiplexer, Timers>::checkin(
+    const socket_address<T> &address, socket_dialog socket) -> void
+{
+  if (!socket.socket)
+    return;
+
+  auto &sockets = idle_[key_(socket_address<sockaddr_in6>(address))];
+  if (sockets.size() >= options_.max_idle)
+  {
+    discarded_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  sockets.push_back(std::move(socket));
+  idle_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename Multiplexer, typename Timers>
+auto async_tcp_client<Multiplexer, Timers>::clear() -> void
+{
+  idle_.clear();
+  idle_count_.store(0, std::memory_order_relaxed);
+}
+
+template <typename Multiplexer, typename Timers>
+auto async_tcp_client<Multiplexer, Timers>::stats() const noexcept
+    -> pool_stats
+{
+  return {.hits = hits_.load(std::memory_order_relaxed),
+          .misses = misses_.load(std::memory_order_relaxed),
+          .idle = idle_count_.load(std::memory_order_relaxed),
+          .discarded = discarded_.load(std::memory_order_relaxed)};
+}
+
+template <typename Multiplexer, typename Timers>
+auto async_tcp_client<Multiplexer, Timers>::destination_hash::operator()(
+    const destination &dest) const noexcept -> std::size_t
+{
+  const auto *bytes = reinterpret_cast<const char *>(dest.addr.data());
+  auto hash = std::hash<std::string_view>{}({bytes, dest.addr.size()});
+  // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+  const auto rest = (std::uint64_t{dest.scope} << 32U) |
+                    (std::uint64_t{dest.port} << 16U) | dest.family;
+  return hash ^ (std::hash<std::uint64_t>{}(rest) + 0x9e3779b9 + (hash << 6U) +
+                 (hash >> 2U));
+  // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+}
+
+template <typename Multiplexer, typename Timers>
+auto async_tcp_client<Multiplexer, Timers>::key_(
+    const socket_address<sockaddr_in6> &address) noexcept -> destination
+{
+  auto dest = destination{.family = address->sin6_family};
+  if (dest.family == AF_INET)
+  {
+    // A sockaddr_in6 is large enough to hold a sockaddr_in.
+    auto sin = sockaddr_in{};
+    std::memcpy(&sin, &address->sin6_family, sizeof(sin));
+    std::memcpy(dest.addr.data(), &sin.sin_addr, sizeof(sin.sin_addr));
+    dest.port = sin.sin_port;
+    return dest;
+  }
+
+  std::memcpy(dest.addr.data(), &address->sin6_addr, dest.addr.size());
+  dest.scope = address->sin6_scope_id;
+  dest.port = address->sin6_port;
+  return dest;
+}
+
+template <typename Multiplexer, typename Timers>
+auto async_tcp_client<Multiplexer, Timers>::alive_(
+    const socket_dialog &socket) noexcept -> bool
+{
+  // An open connection with nothing to read would block. End of file, an
+  // error or a stray byte all mean it can't carry another request.
+  auto byte = char{};
+  const auto sockfd =
+      static_cast<io::socket::native_socket_type>(*socket.socket);
+  return ::recv(sockfd, &byte, 1, MSG_PEEK | MSG_DONTWAIT) < 0 &&
+         (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+} // namespace net::service
+#endif // CPPNET_ASYNC_TCP_CLIENT_IMPL_HPP
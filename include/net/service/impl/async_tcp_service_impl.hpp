@@ -22,18 +22,98 @@
 #define CPPNET_ASYNC_TCP_SERVICE_IMPL_HPP
 #include "net/service/async_tcp_service.hpp"
 
+#include <algorithm>
+#include <cerrno>
 #include <system_error>
+#include <utility>
+
+#if __has_include(<sys/ioctl.h>)
+#include <sys/ioctl.h>
+#endif
+
+#if __has_include(<netinet/tcp.h>)
+#include <netinet/tcp.h>
+#endif
+
+#if !defined(SOCK_NONBLOCK)
+#include <fcntl.h>
+#endif
 namespace net::service {
-template <typename TCPStreamHandler, std::size_t Size>
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+async_tcp_service<TCPStreamHandler, Size, Multiplexer, Timers>::read_context::
+    read_context(std::shared_ptr<net::detail::buffer_pool> pool,
+                 size_type size) noexcept
+    : next_size{size}, pool_{std::move(pool)}
+{}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::read_context::reserve(size_type size) -> void
+{
+  if (!buffer.empty())
+    return;
+
+  buffer = pool_->acquire(size);
+  msg = socket_message{.buffers = buffer};
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::read_context::release() noexcept -> void
+{
+  if (buffer.empty())
+    return;
+
+  pool_->release(std::exchange(buffer, {}));
+  msg = socket_message{.buffers = buffer};
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::read_context::fit(size_type len) noexcept
+    -> void
+{
+  const auto size = buffer.size();
+  if (len >= size)
+    next_size = std::min(size * 2, pool_->max_size());
+  else if (len <= size / 4)
+    next_size = std::max(size / 2, pool_->min_size());
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                  Timers>::read_context::~read_context()
+{
+  release();
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
 template <typename T>
-async_tcp_service<TCPStreamHandler, Size>::async_tcp_service(
-    socket_address<T> address) noexcept
+async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                  Timers>::async_tcp_service(socket_address<T>
+                                                  address) noexcept
     : address_{address}
 {}
 
-template <typename TCPStreamHandler, std::size_t Size>
-auto async_tcp_service<TCPStreamHandler, Size>::signal_handler(
-    int signum) noexcept -> void
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+template <typename T>
+async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                  Timers>::async_tcp_service(socket_address<T> address,
+                                             options_type options)
+    : address_{address}, options_{options}
+{}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::signal_handler(int signum) noexcept -> void
 {
   if (signum == terminate)
   {
@@ -48,15 +128,16 @@ auto async_tcp_service<TCPStreamHandler, Size>::signal_handler(
   }
 }
 
-template <typename TCPStreamHandler, std::size_t Size>
-auto async_tcp_service<TCPStreamHandler, Size>::start(
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer, Timers>::start(
     async_context &ctx) noexcept -> void
 {
   using namespace io;
   using namespace io::socket;
 
   auto sock = socket_handle(address_->sin6_family, SOCK_STREAM, 0);
-  if (auto error = initialize_(sock))
+  if (auto error = initialize_(sock, ctx.reuse_port))
   {
     ctx.scope.request_stop();
     return;
@@ -67,59 +148,577 @@ auto async_tcp_service<TCPStreamHandler, Size>::start(
   acceptor(ctx, ctx.poller.emplace(std::move(sock)));
 }
 
-template <typename TCPStreamHandler, std::size_t Size>
-auto async_tcp_service<TCPStreamHandler, Size>::acceptor(
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer, Timers>::acceptor(
     async_context &ctx, const socket_dialog &socket) -> void
 {
   using namespace stdexec;
 
-  sender auto accept = io::accept(socket) | then([&, socket](auto accepted) {
-                         auto [dialog, addr] = std::move(accepted);
-                         emit(ctx, dialog, std::make_shared<read_context>());
-                         acceptor(ctx, socket);
-                       }) |
-                       upon_error([](auto &&error) {});
+  if constexpr (net::execution::CompletionMultiplexer<Multiplexer>)
+  {
+    // Completion multiplexers accept the connection in the kernel, so
+    // there is no separate readiness wait before each accept.
+    auto mux = socket.multiplexer.lock();
+    if (!mux)
+      return;
+
+    sender auto accept =
+        mux->accept(socket.socket) | then([&, socket](int accepted) {
+          on_accept_(ctx, ctx.poller.emplace(accepted));
+          // Drain whatever else is already queued without another round
+          // trip through the ring.
+          if (const auto budget = options_.accept_budget; budget > 1)
+          {
+            const auto listener = static_cast<socket_type>(*socket.socket);
+            if (accept_batch_(listener, budget - 1) > 0)
+              emit_accepted_(ctx);
+          }
+          acceptor(ctx, socket);
+        }) |
+        upon_error([](auto &&error) {});
+
+    ctx.scope.spawn(std::move(accept));
+  }
+  else
+  {
+    if (const auto budget = options_.accept_budget; budget > 1)
+    {
+      using enum io::execution::execution_trigger;
+
+      auto mux = socket.multiplexer.lock();
+      if (!mux)
+        return;
+
+      const auto listener = static_cast<socket_type>(*socket.socket);
+      auto exec = [this, listener, budget] {
+        return accept_batch_(listener, budget);
+      };
+      sender auto accept = mux->set(socket.socket, READ, std::move(exec)) |
+                           then([&, socket](int) {
+                             emit_accepted_(ctx);
+                             acceptor(ctx, socket);
+                           }) |
+                           upon_error([](auto &&error) {});
+
+      ctx.scope.spawn(std::move(accept));
+      return;
+    }
 
-  ctx.scope.spawn(std::move(accept));
+    sender auto accept = io::accept(socket) | then([&, socket](auto accepted) {
+                           auto [dialog, addr] = std::move(accepted);
+                           on_accept_(ctx, dialog);
+                           acceptor(ctx, socket);
+                         }) |
+                         upon_error([](auto &&error) {});
+
+    ctx.scope.spawn(std::move(accept));
+  }
 }
 
-template <typename TCPStreamHandler, std::size_t Size>
-auto async_tcp_service<TCPStreamHandler, Size>::submit_recv(
-    async_context &ctx, const socket_dialog &socket,
-    std::shared_ptr<read_context> rctx) -> void
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::accept_batch_(socket_type socket,
+                                              std::size_t budget) -> int
+{
+  accepted_.clear();
+  while (accepted_.size() < budget)
+  {
+#ifdef SOCK_NONBLOCK
+    auto accepted =
+        ::accept4(socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+    auto accepted = ::accept(socket, nullptr, nullptr);
+    if (accepted >= 0)
+      ::fcntl(accepted, F_SETFL, ::fcntl(accepted, F_GETFL) | O_NONBLOCK);
+#endif
+    if (accepted < 0)
+    {
+      // Connections that were reset while queued are skipped.
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+
+      break;
+    }
+    accepted_.push_back(accepted);
+  }
+
+  // Returning -1 with errno set to EAGAIN re-arms the readiness wait.
+  return accepted_.empty() ? -1 : static_cast<int>(accepted_.size());
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::emit_accepted_(async_context &ctx) -> void
+{
+  for (auto accepted : accepted_)
+    on_accept_(ctx, ctx.poller.emplace(accepted));
+
+  accepted_.clear();
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::on_accept_(async_context &ctx,
+                                           const socket_dialog &socket) -> void
+{
+  using namespace io;
+  using namespace io::socket;
+
+  // Connection options are best effort, a connection that can't take
+  // them is still served.
+  if (options_.tcp.nodelay)
+  {
+    auto nodelay = socket_option<int>(1);
+    setsockopt(*socket.socket, IPPROTO_TCP, TCP_NODELAY, nodelay);
+  }
+
+  track_(ctx, socket);
+  emit(ctx, socket, make_read_context_());
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::submit_recv(async_context &ctx,
+                                            const socket_dialog &socket,
+                                            std::shared_ptr<read_context> rctx)
+    -> void
 {
   using namespace stdexec;
   using namespace io::socket;
-  if (!rctx)
+  if (!rctx || pause_reads_(ctx, socket, rctx))
     return;
 
-  sender auto recvmsg =
-      io::recvmsg(socket, rctx->msg, 0) |
-      then([&, socket, rctx](auto &&len) mutable {
-        if (!len)
-          return emit(ctx, socket);
+  auto on_recv = [&, socket, rctx](auto &&len) mutable {
+    if (!len)
+      return emit(ctx, socket);
+
+    touch_(socket);
+    if (options_.read_buffers.adaptive)
+      rctx->fit(static_cast<std::size_t>(len));
+
+    auto buf = std::span{rctx->buffer.data(), static_cast<std::size_t>(len)};
+    emit(ctx, socket, std::move(rctx), buf);
+  };
+  auto on_error = [&, socket](auto &&error) { emit(ctx, socket); };
+
+  if constexpr (net::execution::CompletionMultiplexer<Multiplexer>)
+  {
+    auto mux = socket.multiplexer.lock();
+    if (!mux)
+      return emit(ctx, socket);
+
+    // The kernel writes into the buffer whenever data arrives, so the
+    // buffer stays reserved while the receive is pending.
+    const auto adaptive = options_.read_buffers.adaptive;
+    if (adaptive && rctx->buffer.size() != rctx->next_size)
+    {
+      rctx->release();
+      rctx->reserve(rctx->next_size);
+    }
+
+    sender auto recvmsg = mux->recvmsg(socket.socket, rctx->buffer, 0) |
+                          then(std::move(on_recv)) |
+                          upon_error(std::move(on_error));
+
+    ctx.scope.spawn(std::move(recvmsg));
+  }
+  else if (options_.read_buffers.adaptive)
+  {
+    using enum io::execution::execution_trigger;
+
+    auto mux = socket.multiplexer.lock();
+    if (!mux)
+      return emit(ctx, socket);
+
+    // An idle connection holds no buffer until its socket is readable.
+    rctx->release();
+    const auto sockfd = static_cast<socket_type>(*socket.socket);
+    auto exec = [this, rctx, sockfd] { return adaptive_recv_(*rctx, sockfd); };
+    sender auto recv = mux->set(socket.socket, READ, std::move(exec)) |
+                       then(std::move(on_recv)) |
+                       upon_error(std::move(on_error));
+
+    ctx.scope.spawn(std::move(recv));
+  }
+  else
+  {
+    sender auto recvmsg = io::recvmsg(socket, rctx->msg, 0) |
+                          then(std::move(on_recv)) |
+                          upon_error(std::move(on_error));
+
+    ctx.scope.spawn(std::move(recvmsg));
+  }
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+template <typename Message>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::send_zerocopy(async_context &ctx,
+                                              const socket_dialog &socket,
+                                              const std::shared_ptr<
+                                                  read_context> &rctx,
+                                              Message msg)
+{
+  if (!rctx->zerocopy)
+    rctx->zerocopy = std::make_shared<zerocopy_type>();
+
+  return rctx->zerocopy->send(ctx, socket, std::move(msg), MSG_NOSIGNAL);
+}
 
-        auto buf =
-            std::span{rctx->buffer.data(), static_cast<std::size_t>(len)};
-        emit(ctx, socket, std::move(rctx), buf);
-      }) |
-      upon_error([&, socket](auto &&error) { emit(ctx, socket); });
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer, Timers>::enqueue(
+    async_context &ctx, const socket_dialog &socket,
+    const std::shared_ptr<read_context> &rctx,
+    typename write_queue_type::buffer_type buffer) -> void
+{
+  if (!rctx->writes)
+  {
+    rctx->writes =
+        std::make_shared<write_queue_type>(options_.writes, write_budget_);
+  }
 
-  ctx.scope.spawn(std::move(recvmsg));
+  rctx->writes->push(ctx, socket, std::move(buffer));
 }
 
-template <typename TCPStreamHandler, std::size_t Size>
-auto async_tcp_service<TCPStreamHandler, Size>::emit(
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer, Timers>::enqueue(
+    async_context &ctx, const socket_dialog &socket,
+    const std::shared_ptr<read_context> &rctx,
+    std::span<const std::byte> buffer) -> void
+{
+  using buffer_type = typename write_queue_type::buffer_type;
+  enqueue(ctx, socket, rctx, buffer_type(buffer.begin(), buffer.end()));
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::read_pool_stats() const noexcept -> pool_stats
+{
+  return read_pool_->stats();
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::read_buffer_stats() const noexcept
+    -> buffer_stats
+{
+  return buffer_pool_->stats();
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::write_queue_stats() const noexcept
+    -> write_stats
+{
+  return {.queued = write_budget_->queued(),
+          .paused = paused_.load(std::memory_order_relaxed)};
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::header_received(const socket_dialog
+                                                    &socket) noexcept -> void
+{
+  const auto fd = static_cast<std::size_t>(
+      static_cast<socket_type>(*socket.socket));
+  if (fd < connections_.size())
+    connections_[fd].header_deadline = net::timers::timestamp::max();
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::reaper_stats() const noexcept -> reap_stats
+{
+  return {.tracked = tracked_.load(std::memory_order_relaxed),
+          .expired = expired_.load(std::memory_order_relaxed)};
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer, Timers>::track_(
+    async_context &ctx, const socket_dialog &socket) -> void
+{
+  const auto &limits = options_.timeouts;
+  if (limits.idle.count() <= 0 && limits.header.count() <= 0)
+    return;
+
+  const auto fd = static_cast<std::size_t>(
+      static_cast<socket_type>(*socket.socket));
+  if (fd >= connections_.size())
+    connections_.resize(fd + 1);
+
+  // A descriptor is only reused after its last connection closed, so a
+  // timer that is still armed belongs to that connection.
+  auto &entry = connections_[fd];
+  if (entry.timer != net::timers::INVALID_TIMER)
+  {
+    entry.timer = ctx.timers.remove(entry.timer);
+    tracked_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  const auto now = net::timers::clock::now();
+  entry.last_active = now;
+  entry.header_deadline = limits.header.count() > 0
+                              ? now + limits.header
+                              : net::timers::timestamp::max();
+  entry.expired = false;
+  arm_deadline_(ctx, socket.socket, deadline_(entry));
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer, Timers>::untrack_(
+    async_context &ctx, const socket_dialog &socket) -> void
+{
+  const auto fd = static_cast<std::size_t>(
+      static_cast<socket_type>(*socket.socket));
+  if (fd >= connections_.size())
+    return;
+
+  auto &entry = connections_[fd];
+  if (entry.timer != net::timers::INVALID_TIMER)
+  {
+    ctx.timers.remove(entry.timer);
+    tracked_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  entry = {};
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer, Timers>::touch_(
+    const socket_dialog &socket) noexcept -> void
+{
+  if (options_.timeouts.idle.count() <= 0)
+    return;
+
+  const auto fd = static_cast<std::size_t>(
+      static_cast<socket_type>(*socket.socket));
+  if (fd < connections_.size())
+    connections_[fd].last_active = net::timers::clock::now();
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::deadline_(const connection_entry &entry)
+    const noexcept -> net::timers::timestamp
+{
+  const auto idle = options_.timeouts.idle;
+  if (idle.count() <= 0)
+    return entry.header_deadline;
+
+  return std::min(entry.last_active + idle, entry.header_deadline);
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::arm_deadline_(async_context &ctx,
+                                              const std::shared_ptr<
+                                                  socket_handle> &socket,
+                                              net::timers::timestamp when)
+    -> void
+{
+  const auto fd = static_cast<std::size_t>(static_cast<socket_type>(*socket));
+  auto expire = [this, &ctx, fd, socket = std::weak_ptr(socket)](auto tid) {
+    on_deadline_(ctx, tid, fd, socket);
+  };
+
+  connections_[fd].timer = ctx.timers.add(when, std::move(expire));
+  tracked_.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::on_deadline_(async_context &ctx,
+                                             net::timers::timer_id tid,
+                                             std::size_t fd,
+                                             const std::weak_ptr<
+                                                 socket_handle> &socket)
+    -> void
+{
+  using namespace io::socket;
+
+  if (fd >= connections_.size() || connections_[fd].timer != tid)
+    return;
+
+  auto &entry = connections_[fd];
+  entry.timer = net::timers::INVALID_TIMER;
+  tracked_.fetch_sub(1, std::memory_order_relaxed);
+
+  // The socket is gone once its connection closed.
+  auto handle = socket.lock();
+  if (!handle)
+    return;
+
+  // Reads push the idle deadline back without re-arming the timer, so the
+  // timer re-arms itself until the connection really misses a deadline.
+  const auto when = deadline_(entry);
+  if (when == net::timers::timestamp::max())
+    return;
+
+  if (net::timers::clock::now() < when)
+    return arm_deadline_(ctx, handle, when);
+
+  // The pending read completes with end of file, so the stream handler
+  // closes the connection and its buffers go back to the pools.
+  entry.expired = true;
+  expired_.fetch_add(1, std::memory_order_relaxed);
+  shutdown(static_cast<socket_type>(*handle), SHUT_RDWR);
+
+  // A paused connection has no pending read until its writes drain.
+  if (fd < paused_reads_.size())
+  {
+    if (auto rctx = paused_reads_[fd].rctx)
+      resume_reads_(ctx, fd, rctx);
+  }
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::pause_reads_(async_context &ctx,
+                                             const socket_dialog &socket,
+                                             const std::shared_ptr<
+                                                 read_context> &rctx) -> bool
+{
+  const auto fd = static_cast<std::size_t>(
+      static_cast<socket_type>(*socket.socket));
+  // An expired connection reads until it sees the shutdown.
+  if (fd < connections_.size() && connections_[fd].expired)
+    return false;
+
+  const auto &limits = options_.backpressure;
+  const auto &writes = rctx->writes;
+  const bool connection =
+      limits.high_water > 0 && writes && writes->queued() > limits.high_water;
+  if (!connection && !write_budget_->exceeded())
+    return false;
+
+  // A paused connection holds no adaptive read buffer.
+  if (options_.read_buffers.adaptive)
+    rctx->release();
+
+  if (fd >= paused_reads_.size())
+    paused_reads_.resize(fd + 1);
+
+  // The read context owns its write queue, so the callback must not own
+  // the read context.
+  paused_reads_[fd] = {.socket = socket, .rctx = rctx};
+  paused_.fetch_add(1, std::memory_order_relaxed);
+  auto resume = [this, &ctx, fd, weak = std::weak_ptr(rctx)] {
+    if (auto paused = weak.lock())
+      resume_reads_(ctx, fd, paused);
+  };
+
+  if (connection)
+  {
+    writes->on_low_water(std::min(limits.low_water, limits.high_water),
+                         std::move(resume));
+  }
+  else
+  {
+    write_budget_->wait(std::move(resume));
+  }
+  return true;
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::resume_reads_(async_context &ctx,
+                                              std::size_t fd,
+                                              const std::shared_ptr<
+                                                  read_context> &rctx) -> void
+{
+  if (!rctx || fd >= paused_reads_.size() || paused_reads_[fd].rctx != rctx)
+    return;
+
+  auto paused = std::exchange(paused_reads_[fd], {});
+  paused_.fetch_sub(1, std::memory_order_relaxed);
+  submit_recv(ctx, paused.socket, std::move(paused.rctx));
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::make_read_context_()
+    -> std::shared_ptr<read_context>
+{
+  using allocator = net::detail::slab_allocator<read_context>;
+  if (options_.read_buffers.adaptive)
+  {
+    return std::allocate_shared<read_context>(
+        allocator(read_pool_), buffer_pool_, buffer_pool_->min_size());
+  }
+
+  auto rctx = std::allocate_shared<read_context>(allocator(read_pool_),
+                                                 buffer_pool_, Size);
+  rctx->reserve(Size);
+  return rctx;
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::adaptive_recv_(read_context &rctx,
+                                               socket_type socket) -> ssize_t
+{
+  auto size = rctx.next_size;
+#ifdef FIONREAD
+  if (int pending = 0; options_.read_buffers.use_fionread &&
+                       ::ioctl(socket, FIONREAD, &pending) == 0 && pending > 0)
+  {
+    size = std::max(size, static_cast<std::size_t>(pending));
+  }
+#endif
+
+  rctx.reserve(size);
+  auto len = ::recv(socket, rctx.buffer.data(), rctx.buffer.size(), 0);
+  if (len < 0)
+  {
+    // Spurious wakeups must not pin a buffer to an idle connection.
+    const auto error = errno;
+    rctx.release();
+    errno = error;
+  }
+  return len;
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer, Timers>::emit(
     async_context &ctx, const socket_dialog &socket,
     std::shared_ptr<read_context> rctx, std::span<const std::byte> buf) -> void
 {
+  // The stream handler closes the connection when it has no read context.
+  if (!rctx)
+    untrack_(ctx, socket);
+
   static_cast<TCPStreamHandler *>(this)->service(ctx, socket, std::move(rctx),
                                                  buf);
 }
 
-template <typename TCPStreamHandler, std::size_t Size>
-auto async_tcp_service<TCPStreamHandler, Size>::initialize_(
-    const socket_handle &socket) -> std::error_code
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::initialize_(const socket_handle &socket,
+                                            bool reuse_port) -> std::error_code
 {
   using namespace io;
   using namespace io::socket;
@@ -130,6 +729,19 @@ auto async_tcp_service<TCPStreamHandler, Size>::initialize_(
     return {errno, std::system_category()};
   }
 
+  if (reuse_port)
+  {
+#ifdef SO_REUSEPORT
+    if (auto reuse = socket_option<int>(1);
+        setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, reuse))
+    {
+      return {errno, std::system_category()};
+    }
+#else
+    return std::make_error_code(std::errc::operation_not_supported);
+#endif
+  }
+
   if constexpr (requires(TCPStreamHandler handler) {
                   {
                     handler.initialize(socket)
@@ -140,25 +752,83 @@ auto async_tcp_service<TCPStreamHandler, Size>::initialize_(
       return error;
   }
 
+  if (auto error = set_listener_options_(socket))
+    return error;
+
   if (bind(socket, address_))
     return {errno, std::system_category()};
 
   address_ = getsockname(socket, address_);
 
-  if (listen(socket, SOMAXCONN))
+  if (listen(socket, options_.tcp.backlog))
     return {errno, std::system_category()};
 
   return {};
 }
 
-template <typename TCPStreamHandler, std::size_t Size>
-auto async_tcp_service<TCPStreamHandler, Size>::stop_() -> void
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer, Timers>::
+    set_listener_options_(const socket_handle &socket) -> std::error_code
+{
+  using namespace io;
+  using namespace io::socket;
+
+  const auto &tcp = options_.tcp;
+  if (tcp.defer_accept > 0)
+  {
+#ifdef TCP_DEFER_ACCEPT
+    if (auto timeout = socket_option<int>(tcp.defer_accept);
+        setsockopt(socket, IPPROTO_TCP, TCP_DEFER_ACCEPT, timeout))
+    {
+      return {errno, std::system_category()};
+    }
+#else
+    return std::make_error_code(std::errc::operation_not_supported);
+#endif
+  }
+
+  if (tcp.fastopen > 0)
+  {
+#ifdef TCP_FASTOPEN
+    if (auto qlen = socket_option<int>(tcp.fastopen);
+        setsockopt(socket, IPPROTO_TCP, TCP_FASTOPEN, qlen))
+    {
+      return {errno, std::system_category()};
+    }
+#else
+    return std::make_error_code(std::errc::operation_not_supported);
+#endif
+  }
+
+  // Some platforms copy TCP_NODELAY from the listener to accepted
+  // connections, on_accept_ sets it explicitly for the rest.
+  if (tcp.nodelay)
+  {
+    if (auto nodelay = socket_option<int>(1);
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, nodelay))
+    {
+      return {errno, std::system_category()};
+    }
+  }
+
+  return {};
+}
+
+template <typename TCPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_tcp_service<TCPStreamHandler, Size, Multiplexer,
+                       Timers>::stop_() -> void
 {
   using namespace io::socket;
 
   auto sockfd = acceptor_sockfd_.exchange(INVALID_SOCKET);
   if (sockfd != INVALID_SOCKET)
     shutdown(sockfd, SHUT_RD);
+
+  // Paused connections would otherwise keep the event loop running.
+  paused_reads_.clear();
+  paused_.store(0, std::memory_order_relaxed);
 }
 
 } // namespace net::service
@@ -21,66 +21,345 @@
 #ifndef CPPNET_ASYNC_UDP_SERVICE_IMPL_HPP
 #define CPPNET_ASYNC_UDP_SERVICE_IMPL_HPP
 #include "net/service/async_udp_service.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
 namespace net::service {
 
-template <typename UDPStreamHandler, std::size_t Size>
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+template <typename Fn>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer, Timers>::
+    read_context::for_each_segment(std::span<const std::byte> buf,
+                                   Fn &&func) const -> void
+{
+  for_each_segment_(buf, segment_size, std::forward<Fn>(func));
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+template <typename Fn>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer, Timers>::
+    read_batch::slot::for_each_segment(std::span<const std::byte> buf,
+                                       Fn &&func) const -> void
+{
+  for_each_segment_(buf, segment_size, std::forward<Fn>(func));
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                  Timers>::read_batch::read_batch(size_type size,
+                                                  size_type datagram_size)
+    : slots(std::max(size, size_type{1})), headers(slots.size()),
+      iovecs(slots.size())
+{
+  datagram_size = std::max(datagram_size, size_type{1});
+  storage.resize(slots.size() * datagram_size);
+  for (size_type i = 0; i < slots.size(); ++i)
+  {
+    slots[i].buffer =
+        std::span(storage).subspan(i * datagram_size, datagram_size);
+  }
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::read_batch::size() const noexcept -> size_type
+{
+  return count;
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::read_batch::buffer(size_type index)
+    const noexcept -> std::span<const std::byte>
+{
+  return {slots[index].buffer.data(), headers[index].msg_len};
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+template <typename Fn>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::for_each_segment_(std::span<const std::byte>
+                                                      buf,
+                                                  std::size_t segment_size,
+                                                  Fn &&func) -> void
+{
+  if (segment_size == 0 || buf.size() <= segment_size)
+    return std::forward<Fn>(func)(buf);
+
+  for (std::size_t offset = 0; offset < buf.size(); offset += segment_size)
+    func(buf.subspan(offset, std::min(segment_size, buf.size() - offset)));
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
 template <typename T>
-async_udp_service<UDPStreamHandler, Size>::async_udp_service(
-    socket_address<T> address) noexcept
+async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                  Timers>::async_udp_service(socket_address<T>
+                                                  address) noexcept
     : address_{address}
 {}
 
-template <typename UDPStreamHandler, std::size_t Size>
-auto async_udp_service<UDPStreamHandler, Size>::signal_handler(
-    int signum) noexcept -> void
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+template <typename T>
+async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                  Timers>::async_udp_service(socket_address<T> address,
+                                             options_type options)
+    : address_{address}, options_{options}
+{}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::signal_handler(int signum) noexcept -> void
 {
   if (signum == terminate)
     stop_();
 }
 
-template <typename UDPStreamHandler, std::size_t Size>
-auto async_udp_service<UDPStreamHandler, Size>::start(
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer, Timers>::start(
     async_context &ctx) noexcept -> void
 {
   using namespace io;
   using namespace io::socket;
 
+  // Batches are emitted to the read_batch overload of the stream handler,
+  // so a handler without one can't read batches.
+  constexpr auto batched = requires(UDPStreamHandler handler,
+                                    socket_dialog socket) {
+    handler.service(ctx, socket, std::shared_ptr<read_batch>());
+  };
+  if (options_.recv_batch > 1 && !batched)
+  {
+    ctx.scope.request_stop();
+    return;
+  }
+
+  const auto read_size =
+      (options_.recv_batch > 1) ? options_.datagram_size : Size;
+  if (options_.gro && read_size < GRO_READ_SIZE)
+  {
+    ctx.scope.request_stop();
+    return;
+  }
+
   auto sock = socket_handle(address_->sin6_family, SOCK_DGRAM, 0);
-  if (auto error = initialize_(sock))
+  if (auto error = initialize_(sock, ctx.reuse_port))
   {
     ctx.scope.request_stop();
     return;
   }
 
   server_sockfd_ = static_cast<socket_type>(sock);
+  auto socket = ctx.poller.emplace(std::move(sock));
 
-  submit_recv(ctx, ctx.poller.emplace(std::move(sock)),
-              std::make_shared<read_context>());
+  // Every read in flight owns its buffer and is re-armed on its own.
+  const auto depth = std::max(options_.recv_depth, std::size_t{1});
+  if constexpr (batched)
+  {
+    if (options_.recv_batch > 1)
+    {
+      for (std::size_t i = 0; i < depth; ++i)
+      {
+        submit_recv(ctx, socket,
+                    std::make_shared<read_batch>(options_.recv_batch,
+                                                 options_.datagram_size));
+      }
+      return;
+    }
+  }
+
+  for (std::size_t i = 0; i < depth; ++i)
+    submit_recv(ctx, socket, std::make_shared<read_context>());
 }
 
-template <typename UDPStreamHandler, std::size_t Size>
-auto async_udp_service<UDPStreamHandler, Size>::submit_recv(
-    async_context &ctx, const socket_dialog &socket,
-    std::shared_ptr<read_context> rctx) -> void
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::submit_recv(async_context &ctx,
+                                            const socket_dialog &socket,
+                                            std::shared_ptr<read_context> rctx)
+    -> void
 {
   using namespace stdexec;
   using namespace io::socket;
 
-  sender auto recvmsg =
-      io::recvmsg(socket, rctx->msg, 0) |
-      then([&, socket, rctx](auto &&len) mutable {
-        using size_type = std::size_t;
+  auto on_recv = [&, socket, rctx](auto &&len) mutable {
+    using size_type = std::size_t;
+
+    if constexpr (net::execution::CompletionMultiplexer<Multiplexer>)
+      peer_address_(*rctx->msg.address, rctx->address_size);
+
+    auto buf = std::span{rctx->buffer.data(), static_cast<size_type>(len)};
+    emit(ctx, socket, std::move(rctx), buf);
+  };
+  auto on_error = [&, socket](auto &&error) { emit(ctx, socket); };
+
+  if constexpr (net::execution::CompletionMultiplexer<Multiplexer>)
+  {
+    auto mux = socket.multiplexer.lock();
+    if (!mux)
+      return emit(ctx, socket);
+
+    auto *address =
+        reinterpret_cast<sockaddr *>(std::addressof(**rctx->msg.address));
+    rctx->address_size = sizeof(sockaddr_in6);
+    sender auto recvmsg =
+        mux->recvmsg(socket.socket, rctx->buffer, 0, address,
+                     &rctx->address_size) |
+        then(std::move(on_recv)) | upon_error(std::move(on_error));
+
+    ctx.scope.spawn(std::move(recvmsg));
+  }
+  else
+  {
+    using enum io::execution::execution_trigger;
+
+    if (options_.gro)
+    {
+      auto mux = socket.multiplexer.lock();
+      if (!mux)
+        return emit(ctx, socket);
+
+      const auto sockfd = static_cast<socket_type>(*socket.socket);
+      auto exec = [rctx, sockfd] { return recv_gro_(*rctx, sockfd); };
+      sender auto recv = mux->set(socket.socket, READ, std::move(exec)) |
+                         then(std::move(on_recv)) |
+                         upon_error(std::move(on_error));
+
+      ctx.scope.spawn(std::move(recv));
+      return;
+    }
 
-        auto buf = std::span{rctx->buffer.data(), static_cast<size_type>(len)};
-        emit(ctx, socket, std::move(rctx), buf);
-      }) |
-      upon_error([&, socket](auto &&error) { emit(ctx, socket); });
+    sender auto recvmsg = io::recvmsg(socket, rctx->msg, 0) |
+                          then(std::move(on_recv)) |
+                          upon_error(std::move(on_error));
 
-  ctx.scope.spawn(std::move(recvmsg));
+    ctx.scope.spawn(std::move(recvmsg));
+  }
 }
 
-template <typename UDPStreamHandler, std::size_t Size>
-auto async_udp_service<UDPStreamHandler, Size>::emit(
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::submit_recv(async_context &ctx,
+                                            const socket_dialog &socket,
+                                            std::shared_ptr<read_batch> batch)
+    -> void
+{
+  using namespace stdexec;
+
+  auto on_error = [&, socket](auto &&error) {
+    emit(ctx, socket, std::shared_ptr<read_batch>());
+  };
+
+  auto mux = socket.multiplexer.lock();
+  if (!mux)
+    return emit(ctx, socket, std::shared_ptr<read_batch>());
+
+  if constexpr (net::execution::CompletionMultiplexer<Multiplexer>)
+  {
+    // Completion multiplexers have no recvmmsg, so the batch is filled one
+    // datagram at a time.
+    auto &slot = batch->slots.front();
+    auto *address =
+        reinterpret_cast<sockaddr *>(std::addressof(**slot.msg.address));
+    auto &header = batch->headers.front().msg_hdr;
+    header.msg_namelen = sizeof(sockaddr_in6);
+    sender auto recvmsg =
+        mux->recvmsg(socket.socket, slot.buffer, 0, address,
+                     &header.msg_namelen) |
+        then([&, socket, batch](auto &&len) mutable {
+          auto &header = batch->headers.front();
+          peer_address_(*batch->slots.front().msg.address,
+                        header.msg_hdr.msg_namelen);
+          header.msg_len = static_cast<unsigned>(len);
+          batch->count = 1;
+          emit(ctx, socket, std::move(batch));
+        }) |
+        upon_error(std::move(on_error));
+
+    ctx.scope.spawn(std::move(recvmsg));
+  }
+  else
+  {
+    using enum io::execution::execution_trigger;
+
+    const auto sockfd = static_cast<socket_type>(*socket.socket);
+    auto exec = [batch, sockfd] { return recv_batch_(*batch, sockfd); };
+    sender auto recv = mux->set(socket.socket, READ, std::move(exec)) |
+                       then([&, socket, batch](auto &&count) mutable {
+                         batch->count = static_cast<std::size_t>(count);
+                         emit(ctx, socket, std::move(batch));
+                       }) |
+                       upon_error(std::move(on_error));
+
+    ctx.scope.spawn(std::move(recv));
+  }
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+template <typename Message>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::send_zerocopy(async_context &ctx,
+                                              const socket_dialog &socket,
+                                              Message msg)
+{
+  if (!zerocopy_)
+    zerocopy_ = std::make_shared<zerocopy_type>();
+
+  return zerocopy_->send(ctx, socket, std::move(msg));
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer, Timers>::enqueue(
+    async_context &ctx, const socket_dialog &socket,
+    const socket_address<sockaddr_in6> &address,
+    typename datagram_queue_type::buffer_type buffer,
+    std::size_t segment_size) -> void
+{
+  if (!sends_)
+    sends_ = std::make_shared<datagram_queue_type>(options_.sends);
+
+  sends_->push(ctx, socket, address, std::move(buffer), segment_size);
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer, Timers>::enqueue(
+    async_context &ctx, const socket_dialog &socket,
+    const socket_address<sockaddr_in6> &address,
+    std::span<const std::byte> buffer, std::size_t segment_size) -> void
+{
+  using buffer_type = typename datagram_queue_type::buffer_type;
+  enqueue(ctx, socket, address, buffer_type(buffer.begin(), buffer.end()),
+          segment_size);
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::send_queue() const noexcept
+    -> const std::shared_ptr<datagram_queue_type> &
+{
+  return sends_;
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer, Timers>::emit(
     async_context &ctx, const socket_dialog &socket,
     std::shared_ptr<read_context> rctx, std::span<const std::byte> buf) -> void
 {
@@ -88,9 +367,175 @@ auto async_udp_service<UDPStreamHandler, Size>::emit(
                                                  buf);
 }
 
-template <typename UDPStreamHandler, std::size_t Size>
-[[nodiscard]] auto async_udp_service<UDPStreamHandler, Size>::initialize_(
-    const socket_handle &socket) -> std::error_code
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer, Timers>::emit(
+    async_context &ctx, const socket_dialog &socket,
+    std::shared_ptr<read_batch> batch) -> void
+{
+  static_cast<UDPStreamHandler *>(this)->service(ctx, socket,
+                                                 std::move(batch));
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::recv_batch_(read_batch &batch,
+                                            socket_type socket) -> int
+{
+  // The last read may have moved the slots, so the headers point into
+  // them again.
+  for (std::size_t i = 0; i < batch.headers.size(); ++i)
+  {
+    auto &slot = batch.slots[i];
+    batch.iovecs[i] = {.iov_base = slot.buffer.data(),
+                       .iov_len = slot.buffer.size()};
+
+    auto &hdr = batch.headers[i].msg_hdr;
+    hdr.msg_name = std::addressof(**slot.msg.address);
+    hdr.msg_namelen = sizeof(sockaddr_in6);
+    hdr.msg_iov = &batch.iovecs[i];
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = slot.control.data();
+    hdr.msg_controllen = slot.control.size();
+  }
+
+  auto parse = [&](int count) {
+    auto kept = 0;
+    for (auto i = 0; i < count; ++i)
+    {
+      auto &hdr = batch.headers[i].msg_hdr;
+      if (hdr.msg_flags & MSG_TRUNC)
+        continue;
+
+      auto &slot = batch.slots[i];
+      peer_address_(*slot.msg.address, hdr.msg_namelen);
+      slot.segment_size = segment_size_(hdr);
+      if (kept != i)
+      {
+        std::swap(batch.slots[kept], slot);
+        batch.headers[kept].msg_len = batch.headers[i].msg_len;
+      }
+      ++kept;
+    }
+
+    // A read of nothing but truncated datagrams waits for the next one.
+    if (count > 0 && kept == 0)
+    {
+      errno = EAGAIN;
+      return -1;
+    }
+    return (count < 0) ? count : kept;
+  };
+
+#ifdef MSG_WAITFORONE
+  while (true)
+  {
+    auto count = ::recvmmsg(socket, batch.headers.data(),
+                            static_cast<unsigned>(batch.headers.size()),
+                            MSG_DONTWAIT, nullptr);
+    if (count >= 0 || errno != EINTR)
+      return parse(count);
+  }
+#else
+  // Without recvmmsg the batch is drained with one recvmsg per datagram.
+  auto count = std::size_t{0};
+  while (count < batch.headers.size())
+  {
+    auto &header = batch.headers[count];
+    auto len = ::recvmsg(socket, &header.msg_hdr, MSG_DONTWAIT);
+    if (len < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    header.msg_len = static_cast<unsigned>(len);
+    ++count;
+  }
+  return count > 0 ? parse(static_cast<int>(count)) : -1;
+#endif
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::recv_gro_(read_context &rctx,
+                                          socket_type socket) -> ssize_t
+{
+  auto iov = ::iovec{.iov_base = rctx.buffer.data(),
+                     .iov_len = rctx.buffer.size()};
+  auto hdr = ::msghdr{};
+  hdr.msg_name = std::addressof(**rctx.msg.address);
+  hdr.msg_namelen = sizeof(sockaddr_in6);
+  hdr.msg_iov = &iov;
+  hdr.msg_iovlen = 1;
+  hdr.msg_control = rctx.control.data();
+  hdr.msg_controllen = rctx.control.size();
+
+  while (true)
+  {
+    auto len = ::recvmsg(socket, &hdr, MSG_DONTWAIT);
+    if (len >= 0)
+    {
+      if (hdr.msg_flags & MSG_TRUNC)
+      {
+        errno = EMSGSIZE;
+        return -1;
+      }
+
+      peer_address_(*rctx.msg.address, hdr.msg_namelen);
+      rctx.segment_size = segment_size_(hdr);
+      return len;
+    }
+
+    if (errno != EINTR)
+      return len;
+  }
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::segment_size_(::msghdr &hdr) noexcept
+    -> std::size_t
+{
+#ifdef UDP_GRO
+  for (auto *cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&hdr, cmsg))
+  {
+    if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+    {
+      auto size = int{0};
+      std::memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+      return static_cast<std::size_t>(std::max(size, 0));
+    }
+  }
+#endif
+  return 0;
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::peer_address_(socket_address<sockaddr_in6>
+                                                  &address,
+                                              ::socklen_t size) noexcept
+    -> void
+{
+  // Bytes past the end of the address the kernel wrote are left over from
+  // an earlier peer, so they are cleared. An empty address clears the
+  // family too.
+  auto *bytes = reinterpret_cast<std::byte *>(std::addressof(*address));
+  size = std::min(size, static_cast<::socklen_t>(sizeof(sockaddr_in6)));
+  std::memset(bytes + size, 0, sizeof(sockaddr_in6) - size);
+}
+
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+[[nodiscard]] auto
+async_udp_service<UDPStreamHandler, Size, Multiplexer, Timers>::initialize_(
+    const socket_handle &socket, bool reuse_port) -> std::error_code
 {
   using namespace io;
   using namespace io::socket;
@@ -101,6 +546,28 @@ template <typename UDPStreamHandler, std::size_t Size>
     return {errno, std::system_category()};
   }
 
+  if (reuse_port)
+  {
+#ifdef SO_REUSEPORT
+    if (auto reuse = socket_option<int>(1);
+        setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, reuse))
+    {
+      return {errno, std::system_category()};
+    }
+#else
+    return std::make_error_code(std::errc::operation_not_supported);
+#endif
+  }
+
+#ifdef UDP_GRO
+  // GRO is best effort. Without it every read holds a single datagram.
+  if (!net::execution::CompletionMultiplexer<Multiplexer> && options_.gro)
+  {
+    auto gro = socket_option<int>(1);
+    static_cast<void>(setsockopt(socket, SOL_UDP, UDP_GRO, gro));
+  }
+#endif
+
   if constexpr (requires(UDPStreamHandler handler) {
                   {
                     handler.initialize(socket)
@@ -119,8 +586,10 @@ template <typename UDPStreamHandler, std::size_t Size>
   return {};
 }
 
-template <typename UDPStreamHandler, std::size_t Size>
-auto async_udp_service<UDPStreamHandler, Size>::stop_() -> void
+template <typename UDPStreamHandler, std::size_t Size, typename Multiplexer,
+          typename Timers>
+auto async_udp_service<UDPStreamHandler, Size, Multiplexer,
+                       Timers>::stop_() -> void
 {
   using namespace io::socket;
 
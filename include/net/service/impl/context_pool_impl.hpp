@@ -0,0 +1,133 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file context_pool_impl.hpp
+ * @brief This file defines the context pool.
+ */
+#pragma once
+#ifndef CPPNET_CONTEXT_POOL_IMPL_HPP
+#define CPPNET_CONTEXT_POOL_IMPL_HPP
+#include "net/service/context_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+namespace net::service {
+template <ServiceLike Service>
+context_pool<Service>::context_pool(size_type size)
+{
+  threads_.reserve(size);
+  for (size_type i = 0; i < size; ++i)
+  {
+    auto &thread = threads_.emplace_back(std::make_unique<thread_type>());
+    thread->reuse_port = true;
+  }
+}
+
+template <ServiceLike Service>
+context_pool<Service>::context_pool(std::vector<thread_options> options)
+{
+  threads_.reserve(options.size());
+  for (auto &option : options)
+  {
+    auto &thread = threads_.emplace_back(
+        std::make_unique<thread_type>(std::move(option)));
+    thread->reuse_port = true;
+  }
+}
+
+template <ServiceLike Service>
+template <typename... Args>
+auto context_pool<Service>::start(const Args &...args) -> void
+{
+  using enum async_context_base::context_states;
+  if (started_)
+    throw std::invalid_argument("context_pool can't be started twice.");
+
+  started_ = true;
+  // context_thread::start() forwards references to its arguments to the
+  // new thread, so each thread must construct its service before args can
+  // be handed to the next one.
+  for (auto &thread : threads_)
+  {
+    thread->start(args...);
+    thread->state.wait(PENDING);
+  }
+}
+
+template <ServiceLike Service>
+auto context_pool<Service>::signal(int signum) -> void
+{
+  for (auto &thread : threads_)
+    thread->signal(signum);
+}
+
+template <ServiceLike Service> auto context_pool<Service>::stop() -> void
+{
+  using enum async_context_base::context_states;
+  signal(async_context_base::terminate);
+  for (auto &thread : threads_)
+  {
+    if (thread->state != PENDING)
+      thread->state.wait(STARTED);
+  }
+}
+
+template <ServiceLike Service>
+auto context_pool<Service>::started() const noexcept -> bool
+{
+  using enum async_context_base::context_states;
+  return !threads_.empty() &&
+         std::ranges::all_of(threads_, [](const auto &thread) {
+           return thread->state == STARTED;
+         });
+}
+
+template <ServiceLike Service>
+auto context_pool<Service>::pinned(size_type size)
+    -> std::vector<thread_options>
+{
+  const auto cpus = allowed_cpus();
+  auto options = std::vector<thread_options>(size);
+  if (cpus.empty())
+    return options;
+
+  for (size_type i = 0; i < size; ++i)
+    options[i].cpus = {cpus[i % cpus.size()]};
+
+  return options;
+}
+
+template <ServiceLike Service>
+auto context_pool<Service>::size() const noexcept -> size_type
+{
+  return threads_.size();
+}
+
+template <ServiceLike Service>
+auto context_pool<Service>::operator[](size_type index) noexcept
+    -> thread_type &
+{
+  return *threads_[index];
+}
+
+template <ServiceLike Service>
+auto context_pool<Service>::default_size() noexcept -> size_type
+{
+  return std::max(1U, std::thread::hardware_concurrency());
+}
+} // namespace net::service
+#endif // CPPNET_CONTEXT_POOL_IMPL_HPP
@@ -24,15 +24,57 @@
 #include "net/service/context_thread.hpp"
 
 #include <stdexec/execution.hpp>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 namespace net::service {
+/** @brief Internal net::service implementation details. */
+namespace detail {
+#if defined(__linux__)
+/**
+ * @brief Lists the CPUs in a CPU set.
+ * @param set The CPU set.
+ * @returns The CPUs in ascending order.
+ */
+inline auto to_cpus(const ::cpu_set_t &set) -> std::vector<int>
+{
+  auto cpus = std::vector<int>();
+  cpus.reserve(CPU_COUNT(&set));
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+  {
+    if (CPU_ISSET(cpu, &set))
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+#endif
+} // namespace detail.
+
+inline auto allowed_cpus() -> std::vector<int>
+{
+#if defined(__linux__)
+  auto set = ::cpu_set_t{};
+  if (::sched_getaffinity(0, sizeof(set), &set))
+    return {};
+
+  return detail::to_cpus(set);
+#else
+  return {};
+#endif
+}
+
+template <ServiceLike Service>
+context_thread<Service>::context_thread(thread_options options) noexcept
+    : options_{std::move(options)}
+{}
+
 template <ServiceLike Service>
 auto context_thread<Service>::stop() noexcept -> void
 {
-  auto socket = timers.sockets[1];
-  timers.sockets[1] = timers.INVALID_SOCKET;
-  if (socket != timers.INVALID_SOCKET)
-    io::socket::close(socket);
-  state = STOPPED;
+  this->timers.close();
+  this->state = context_type::STOPPED;
 }
 
 template <ServiceLike Service>
@@ -45,46 +87,60 @@ auto context_thread<Service>::start(Args &&...args) -> void
 
   server_ = std::thread([&]() noexcept {
     using namespace detail;
-    using namespace io::socket;
     using namespace std::chrono;
 
+    auto &ctx = static_cast<context_type &>(*this);
+    auto &timers = ctx.timers;
+    auto &scope = ctx.scope;
+    auto &state = ctx.state;
+
+    // Pin the thread before the service is constructed, so that
+    // first-touch places the service state on the local NUMA node.
+    if ((error_ = pin_()))
+    {
+      stop();
+      state.notify_all();
+      return;
+    }
+
     auto service = Service{std::forward<Args>(args)...};
-    auto &sockets = timers.sockets;
-    if (!socketpair(AF_UNIX, SOCK_STREAM, 0, sockets.data()))
+    if (!timers.open())
     {
       const auto token = scope.get_stop_token();
 
-      isr(poller.emplace(sockets[0]), [&]() noexcept {
-        auto sigmask_ = sigmask.exchange(0);
+      ctx.isr(ctx.poller.emplace(timers.listener()), [&]() noexcept {
+        auto sigmask_ = ctx.sigmask.exchange(0);
         for (int signum = 0; auto mask = (sigmask_ >> signum); ++signum)
         {
           if (mask & (1 << 0))
             service.signal_handler(signum);
         }
 
-        if (sigmask_ & (1 << terminate))
+        if (sigmask_ & (1 << context_type::terminate))
         {
           scope.request_stop();
           timers.add(
               seconds(1),
-              [&](timers::timer_id) { service.signal_handler(terminate); },
+              [&](timers::timer_id) {
+                service.signal_handler(context_type::terminate);
+              },
               seconds(1));
         }
 
         return !token.stop_requested();
       });
 
-      service.start(static_cast<async_context &>(*this));
-      state = STARTED;
+      service.start(ctx);
+      state = context_type::STARTED;
 
       if (token.stop_requested())
       {
-        state = STOPPED;
-        signal(terminate);
+        state = context_type::STOPPED;
+        ctx.signal(context_type::terminate);
       }
 
       state.notify_all();
-      run();
+      ctx.run();
     }
 
     stop();
@@ -94,12 +150,78 @@ auto context_thread<Service>::start(Args &&...args) -> void
   started_ = true;
 }
 
+template <ServiceLike Service>
+auto context_thread<Service>::thread_id() const noexcept -> std::thread::id
+{
+  return server_.get_id();
+}
+
+template <ServiceLike Service>
+auto context_thread<Service>::affinity() const -> std::vector<int>
+{
+#if defined(__linux__)
+  if (!server_.joinable())
+    return {};
+
+  auto set = ::cpu_set_t{};
+  auto handle = const_cast<std::thread &>(server_).native_handle();
+  if (::pthread_getaffinity_np(handle, sizeof(set), &set))
+    return {};
+
+  return detail::to_cpus(set);
+#else
+  return {};
+#endif
+}
+
+template <ServiceLike Service>
+auto context_thread<Service>::options() const noexcept
+    -> const thread_options &
+{
+  return options_;
+}
+
+template <ServiceLike Service>
+auto context_thread<Service>::error() const noexcept -> std::error_code
+{
+  return error_;
+}
+
+template <ServiceLike Service>
+auto context_thread<Service>::pin_() const noexcept -> std::error_code
+{
+  if (options_.cpus.empty())
+    return {};
+
+#if defined(__linux__)
+  auto set = ::cpu_set_t{};
+  CPU_ZERO(&set);
+  for (auto cpu : options_.cpus)
+  {
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+      return std::make_error_code(std::errc::invalid_argument);
+
+    CPU_SET(cpu, &set);
+  }
+
+  if (auto error =
+          ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set))
+  {
+    return {error, std::system_category()};
+  }
+
+  return {};
+#else
+  return std::make_error_code(std::errc::operation_not_supported);
+#endif
+}
+
 template <ServiceLike Service> context_thread<Service>::~context_thread()
 {
   if (!started_)
     return;
 
-  signal(terminate);
+  this->signal(context_type::terminate);
   server_.join();
 }
 } // namespace net::service
@@ -0,0 +1,276 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file datagram_queue_impl.hpp
+ * @brief This file defines an outbound datagram queue for one socket.
+ */
+#pragma once
+#ifndef CPPNET_DATAGRAM_QUEUE_IMPL_HPP
+#define CPPNET_DATAGRAM_QUEUE_IMPL_HPP
+#include "net/service/datagram_queue.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+namespace net::service {
+
+template <typename AsyncContext>
+datagram_queue<AsyncContext>::datagram_queue(options_type options) noexcept
+    : options_{options}
+{
+  options_.max_batch = std::max(options_.max_batch, size_type{1});
+}
+
+template <typename AsyncContext>
+auto datagram_queue<AsyncContext>::push(async_context &ctx,
+                                        const socket_dialog &socket,
+                                        const socket_address &address,
+                                        buffer_type buffer,
+                                        size_type segment_size) -> void
+{
+  if (segment_size > 0 && buffer.size() > segment_size)
+    append_segments_(address, std::move(buffer), segment_size);
+  else
+    datagrams_.push_back({.address = address, .buffer = std::move(buffer)});
+
+  if (datagrams_.size() >= options_.max_batch)
+    flush_(static_cast<socket_type>(*socket.socket));
+
+  if (!datagrams_.empty())
+    arm_(ctx, socket);
+}
+
+template <typename AsyncContext>
+auto datagram_queue<AsyncContext>::push(async_context &ctx,
+                                        const socket_dialog &socket,
+                                        const socket_address &address,
+                                        std::span<const std::byte> buffer,
+                                        size_type segment_size) -> void
+{
+  push(ctx, socket, address, buffer_type(buffer.begin(), buffer.end()),
+       segment_size);
+}
+
+template <typename AsyncContext>
+auto datagram_queue<AsyncContext>::queued() const noexcept -> size_type
+{
+  return datagrams_.size();
+}
+
+template <typename AsyncContext>
+auto datagram_queue<AsyncContext>::sent() const noexcept -> size_type
+{
+  return sent_;
+}
+
+template <typename AsyncContext>
+auto datagram_queue<AsyncContext>::dropped() const noexcept -> size_type
+{
+  return dropped_;
+}
+
+template <typename AsyncContext>
+auto datagram_queue<AsyncContext>::syscalls() const noexcept -> size_type
+{
+  return syscalls_;
+}
+
+template <typename AsyncContext>
+auto datagram_queue<AsyncContext>::append_segments_(
+    const socket_address &address, buffer_type buffer,
+    size_type segment_size) -> void
+{
+#ifdef UDP_SEGMENT
+  const bool gso = gso_ && segment_size <= MAX_GSO_BYTES;
+#else
+  const bool gso = false;
+#endif
+  // Without segmentation offload every segment is its own datagram.
+  const auto segments =
+      gso ? std::clamp(MAX_GSO_BYTES / segment_size, size_type{1},
+                       MAX_GSO_SEGMENTS)
+          : size_type{1};
+  const auto message_size = segments * segment_size;
+  const auto segment = static_cast<std::uint16_t>(gso ? segment_size : 0);
+
+  if (buffer.size() <= message_size)
+  {
+    datagrams_.push_back({.address = address,
+                          .buffer = std::move(buffer),
+                          .segment_size = segment});
+    return;
+  }
+
+  for (size_type offset = 0; offset < buffer.size(); offset += message_size)
+  {
+    const auto first = buffer.begin() + static_cast<std::ptrdiff_t>(offset);
+    const auto last = buffer.begin() + static_cast<std::ptrdiff_t>(std::min(
+                                           offset + message_size,
+                                           buffer.size()));
+    // A trailing message of one segment needs no offload.
+    const auto size = static_cast<size_type>(last - first);
+    datagrams_.push_back({.address = address,
+                          .buffer = buffer_type(first, last),
+                          .segment_size = size > segment_size ? segment : 0});
+  }
+}
+
+template <typename AsyncContext>
+auto datagram_queue<AsyncContext>::split_front_() -> void
+{
+  auto message = std::move(datagrams_.front());
+  datagrams_.pop_front();
+
+  const auto &buffer = message.buffer;
+  const size_type segment_size = message.segment_size;
+  // The segments are pushed back to front so they keep their order.
+  for (auto last = buffer.size(); last > 0;)
+  {
+    const auto first = (last - 1) / segment_size * segment_size;
+    datagrams_.push_front(
+        {.address = message.address,
+         .buffer = buffer_type(
+             buffer.begin() + static_cast<std::ptrdiff_t>(first),
+             buffer.begin() + static_cast<std::ptrdiff_t>(last))});
+    last = first;
+  }
+}
+
+template <typename AsyncContext>
+auto datagram_queue<AsyncContext>::flush_(socket_type socket) -> ssize_t
+{
+  auto sent = ssize_t{0};
+  while (!datagrams_.empty())
+  {
+    const auto batch = std::min(datagrams_.size(), options_.max_batch);
+    headers_.assign(batch, {});
+    iovecs_.resize(batch);
+    controls_.resize(batch);
+    for (size_type i = 0; i < batch; ++i)
+    {
+      auto &dgram = datagrams_[i];
+      iovecs_[i] = {.iov_base = dgram.buffer.data(),
+                    .iov_len = dgram.buffer.size()};
+
+      auto &hdr = headers_[i].msg_hdr;
+      hdr.msg_name = std::addressof(*dgram.address);
+      hdr.msg_namelen = dgram.address->sin6_family == AF_INET
+                            ? sizeof(sockaddr_in)
+                            : sizeof(sockaddr_in6);
+      hdr.msg_iov = &iovecs_[i];
+      hdr.msg_iovlen = 1;
+#ifdef UDP_SEGMENT
+      if (dgram.segment_size > 0)
+      {
+        auto &control = controls_[i].data;
+        hdr.msg_control = control.data();
+        hdr.msg_controllen = control.size();
+
+        auto *cmsg = CMSG_FIRSTHDR(&hdr);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(dgram.segment_size));
+        std::memcpy(CMSG_DATA(cmsg), &dgram.segment_size,
+                    sizeof(dgram.segment_size));
+      }
+#endif
+    }
+
+    ++syscalls_;
+#ifdef MSG_WAITFORONE
+    auto count = ::sendmmsg(socket, headers_.data(),
+                            static_cast<unsigned>(batch), MSG_NOSIGNAL);
+#else
+    // Without sendmmsg every datagram is its own sendmsg.
+    auto count = ::sendmsg(socket, &headers_.front().msg_hdr, MSG_NOSIGNAL);
+    if (count >= 0)
+      count = 1;
+#endif
+    if (count < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return -1;
+
+      // The kernel, or the device, can't segment the message, so it is
+      // sent one segment at a time from now on.
+      if (datagrams_.front().segment_size > 0 &&
+          (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT))
+      {
+        gso_ = false;
+        split_front_();
+        continue;
+      }
+
+      // The first datagram of the batch was refused. It is dropped so
+      // that the rest can be sent.
+      datagrams_.pop_front();
+      ++dropped_;
+      continue;
+    }
+
+    // A partial batch is resumed from the first unsent datagram.
+    datagrams_.erase(datagrams_.begin(), datagrams_.begin() + count);
+    sent_ += static_cast<size_type>(count);
+    sent += count;
+  }
+
+  return sent;
+}
+
+template <typename AsyncContext>
+auto datagram_queue<AsyncContext>::arm_(async_context &ctx,
+                                        const socket_dialog &socket) -> void
+{
+  using namespace stdexec;
+  using enum io::execution::execution_trigger;
+
+  if (armed_)
+    return;
+
+  auto mux = socket.multiplexer.lock();
+  if (!mux)
+  {
+    dropped_ += datagrams_.size();
+    datagrams_.clear();
+    return;
+  }
+
+  armed_ = true;
+  const auto sockfd = static_cast<socket_type>(*socket.socket);
+  auto exec = [self = this->shared_from_this(), sockfd] {
+    return self->flush_(sockfd);
+  };
+
+  sender auto flush = mux->set(socket.socket, WRITE, std::move(exec)) |
+                      then([self = this->shared_from_this()](auto &&) {
+                        self->armed_ = false;
+                      }) |
+                      upon_error([self = this->shared_from_this()](auto &&) {
+                        self->armed_ = false;
+                      }) |
+                      upon_stopped([self = this->shared_from_this()] {
+                        self->armed_ = false;
+                      });
+
+  ctx.scope.spawn(std::move(flush));
+}
+
+} // namespace net::service
+#endif // CPPNET_DATAGRAM_QUEUE_IMPL_HPP
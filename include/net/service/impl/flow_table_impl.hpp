@@ -0,0 +1,314 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file flow_table_impl.hpp
+ * @brief This file defines a table of per-peer flow state.
+ */
+#pragma once
+#ifndef CPPNET_FLOW_TABLE_IMPL_HPP
+#define CPPNET_FLOW_TABLE_IMPL_HPP
+#include "net/service/flow_table.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+namespace net::service {
+
+template <typename State, typename AsyncContext>
+flow_table<State, AsyncContext>::flow_table(options_type options)
+    : options_{options}
+{
+  options_.capacity = std::max(options_.capacity, size_type{1});
+  // A load factor of at most two thirds keeps the probe sequences short.
+  slots_.resize(std::bit_ceil(options_.capacity + (options_.capacity / 2) + 1));
+  mask_ = slots_.size() - 1;
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::find(
+    const socket_address &address) noexcept -> state_type *
+{
+  const auto key = key_(address);
+  auto &slot = slots_[probe_(key, hash_(key))];
+  if (!slot.occupied)
+    return nullptr;
+
+  slot.last_used = now_;
+  return &slot.state;
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::try_emplace(
+    const socket_address &address) -> std::pair<state_type *, bool>
+{
+  const auto key = key_(address);
+  const auto hash = hash_(key);
+  auto index = probe_(key, hash);
+  if (slots_[index].occupied)
+  {
+    slots_[index].last_used = now_;
+    return {&slots_[index].state, false};
+  }
+
+  if (size() >= options_.capacity)
+  {
+    evict_(hash & mask_);
+    index = probe_(key, hash);
+  }
+
+  auto &slot = slots_[index];
+  slot.hash = hash;
+  slot.key = key;
+  slot.last_used = now_;
+  slot.occupied = true;
+  size_.store(size() + 1, std::memory_order_relaxed);
+  inserted_.store(inserted_.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  return {&slot.state, true};
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::erase(const socket_address &address)
+    -> bool
+{
+  const auto key = key_(address);
+  const auto index = probe_(key, hash_(key));
+  if (!slots_[index].occupied)
+    return false;
+
+  erase_at_(index);
+  return true;
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::clear() -> void
+{
+  for (auto &slot : slots_)
+  {
+    if (slot.occupied)
+      slot = {};
+  }
+  size_.store(0, std::memory_order_relaxed);
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::start(async_context &ctx) -> void
+{
+  using namespace std::chrono;
+  using net::timers::duration;
+
+  if (options_.idle <= milliseconds::zero() ||
+      timer_ != net::timers::INVALID_TIMER)
+  {
+    return;
+  }
+
+  // Every slot is checked once per idle period.
+  const auto period = std::max(
+      duration_cast<duration>(options_.idle) /
+          static_cast<duration::rep>(SWEEP_SLICES),
+      duration(1));
+  auto expire = [&ctx, self = this->weak_from_this()](
+                    net::timers::timer_id tid) {
+    if (auto table = self.lock())
+    {
+      table->tick();
+      return;
+    }
+    ctx.timers.remove(tid);
+  };
+
+  timer_ = ctx.timers.add(period, std::move(expire), period);
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::stop(async_context &ctx) noexcept
+    -> void
+{
+  if (timer_ != net::timers::INVALID_TIMER)
+    timer_ = ctx.timers.remove(timer_);
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::tick() -> size_type
+{
+  ++now_;
+
+  const auto slice = std::max(slots_.size() / SWEEP_SLICES, size_type{1});
+  auto expired = size_type{0};
+  for (auto checked = size_type{0}; checked < slice;)
+  {
+    auto &slot = slots_[cursor_];
+    // The clock is unsigned, so ages stay correct when it wraps.
+    if (slot.occupied &&
+        static_cast<size_type>(now_ - slot.last_used) > SWEEP_SLICES)
+    {
+      // The next flow of the probe sequence may shift into this slot, so
+      // the slot is checked again.
+      erase_at_(cursor_);
+      ++expired;
+      continue;
+    }
+
+    cursor_ = (cursor_ + 1) & mask_;
+    ++checked;
+  }
+
+  expired_.store(expired_.load(std::memory_order_relaxed) + expired,
+                 std::memory_order_relaxed);
+  return expired;
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::size() const noexcept -> size_type
+{
+  return size_.load(std::memory_order_relaxed);
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::capacity() const noexcept -> size_type
+{
+  return options_.capacity;
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::stats() const noexcept -> stats_type
+{
+  return {.flows = size_.load(std::memory_order_relaxed),
+          .inserted = inserted_.load(std::memory_order_relaxed),
+          .expired = expired_.load(std::memory_order_relaxed),
+          .evicted = evicted_.load(std::memory_order_relaxed)};
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::key_(
+    const socket_address &address) noexcept -> flow_key
+{
+  auto key = flow_key{.family = address->sin6_family};
+  if (key.family == AF_INET)
+  {
+    // A sockaddr_in6 is large enough to hold a sockaddr_in.
+    auto sin = sockaddr_in{};
+    std::memcpy(&sin, &address->sin6_family, sizeof(sin));
+    std::memcpy(key.addr.data(), &sin.sin_addr, sizeof(sin.sin_addr));
+    key.port = sin.sin_port;
+    return key;
+  }
+
+  key.port = address->sin6_port;
+  if (IN6_IS_ADDR_V4MAPPED(&address->sin6_addr))
+  {
+    // Dual-stack sockets see IPv4 peers as IPv4-mapped addresses.
+    constexpr auto MAPPED_PREFIX = sizeof(in6_addr) - sizeof(in_addr);
+    key.family = AF_INET;
+    std::memcpy(key.addr.data(), &address->sin6_addr.s6_addr[MAPPED_PREFIX],
+                sizeof(in_addr));
+    return key;
+  }
+
+  std::memcpy(key.addr.data(), &address->sin6_addr, key.addr.size());
+  key.scope = address->sin6_scope_id;
+  return key;
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::hash_(const flow_key &key) noexcept
+    -> std::size_t
+{
+  auto low = std::uint64_t{0};
+  auto high = std::uint64_t{0};
+  std::memcpy(&low, key.addr.data(), sizeof(low));
+  std::memcpy(&high, key.addr.data() + sizeof(low), sizeof(high));
+
+  // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+  const auto rest = (std::uint64_t{key.scope} << 32U) |
+                    (std::uint64_t{key.port} << 16U) | key.family;
+  auto hash = (low * 0x9e3779b97f4a7c15ULL) ^ (high * 0xc2b2ae3d27d4eb4fULL) ^
+              (rest * 0x165667b19e3779f9ULL);
+  hash ^= hash >> 32U;
+  hash *= 0xd6e8feb86659fd93ULL;
+  hash ^= hash >> 32U;
+  // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+  return static_cast<std::size_t>(hash);
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::probe_(
+    const flow_key &key, std::size_t hash) const noexcept -> size_type
+{
+  // The load factor is below one, so every probe sequence ends in an
+  // empty slot.
+  for (auto index = hash & mask_;; index = (index + 1) & mask_)
+  {
+    const auto &slot = slots_[index];
+    if (!slot.occupied || (slot.hash == hash && slot.key == key))
+      return index;
+  }
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::erase_at_(size_type index) -> void
+{
+  auto hole = index;
+  for (auto next = (hole + 1) & mask_; slots_[next].occupied;
+       next = (next + 1) & mask_)
+  {
+    // A flow can fill the hole if the hole lies between its home slot and
+    // the slot it is in.
+    const auto home = slots_[next].hash & mask_;
+    if (((next - home) & mask_) >= ((next - hole) & mask_))
+    {
+      slots_[hole] = std::move(slots_[next]);
+      hole = next;
+    }
+  }
+
+  slots_[hole] = {};
+  size_.store(size() - 1, std::memory_order_relaxed);
+}
+
+template <typename State, typename AsyncContext>
+auto flow_table<State, AsyncContext>::evict_(size_type index) -> void
+{
+  auto oldest = slots_.size();
+  auto oldest_age = std::uint32_t{0};
+  auto probes = size_type{0};
+  for (auto scanned = size_type{0};
+       scanned < slots_.size() && probes < EVICTION_PROBES; ++scanned)
+  {
+    const auto &slot = slots_[(index + scanned) & mask_];
+    if (!slot.occupied)
+      continue;
+
+    const auto age = static_cast<std::uint32_t>(now_ - slot.last_used);
+    if (probes++ == 0 || age > oldest_age)
+    {
+      oldest = (index + scanned) & mask_;
+      oldest_age = age;
+    }
+  }
+
+  if (oldest == slots_.size())
+    return;
+
+  erase_at_(oldest);
+  evicted_.store(evicted_.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+}
+
+} // namespace net::service
+#endif // CPPNET_FLOW_TABLE_IMPL_HPP
@@ -0,0 +1,370 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file send_file_impl.hpp
+ * @brief This file defines a sender that transfers a file to a socket.
+ */
+#pragma once
+#ifndef CPPNET_SEND_FILE_IMPL_HPP
+#define CPPNET_SEND_FILE_IMPL_HPP
+#include "net/service/send_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#if __has_include(<sys/sendfile.h>)
+#include <sys/sendfile.h>
+#endif
+namespace net::service {
+
+/**
+ * @details The operation waits for the socket to become writable through
+ * the multiplexer, and then transfers until the socket would block. The
+ * multiplexer re-arms the wait for as long as the transfer reports EAGAIN.
+ * A pipe that is empty while its writers are still open is waited for in
+ * the same way, until it becomes readable.
+ */
+template <typename Multiplexer, typename Progress>
+template <typename Receiver>
+class file_sender<Multiplexer, Progress>::operation {
+  /** @brief The trigger type. */
+  using execution_trigger = io::execution::execution_trigger;
+
+  /** @brief The transfer that runs whenever the wait is ready. */
+  struct transfer_fn {
+    /** @brief The operation. */
+    operation *self;
+    /** @brief The trigger that the wait is for. */
+    execution_trigger trigger;
+    /** @returns The bytes sent so far, or -1 if the transfer blocks. */
+    auto operator()() const noexcept -> ssize_t
+    {
+      return self->transfer_(trigger);
+    }
+  };
+
+  /** @brief Receives the completion of the multiplexer wait. */
+  struct receiver {
+    /** @brief The receiver concept. */
+    using receiver_concept = stdexec::receiver_t;
+
+    /**
+     * @brief Completes with the number of bytes sent, or waits for the
+     * other descriptor.
+     */
+    auto set_value(auto && /*len*/) && noexcept -> void
+    {
+      if (auto next = std::exchange(self->next_, std::nullopt))
+        return self->wait_(*next);
+
+      stdexec::set_value(std::move(self->receiver_), self->sent_);
+    }
+
+    /** @brief Completes with the transfer error. */
+    auto set_error(int error) && noexcept -> void
+    {
+      stdexec::set_error(std::move(self->receiver_), error);
+    }
+
+    /** @brief Completes with set_stopped. */
+    auto set_stopped() && noexcept -> void
+    {
+      stdexec::set_stopped(std::move(self->receiver_));
+    }
+
+    /** @returns The environment of the outer receiver. */
+    [[nodiscard]] auto get_env() const noexcept
+    {
+      return stdexec::get_env(self->receiver_);
+    }
+
+    /** @brief The operation. */
+    operation *self;
+  };
+
+  /** @brief The multiplexer wait sender type. */
+  using wait_sender = decltype(std::declval<Multiplexer &>().set(
+      std::declval<std::shared_ptr<io::socket::socket_handle>>(),
+      io::execution::execution_trigger::WRITE, std::declval<transfer_fn>()));
+  /** @brief The multiplexer wait operation type. */
+  using wait_operation = stdexec::connect_result_t<wait_sender, receiver>;
+
+  /**
+   * @brief Constructs an immovable operation state in place from the
+   * result of a function.
+   */
+  template <typename Fn> struct emplace_from {
+    /** @brief The function. */
+    Fn fn;
+    /** @returns The result of the function. */
+    operator std::invoke_result_t<Fn>() && // NOLINT
+    {
+      return std::move(fn)();
+    }
+  };
+
+public:
+  /**
+   * @brief Constructor.
+   * @param sender The sender that is connected.
+   * @param receiver The receiver to complete.
+   */
+  operation(file_sender &&sender, Receiver receiver) noexcept
+      : socket_{std::move(sender.socket_)}, fd_{sender.fd_},
+        offset_{sender.offset_}, count_{sender.count_},
+        progress_{std::move(sender.progress_)},
+        receiver_{std::move(receiver)}
+  {}
+  /** @brief Deleted copy constructor. */
+  operation(const operation &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const operation &) -> operation & = delete;
+
+  /** @brief Waits for the socket to become writable. */
+  auto start() & noexcept -> void
+  {
+    using enum io::execution::execution_trigger;
+
+    struct stat info {};
+    if (::fstat(fd_, &info))
+      return stdexec::set_error(std::move(receiver_), errno);
+    splice_ = S_ISFIFO(info.st_mode);
+
+    if (count_ == 0)
+      return stdexec::set_value(std::move(receiver_), sent_);
+
+    wait_(WRITE);
+  }
+
+  /** @brief Default destructor. */
+  ~operation() = default;
+
+private:
+  /**
+   * @brief Waits for the socket to become writable, or for the pipe to
+   * become readable.
+   * @param trigger WRITE to wait for the socket, READ to wait for the pipe.
+   */
+  auto wait_(execution_trigger trigger) noexcept -> void
+  {
+    using enum io::execution::execution_trigger;
+
+    auto mux = socket_.multiplexer.lock();
+    if (!mux)
+      return stdexec::set_error(std::move(receiver_), ENOTCONN);
+
+    // A socket handle closes its descriptor, so the pipe is waited for
+    // through a duplicate.
+    if (trigger == READ && !pipe_)
+    {
+      const auto fd = ::fcntl(fd_, F_DUPFD_CLOEXEC, 0);
+      if (fd < 0)
+        return stdexec::set_error(std::move(receiver_), errno);
+
+      try
+      {
+        pipe_ = std::make_shared<io::socket::socket_handle>(fd);
+      }
+      catch (const std::system_error &error)
+      {
+        ::close(fd);
+        return stdexec::set_error(std::move(receiver_), error.code().value());
+      }
+      catch (...)
+      {
+        ::close(fd);
+        return stdexec::set_error(std::move(receiver_), ENOMEM);
+      }
+    }
+
+    // This may run from the completion of the current wait, which must not
+    // be destroyed yet, so waits alternate between two operation states.
+    current_ ^= 1U;
+    auto &wait = waits_[current_];
+    try
+    {
+      const auto &handle = (trigger == READ) ? pipe_ : socket_.socket;
+      wait.emplace(emplace_from{[&] {
+        return stdexec::connect(
+            mux->set(handle, trigger, transfer_fn{this, trigger}),
+            receiver{this});
+      }});
+    }
+    catch (const std::system_error &error)
+    {
+      return stdexec::set_error(std::move(receiver_), error.code().value());
+    }
+    catch (...)
+    {
+      return stdexec::set_error(std::move(receiver_), ENOMEM);
+    }
+    stdexec::start(*wait);
+  }
+
+  /**
+   * @brief Blocks the transfer until a descriptor is ready.
+   * @param current The trigger of the wait that is running.
+   * @param next The trigger that the transfer is blocked on.
+   * @returns -1 with errno set to EAGAIN to re-arm the wait if it is for
+   * `next` already, otherwise 0 to complete it so that `wait_()` switches
+   * to the other descriptor.
+   */
+  auto block_(execution_trigger current, execution_trigger next) noexcept
+      -> ssize_t
+  {
+    if (current == next)
+    {
+      errno = EAGAIN;
+      return -1;
+    }
+
+    next_ = next;
+    return 0;
+  }
+
+  /**
+   * @brief Transfers until the count is reached, the input ends, or the
+   * transfer would block.
+   * @param trigger The trigger of the wait that is running.
+   * @returns The number of bytes sent, or -1 with errno set.
+   */
+  auto transfer_(execution_trigger trigger) noexcept -> ssize_t
+  {
+    using enum io::execution::execution_trigger;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+    constexpr auto CHUNK = std::size_t{1} << 30U;
+    const auto sockfd = static_cast<int>(*socket_.socket);
+
+    while (sent_ < count_)
+    {
+      const auto chunk = std::min(count_ - sent_, CHUNK);
+      auto blocked = WRITE;
+      auto len = ssize_t{};
+      if (splice_)
+      {
+        // EAGAIN from splice comes from the pipe if it is empty, and from
+        // the socket otherwise.
+        auto available = int{};
+        if (::ioctl(fd_, FIONREAD, &available))
+          return -1;
+        if (available <= 0)
+          blocked = READ;
+
+#ifdef SPLICE_F_MOVE
+        len = ::splice(fd_, nullptr, sockfd, nullptr,
+                       (available > 0)
+                           ? std::min(chunk,
+                                      static_cast<std::size_t>(available))
+                           : chunk,
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+#else
+        errno = EOPNOTSUPP;
+        return -1;
+#endif
+      }
+      else
+      {
+#if __has_include(<sys/sendfile.h>)
+        len = ::sendfile(sockfd, fd_, &offset_, chunk);
+#else
+        errno = EOPNOTSUPP;
+        return -1;
+#endif
+      }
+
+      if (len < 0)
+      {
+        if (errno == EINTR)
+          continue;
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          return block_(trigger, blocked);
+
+        return -1;
+      }
+
+      // The file ended, or every writer closed the pipe, before count
+      // bytes were sent.
+      if (len == 0)
+        break;
+
+      sent_ += static_cast<std::size_t>(len);
+      progress_(sent_, count_);
+    }
+
+    return static_cast<ssize_t>(sent_);
+  }
+
+  /** @brief The socket. */
+  socket_dialog socket_;
+  /** @brief The file descriptor. */
+  int fd_;
+  /** @brief The offset of the next byte in the file. */
+  off_t offset_;
+  /** @brief The number of bytes to transfer. */
+  std::size_t count_;
+  /** @brief The number of bytes sent. */
+  std::size_t sent_ = 0;
+  /** @brief True if the file descriptor is a pipe. */
+  bool splice_ = false;
+  /** @brief The wait to switch to once the running wait completes. */
+  std::optional<execution_trigger> next_;
+  /** @brief A duplicate of the pipe to wait for it on. */
+  std::shared_ptr<io::socket::socket_handle> pipe_;
+  /** @brief The progress callback. */
+  Progress progress_;
+  /** @brief The receiver. */
+  Receiver receiver_;
+  /** @brief The multiplexer waits. */
+  std::array<std::optional<wait_operation>, 2> waits_;
+  /** @brief The index of the running wait. */
+  unsigned current_ = 0;
+};
+
+template <typename Multiplexer, typename Progress>
+file_sender<Multiplexer, Progress>::file_sender(socket_dialog socket, int fd,
+                                                off_t offset,
+                                                std::size_t count,
+                                                Progress progress) noexcept
+    : socket_{std::move(socket)}, fd_{fd}, offset_{offset}, count_{count},
+      progress_{std::move(progress)}
+{}
+
+template <typename Multiplexer, typename Progress>
+template <stdexec::receiver Receiver>
+auto file_sender<Multiplexer, Progress>::connect(Receiver receiver) &&
+    -> operation<Receiver>
+{
+  return {std::move(*this), std::move(receiver)};
+}
+
+template <typename Multiplexer, typename Progress>
+auto send_file(const io::socket::socket_dialog<Multiplexer> &socket, int fd,
+               off_t offset, std::size_t count, Progress progress)
+    -> file_sender<Multiplexer, Progress>
+{
+  return {socket, fd, offset, count, std::move(progress)};
+}
+
+} // namespace net::service
+#endif // CPPNET_SEND_FILE_IMPL_HPP
@@ -0,0 +1,269 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file write_queue_impl.hpp
+ * @brief This file defines an outbound queue for one connection.
+ */
+#pragma once
+#ifndef CPPNET_WRITE_QUEUE_IMPL_HPP
+#define CPPNET_WRITE_QUEUE_IMPL_HPP
+#include "net/service/write_queue.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+namespace net::service {
+
+inline write_budget::write_budget(size_type high_water,
+                                  size_type low_water) noexcept
+    : high_water_{high_water}, low_water_{std::min(low_water, high_water)}
+{}
+
+inline auto write_budget::acquire(size_type len) noexcept -> void
+{
+  queued_.store(queued_.load(std::memory_order_relaxed) + len,
+                std::memory_order_relaxed);
+}
+
+inline auto write_budget::release(size_type len) -> void
+{
+  const auto queued = queued_.load(std::memory_order_relaxed) - len;
+  queued_.store(queued, std::memory_order_relaxed);
+  if (waiters_.empty() || queued > low_water_)
+    return;
+
+  // Callbacks may wait again, so they run from a detached list.
+  auto waiters = std::exchange(waiters_, {});
+  waiting_.store(0, std::memory_order_relaxed);
+  for (auto &func : waiters)
+    func();
+}
+
+inline auto write_budget::exceeded() const noexcept -> bool
+{
+  return high_water_ > 0 &&
+         queued_.load(std::memory_order_relaxed) > high_water_;
+}
+
+inline auto write_budget::wait(std::function<void()> func) -> void
+{
+  if (!exceeded())
+    return func();
+
+  waiters_.push_back(std::move(func));
+  waiting_.store(waiters_.size(), std::memory_order_relaxed);
+}
+
+inline auto write_budget::queued() const noexcept -> size_type
+{
+  return queued_.load(std::memory_order_relaxed);
+}
+
+inline auto write_budget::waiting() const noexcept -> size_type
+{
+  return waiting_.load(std::memory_order_relaxed);
+}
+
+template <typename AsyncContext>
+write_queue<AsyncContext>::write_queue(
+    options_type options, std::shared_ptr<write_budget> budget) noexcept
+    : options_{options}, budget_{std::move(budget)}
+{
+  options_.max_iovecs = std::max(options_.max_iovecs, size_type{1});
+#ifdef IOV_MAX
+  options_.max_iovecs = std::min(options_.max_iovecs, size_type{IOV_MAX});
+#endif
+}
+
+template <typename AsyncContext>
+auto write_queue<AsyncContext>::push(async_context &ctx,
+                                     const socket_dialog &socket,
+                                     buffer_type buffer) -> void
+{
+  if (error_ || buffer.empty())
+    return;
+
+  const auto len = buffer.size();
+  buffers_.push_back(std::move(buffer));
+  queued_ += len;
+  if (budget_)
+    budget_->acquire(len);
+
+  arm_(ctx, socket);
+}
+
+template <typename AsyncContext>
+auto write_queue<AsyncContext>::push(async_context &ctx,
+                                     const socket_dialog &socket,
+                                     std::span<const std::byte> buffer)
+    -> void
+{
+  push(ctx, socket, buffer_type(buffer.begin(), buffer.end()));
+}
+
+template <typename AsyncContext>
+auto write_queue<AsyncContext>::on_low_water(size_type low_water,
+                                             std::function<void()> func)
+    -> void
+{
+  if (queued_ <= low_water)
+    return func();
+
+  low_water_ = low_water;
+  on_low_water_ = std::move(func);
+}
+
+template <typename AsyncContext>
+auto write_queue<AsyncContext>::queued() const noexcept -> size_type
+{
+  return queued_;
+}
+
+template <typename AsyncContext>
+auto write_queue<AsyncContext>::syscalls() const noexcept -> size_type
+{
+  return syscalls_;
+}
+
+template <typename AsyncContext>
+auto write_queue<AsyncContext>::error() const noexcept -> int
+{
+  return error_;
+}
+
+template <typename AsyncContext>
+auto write_queue<AsyncContext>::flush_(socket_type socket) -> ssize_t
+{
+  auto sent = ssize_t{0};
+  while (!buffers_.empty())
+  {
+    iovecs_.clear();
+    auto offset = offset_;
+    for (auto &buffer : buffers_)
+    {
+      if (iovecs_.size() == options_.max_iovecs)
+        break;
+
+      iovecs_.push_back({.iov_base = buffer.data() + offset,
+                         .iov_len = buffer.size() - offset});
+      offset = 0;
+    }
+
+    int flags = MSG_NOSIGNAL;
+    if (options_.cork && iovecs_.size() < buffers_.size())
+      flags |= MSG_MORE;
+
+    auto msg = ::msghdr{};
+    msg.msg_iov = iovecs_.data();
+    msg.msg_iovlen = iovecs_.size();
+    ++syscalls_;
+    auto len = ::sendmsg(socket, &msg, flags);
+    if (len < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        fail_(errno);
+
+      return -1;
+    }
+
+    // Drop every buffer that was sent in full, and remember how far into
+    // the next buffer the send got.
+    sent += len;
+    auto remaining = static_cast<size_type>(len);
+    while (remaining > 0)
+    {
+      const auto unsent = buffers_.front().size() - offset_;
+      if (remaining < unsent)
+      {
+        offset_ += remaining;
+        break;
+      }
+
+      remaining -= unsent;
+      offset_ = 0;
+      buffers_.pop_front();
+    }
+    release_(static_cast<size_type>(len));
+  }
+
+  return sent;
+}
+
+template <typename AsyncContext>
+auto write_queue<AsyncContext>::arm_(async_context &ctx,
+                                     const socket_dialog &socket) -> void
+{
+  using namespace stdexec;
+  using enum io::execution::execution_trigger;
+
+  if (armed_)
+    return;
+
+  auto mux = socket.multiplexer.lock();
+  if (!mux)
+    return fail_(ENOTCONN);
+
+  armed_ = true;
+  const auto sockfd = static_cast<socket_type>(*socket.socket);
+  auto exec = [self = this->shared_from_this(), sockfd] {
+    return self->flush_(sockfd);
+  };
+
+  sender auto flush =
+      mux->set(socket.socket, WRITE, std::move(exec)) |
+      then([self = this->shared_from_this()](auto &&) {
+        self->armed_ = false;
+      }) |
+      upon_error([self = this->shared_from_this()](auto &&) {
+        self->armed_ = false;
+      }) |
+      upon_stopped([self = this->shared_from_this()] {
+        self->armed_ = false;
+        self->fail_(ECANCELED);
+      });
+
+  ctx.scope.spawn(std::move(flush));
+}
+
+template <typename AsyncContext>
+auto write_queue<AsyncContext>::fail_(int error) -> void
+{
+  error_ = error;
+  buffers_.clear();
+  offset_ = 0;
+  release_(queued_);
+}
+
+template <typename AsyncContext>
+auto write_queue<AsyncContext>::release_(size_type len) -> void
+{
+  queued_ -= len;
+  if (budget_)
+    budget_->release(len);
+
+  if (on_low_water_ && queued_ <= low_water_)
+    std::exchange(on_low_water_, {})();
+}
+
+} // namespace net::service
+#endif // CPPNET_WRITE_QUEUE_IMPL_HPP
@@ -0,0 +1,453 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file zerocopy_impl.hpp
+ * @brief This file defines a tracker for zero-copy sends.
+ */
+#pragma once
+#ifndef CPPNET_ZEROCOPY_IMPL_HPP
+#define CPPNET_ZEROCOPY_IMPL_HPP
+#include "net/service/zerocopy.hpp"
+
+#if __has_include(<linux/errqueue.h>)
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#endif
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+namespace net::service {
+
+/**
+ * @details The sender completes with the value of the send that it
+ * waits on. A send that wasn't numbered, because zero-copy sends aren't
+ * enabled or because nothing was sent, completes immediately.
+ */
+template <typename AsyncContext>
+class zerocopy_tracker<AsyncContext>::release_sender {
+  /** @brief The operation state of a release sender. */
+  template <typename Receiver> class operation : waiter {
+  public:
+    /**
+     * @brief Constructor.
+     * @param sender The sender that is connected.
+     * @param receiver The receiver to complete.
+     */
+    operation(const release_sender &sender, Receiver receiver) noexcept
+        : waiter{nullptr, sender.id_.value_or(0), complete_},
+          tracker_{sender.tracker_}, ctx_{sender.ctx_},
+          socket_{sender.socket_}, id_{sender.id_}, len_{sender.len_},
+          receiver_{std::move(receiver)}
+    {}
+    /** @brief Deleted copy constructor. */
+    operation(const operation &) = delete;
+    /** @brief Deleted copy assignment. */
+    auto operator=(const operation &) -> operation & = delete;
+
+    /** @brief Waits for the send to be released. */
+    auto start() & noexcept -> void
+    {
+      if (!id_)
+        return stdexec::set_value(std::move(receiver_), len_);
+
+      tracker_->wait_(*ctx_, socket_, this);
+    }
+
+    /** @brief Default destructor. */
+    ~operation() = default;
+
+  private:
+    /** @brief Completes the receiver. */
+    static auto complete_(waiter *base, int error) noexcept -> void
+    {
+      auto *self = static_cast<operation *>(base);
+      if (error)
+        return stdexec::set_error(std::move(self->receiver_), error);
+
+      stdexec::set_value(std::move(self->receiver_), self->len_);
+    }
+
+    /** @brief The tracker. */
+    std::shared_ptr<zerocopy_tracker> tracker_;
+    /** @brief The context. */
+    async_context *ctx_;
+    /** @brief The socket. */
+    socket_dialog socket_;
+    /** @brief The send number. */
+    std::optional<std::uint32_t> id_;
+    /** @brief The number of bytes sent. */
+    ssize_t len_;
+    /** @brief The receiver. */
+    Receiver receiver_;
+  };
+
+public:
+  /** @brief The sender concept. */
+  using sender_concept = stdexec::sender_t;
+  /** @brief The completion signatures. */
+  using completion_signatures =
+      stdexec::completion_signatures<stdexec::set_value_t(ssize_t),
+                                     stdexec::set_error_t(int)>;
+
+  /**
+   * @brief Constructor.
+   * @param tracker The tracker.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket.
+   * @param id The send number.
+   * @param len The number of bytes sent.
+   */
+  release_sender(std::shared_ptr<zerocopy_tracker> tracker,
+                 async_context *ctx, socket_dialog socket,
+                 std::optional<std::uint32_t> id, ssize_t len) noexcept
+      : tracker_{std::move(tracker)}, ctx_{ctx}, socket_{std::move(socket)},
+        id_{id}, len_{len}
+  {}
+
+  /**
+   * @brief Connects the sender to a receiver.
+   * @tparam Receiver The receiver type.
+   * @param receiver The receiver.
+   * @returns The operation state.
+   */
+  template <stdexec::receiver Receiver>
+  auto connect(Receiver receiver) const noexcept -> operation<Receiver>
+  {
+    return {*this, std::move(receiver)};
+  }
+
+private:
+  /** @brief The tracker. */
+  std::shared_ptr<zerocopy_tracker> tracker_;
+  /** @brief The context. */
+  async_context *ctx_;
+  /** @brief The socket. */
+  socket_dialog socket_;
+  /** @brief The send number. */
+  std::optional<std::uint32_t> id_;
+  /** @brief The number of bytes sent. */
+  ssize_t len_;
+};
+
+template <typename AsyncContext>
+template <typename Message>
+auto zerocopy_tracker<AsyncContext>::send(async_context &ctx,
+                                          const socket_dialog &socket,
+                                          Message msg, int flags)
+{
+  using namespace stdexec;
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  if (enable_(socket))
+    flags |= MSG_ZEROCOPY;
+#endif
+
+  return io::sendmsg(socket, std::move(msg), flags) |
+         let_value([self = this->shared_from_this(), ctx = &ctx,
+                    socket](auto len) {
+           const auto sent = static_cast<ssize_t>(len);
+           return release_sender{self, ctx, socket, self->sent_(sent), sent};
+         });
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::sends() const noexcept -> size_type
+{
+  return sends_;
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::copied() const noexcept -> size_type
+{
+  return copied_;
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::pending() const noexcept -> size_type
+{
+  auto pending = size_type{0};
+  for (auto id = released_below_; id != next_id_; ++id)
+  {
+    if (!released_(id))
+      ++pending;
+  }
+  return pending;
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::enable_(
+    const socket_dialog &socket) noexcept -> bool
+{
+  using namespace io::socket;
+
+  if (std::exchange(probed_, true))
+    return enabled_;
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) &&                          \
+    __has_include(<linux/errqueue.h>)
+  const auto sockfd = static_cast<socket_type>(*socket.socket);
+
+  auto type = int{};
+  auto size = socklen_t{sizeof(type)};
+  if (::getsockopt(sockfd, SOL_SOCKET, SO_TYPE, &type, &size))
+    return false;
+  stream_ = (type == SOCK_STREAM);
+
+  const auto enable = int{1};
+  enabled_ = !::setsockopt(sockfd, SOL_SOCKET, SO_ZEROCOPY, &enable,
+                           sizeof(enable));
+#endif
+
+  return enabled_;
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::sent_(ssize_t len) noexcept
+    -> std::optional<std::uint32_t>
+{
+  // The kernel numbers every datagram, but a stream send is only numbered
+  // if it queued at least one byte.
+  if (!enabled_ || (stream_ && len <= 0))
+    return std::nullopt;
+
+  ++sends_;
+  return next_id_++;
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::released_(
+    std::uint32_t id) const noexcept -> bool
+{
+  // Send numbers wrap around, so they are compared by their distance.
+  if (static_cast<std::int32_t>(id - released_below_) < 0)
+    return true;
+
+  for (const auto &[lo, hi] : ranges_)
+  {
+    if (static_cast<std::int32_t>(id - lo) >= 0 &&
+        static_cast<std::int32_t>(hi - id) >= 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::release_(std::uint32_t lo,
+                                              std::uint32_t hi) -> void
+{
+  // Notifications for consecutive sends are usually coalesced into one
+  // range and arrive in order, but nothing guarantees that they do.
+  ranges_.emplace_back(lo, hi);
+
+  auto merged = true;
+  while (merged)
+  {
+    merged = false;
+    for (auto it = ranges_.begin(); it != ranges_.end(); ++it)
+    {
+      const auto [first, last] = *it;
+      if (static_cast<std::int32_t>(first - released_below_) > 0)
+        continue;
+
+      if (static_cast<std::int32_t>(last + 1 - released_below_) > 0)
+        released_below_ = last + 1;
+
+      ranges_.erase(it);
+      merged = true;
+      break;
+    }
+  }
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::drain_(socket_type socket) -> size_type
+{
+  auto drained = size_type{0};
+#if defined(MSG_ERRQUEUE) && __has_include(<linux/errqueue.h>)
+  alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(sock_extended_err)) +
+                                        CMSG_SPACE(sizeof(sockaddr_in6))>
+      control{};
+
+  while (true)
+  {
+    auto msg = msghdr{};
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    if (::recvmsg(socket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      return drained;
+    }
+
+    ++drained;
+    for (auto *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+      const bool recverr =
+          (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+          (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+      if (!recverr)
+        continue;
+
+      auto error = sock_extended_err{};
+      std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+      if (error.ee_errno != 0 || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+        continue;
+
+      if (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+        copied_ += error.ee_data - error.ee_info + 1;
+
+      release_(error.ee_info, error.ee_data);
+    }
+  }
+#endif
+  return drained;
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::complete_(int error) noexcept -> void
+{
+  // Completions can queue new waiters, so the completed waiters are
+  // unlinked before any of them run.
+  waiter *completed = nullptr;
+  for (auto **link = &waiters_; *link != nullptr;)
+  {
+    auto *op = *link;
+    if (error || released_(op->id))
+    {
+      *link = op->next;
+      op->next = std::exchange(completed, op);
+      continue;
+    }
+    link = &op->next;
+  }
+
+  while (completed)
+  {
+    auto *op = std::exchange(completed, completed->next);
+    op->complete(op, error);
+  }
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::wait_(async_context &ctx,
+                                           const socket_dialog &socket,
+                                           waiter *op) -> void
+{
+  if (released_(op->id))
+    return op->complete(op, 0);
+
+  op->next = std::exchange(waiters_, op);
+  arm_(ctx, socket);
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::arm_(async_context &ctx,
+                                          const socket_dialog &socket) -> void
+{
+  using namespace stdexec;
+
+  if (armed_)
+    return;
+
+  auto mux = socket.multiplexer.lock();
+  if (!mux)
+    return complete_(ENOTCONN);
+
+  armed_ = true;
+  if constexpr (net::execution::ErrorMultiplexer<multiplexer_type>)
+  {
+    const auto sockfd = static_cast<socket_type>(*socket.socket);
+    auto exec = [self = this->shared_from_this(), sockfd]() -> int {
+      // The wait also ends on a socket error or a hangup, which leave
+      // nothing on the error queue. The pending sends can't be released
+      // after that, so they fail.
+      auto error = int{};
+      if (!self->drain_(sockfd))
+      {
+        auto size = socklen_t{sizeof(error)};
+        if (::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &size) ||
+            !error)
+        {
+          error = EPIPE;
+        }
+      }
+
+      self->complete_(error);
+      if (self->waiters_)
+      {
+        errno = EAGAIN;
+        return -1;
+      }
+      return 0;
+    };
+
+    sender auto reader =
+        mux->set(socket.socket, multiplexer_type::ERRORS, std::move(exec)) |
+        then([self = this->shared_from_this()](auto &&) {
+          self->armed_ = false;
+        }) |
+        upon_error([self = this->shared_from_this()](auto &&) {
+          self->armed_ = false;
+          self->complete_(EIO);
+        }) |
+        upon_stopped([self = this->shared_from_this()] {
+          self->armed_ = false;
+          self->complete_(ECANCELED);
+        });
+
+    ctx.scope.spawn(std::move(reader));
+  }
+  else
+  {
+    poll_(ctx, socket);
+  }
+}
+
+template <typename AsyncContext>
+auto zerocopy_tracker<AsyncContext>::poll_(async_context &ctx,
+                                           const socket_dialog &socket)
+    -> void
+{
+  auto tick = [&ctx, self = this->shared_from_this(),
+               socket](net::timers::timer_id tid) {
+    if (ctx.scope.get_stop_token().stop_requested())
+      self->complete_(ECANCELED);
+
+    if (self->waiters_)
+    {
+      self->drain_(static_cast<socket_type>(*socket.socket));
+      self->complete_(0);
+    }
+
+    if (!self->waiters_)
+    {
+      self->armed_ = false;
+      ctx.timers.remove(tid);
+    }
+  };
+
+  ctx.timers.add(POLL_INTERVAL, std::move(tick), POLL_INTERVAL);
+}
+
+} // namespace net::service
+#endif // CPPNET_ZEROCOPY_IMPL_HPP
@@ -0,0 +1,139 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file send_file.hpp
+ * @brief This file declares a sender that transfers a file to a socket.
+ */
+#pragma once
+#ifndef CPPNET_SEND_FILE_HPP
+#define CPPNET_SEND_FILE_HPP
+#include <io/io.hpp>
+#include <stdexec/execution.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include <sys/types.h>
+/** @brief This namespace is for network services. */
+namespace net::service {
+/** @brief A progress callback that does nothing. */
+struct ignore_progress {
+  /** @brief Ignores the progress of a transfer. */
+  auto operator()(std::size_t /*sent*/,
+                  std::size_t /*count*/) const noexcept -> void
+  {}
+};
+
+/**
+ * @brief A sender that transfers bytes from a file descriptor to a socket
+ * in the kernel.
+ * @details Regular files, including memfds, are transferred with
+ * `sendfile`, and pipes are transferred with `splice`, so no data is
+ * copied through user space. The transfer writes as much as the socket
+ * accepts and waits for the socket to become writable through its
+ * multiplexer whenever the socket send buffer is full.
+ *
+ * The sender completes with the number of bytes transferred. This is less
+ * than the requested count if the file ends first, or if every writer
+ * closes a pipe first. A pipe that is empty while it still has writers is
+ * waited for through the multiplexer. The sender completes with an errno
+ * value if the transfer fails, in which case the progress callback has
+ * seen every byte that was transferred.
+ * @tparam Multiplexer The socket multiplexer type.
+ * @tparam Progress A callback with the signature
+ * `void(std::size_t sent, std::size_t count)`. It is called on the event
+ * loop thread after every chunk that is transferred.
+ */
+template <typename Multiplexer, typename Progress = ignore_progress>
+class file_sender {
+  template <typename Receiver> class operation;
+
+public:
+  /** @brief The sender concept. */
+  using sender_concept = stdexec::sender_t;
+  /** @brief The completion signatures. */
+  using completion_signatures =
+      stdexec::completion_signatures<stdexec::set_value_t(std::size_t),
+                                     stdexec::set_error_t(int),
+                                     stdexec::set_stopped_t()>;
+  /** @brief The socket dialog type. */
+  using socket_dialog = io::socket::socket_dialog<Multiplexer>;
+
+  /**
+   * @brief Constructor.
+   * @param socket The socket to write to.
+   * @param fd The file descriptor to read from.
+   * @param offset The file offset to start at. It is ignored for pipes.
+   * @param count The number of bytes to transfer.
+   * @param progress The progress callback.
+   */
+  file_sender(socket_dialog socket, int fd, off_t offset, std::size_t count,
+              Progress progress) noexcept;
+
+  /**
+   * @brief Connects the sender to a receiver.
+   * @tparam Receiver The receiver type.
+   * @param receiver The receiver.
+   * @returns The operation state.
+   */
+  template <stdexec::receiver Receiver>
+  auto connect(Receiver receiver) && -> operation<Receiver>;
+
+private:
+  /** @brief The socket. */
+  socket_dialog socket_;
+  /** @brief The file descriptor. */
+  int fd_;
+  /** @brief The file offset. */
+  off_t offset_;
+  /** @brief The number of bytes to transfer. */
+  std::size_t count_;
+  /** @brief The progress callback. */
+  Progress progress_;
+};
+
+/**
+ * @brief Transfers bytes from a file descriptor to a socket.
+ * @details The file descriptor must stay open until the sender completes.
+ * A regular file is read from `offset` without moving its file offset.
+ * @code
+ * auto fd = ::open("index.html", O_RDONLY);
+ * sender auto send = send_file(socket, fd, 0, size) |
+ *                    then([=](std::size_t len) { ::close(fd); });
+ * ctx.scope.spawn(std::move(send));
+ * @endcode
+ * @tparam Multiplexer The socket multiplexer type.
+ * @tparam Progress The progress callback type.
+ * @param socket The socket to write to.
+ * @param fd The file descriptor to read from.
+ * @param offset The file offset to start at. It is ignored for pipes.
+ * @param count The number of bytes to transfer.
+ * @param progress The progress callback.
+ * @returns A file_sender.
+ */
+template <typename Multiplexer, typename Progress = ignore_progress>
+auto send_file(const io::socket::socket_dialog<Multiplexer> &socket, int fd,
+               off_t offset, std::size_t count, Progress progress = {})
+    -> file_sender<Multiplexer, Progress>;
+
+} // namespace net::service
+
+#include "impl/send_file_impl.hpp" // IWYU pragma: export
+
+#endif // CPPNET_SEND_FILE_HPP
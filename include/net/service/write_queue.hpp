@@ -0,0 +1,256 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file write_queue.hpp
+ * @brief This file declares an outbound queue for one connection.
+ */
+#pragma once
+#ifndef CPPNET_WRITE_QUEUE_HPP
+#define CPPNET_WRITE_QUEUE_HPP
+#include "async_context.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+/** @brief This namespace is for network services. */
+namespace net::service {
+/**
+ * @brief Accounts for the bytes queued by every write queue of a service.
+ * @details The budget is exceeded once more than `high_water` bytes are
+ * queued. Callbacks that wait on an exceeded budget run once the queued
+ * bytes fall to `low_water` or below. A high water mark of 0 never
+ * exceeds the budget. Like write_queue, a budget must only be used on the
+ * thread that runs its context, but its counters can be read from any
+ * thread.
+ */
+class write_budget {
+public:
+  /** @brief The size type. */
+  using size_type = std::size_t;
+
+  /**
+   * @brief Constructor.
+   * @param high_water The high water mark, or 0 for no limit.
+   * @param low_water The low water mark. It is lowered to `high_water` if
+   * it is larger.
+   */
+  explicit write_budget(size_type high_water = 0,
+                        size_type low_water = 0) noexcept;
+  /** @brief Deleted copy constructor. */
+  write_budget(const write_budget &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const write_budget &) -> write_budget & = delete;
+
+  /**
+   * @brief Accounts for bytes that were queued.
+   * @param len The number of bytes.
+   */
+  auto acquire(size_type len) noexcept -> void;
+  /**
+   * @brief Accounts for bytes that were sent or dropped, and runs the
+   * waiting callbacks once the low water mark is reached.
+   * @param len The number of bytes.
+   */
+  auto release(size_type len) -> void;
+  /** @returns true if more than the high water mark is queued. */
+  [[nodiscard]] auto exceeded() const noexcept -> bool;
+  /**
+   * @brief Runs a callback once the queued bytes fall to the low water mark.
+   * @param func The callback.
+   */
+  auto wait(std::function<void()> func) -> void;
+  /** @returns The number of queued bytes. */
+  [[nodiscard]] auto queued() const noexcept -> size_type;
+  /** @returns The number of waiting callbacks. */
+  [[nodiscard]] auto waiting() const noexcept -> size_type;
+
+  /** @brief Default destructor. */
+  ~write_budget() = default;
+
+private:
+  /** @brief The high water mark. */
+  size_type high_water_;
+  /** @brief The low water mark. */
+  size_type low_water_;
+  /** @brief The number of queued bytes. */
+  std::atomic<size_type> queued_{0};
+  /** @brief The number of waiting callbacks. */
+  std::atomic<size_type> waiting_{0};
+  /** @brief The waiting callbacks. */
+  std::vector<std::function<void()>> waiters_;
+};
+
+/**
+ * @brief An outbound byte queue for one stream socket.
+ * @details Writes are appended to the queue and are sent in the order they
+ * were pushed, so a handler can write from many places without sequencing
+ * the sends itself. The first push into an empty queue waits for the
+ * socket to become writable through the context's poller. By the time the
+ * poller runs the wait, every buffer pushed during the same event loop
+ * iteration is in the queue, and they are all sent by a single `sendmsg`
+ * with one iovec per buffer. Partial writes are resumed from the first
+ * unsent byte the next time the socket is writable.
+ *
+ * A write_queue must only be used on the thread that runs its context.
+ * @tparam AsyncContext The asynchronous context type.
+ */
+template <typename AsyncContext>
+class write_queue
+    : public std::enable_shared_from_this<write_queue<AsyncContext>> {
+public:
+  /** @brief The asynchronous context type. */
+  using async_context = AsyncContext;
+  /** @brief The socket dialog type. */
+  using socket_dialog = typename async_context::socket_dialog;
+  /** @brief The size type. */
+  using size_type = std::size_t;
+  /** @brief The queued buffer type. */
+  using buffer_type = std::vector<std::byte>;
+
+  /** @brief Options that control how the queue is flushed. */
+  struct options_type {
+    /**
+     * @brief The largest number of buffers that are sent by one `sendmsg`.
+     */
+    size_type max_iovecs = DEFAULT_MAX_IOVECS;
+    /**
+     * @brief Sends every batch but the last one of a flush with
+     * `MSG_MORE` if true. `MSG_MORE` is the per-call form of `TCP_CORK`,
+     * it holds back partial segments until the flush ends.
+     */
+    bool cork = false;
+  };
+
+  /**
+   * @brief Constructor.
+   * @param options The queue options.
+   * @param budget A budget that is shared with other queues, or null.
+   */
+  explicit write_queue(options_type options = {},
+                       std::shared_ptr<write_budget> budget = {}) noexcept;
+  /** @brief Deleted copy constructor. */
+  write_queue(const write_queue &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const write_queue &) -> write_queue & = delete;
+
+  /**
+   * @brief Appends a buffer to the queue.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket to send on.
+   * @param buffer The buffer to send. The queue takes ownership of it.
+   */
+  auto push(async_context &ctx, const socket_dialog &socket,
+            buffer_type buffer) -> void;
+  /**
+   * @brief Appends a copy of a buffer to the queue.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket to send on.
+   * @param buffer The bytes to send.
+   */
+  auto push(async_context &ctx, const socket_dialog &socket,
+            std::span<const std::byte> buffer) -> void;
+
+  /**
+   * @brief Runs a callback once the queued bytes fall to a low water mark.
+   * @details The callback runs immediately if the queue is already at or
+   * below the mark. Otherwise it runs from the flush that reaches the mark,
+   * or when a send fails. Only the last callback is kept.
+   * @param low_water The low water mark.
+   * @param func The callback.
+   */
+  auto on_low_water(size_type low_water, std::function<void()> func) -> void;
+  /** @returns The number of bytes that are queued but not sent yet. */
+  [[nodiscard]] auto queued() const noexcept -> size_type;
+  /** @returns The number of sendmsg calls that the queue has made. */
+  [[nodiscard]] auto syscalls() const noexcept -> size_type;
+  /**
+   * @returns The errno value of the send that failed, or 0. Once a send
+   * fails the queue is cleared and every later push is dropped.
+   */
+  [[nodiscard]] auto error() const noexcept -> int;
+
+  /** @brief Default destructor. */
+  ~write_queue() = default;
+
+  /** @brief The default largest number of buffers per sendmsg. */
+  static constexpr size_type DEFAULT_MAX_IOVECS = 64;
+
+private:
+  /** @brief The native socket type. */
+  using socket_type = io::socket::native_socket_type;
+
+  /**
+   * @brief Sends queued buffers until the queue is empty or the socket
+   * would block.
+   * @param socket The native socket.
+   * @returns The number of bytes sent, or -1 with errno set.
+   */
+  auto flush_(socket_type socket) -> ssize_t;
+  /**
+   * @brief Waits for the socket to become writable and flushes the queue,
+   * if the wait isn't armed already.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket.
+   */
+  auto arm_(async_context &ctx, const socket_dialog &socket) -> void;
+  /**
+   * @brief Records a failed send and clears the queue.
+   * @param error The errno value.
+   */
+  auto fail_(int error) -> void;
+  /**
+   * @brief Accounts for bytes that left the queue.
+   * @param len The number of bytes.
+   */
+  auto release_(size_type len) -> void;
+
+  /** @brief The queue options. */
+  options_type options_;
+  /** @brief The shared budget. */
+  std::shared_ptr<write_budget> budget_;
+  /** @brief The queued buffers. */
+  std::deque<buffer_type> buffers_;
+  /** @brief The iovecs of the current sendmsg. */
+  std::vector<::iovec> iovecs_;
+  /** @brief The number of bytes of the first buffer that were sent. */
+  size_type offset_ = 0;
+  /** @brief The number of bytes that are queued but not sent yet. */
+  size_type queued_ = 0;
+  /** @brief The number of sendmsg calls. */
+  size_type syscalls_ = 0;
+  /** @brief The errno value of the send that failed. */
+  int error_ = 0;
+  /** @brief True while the writable wait is armed. */
+  bool armed_ = false;
+  /** @brief The low water mark of on_low_water_. */
+  size_type low_water_ = 0;
+  /** @brief Runs once the queue reaches the low water mark. */
+  std::function<void()> on_low_water_;
+};
+
+} // namespace net::service
+
+#include "impl/write_queue_impl.hpp" // IWYU pragma: export
+
+#endif // CPPNET_WRITE_QUEUE_HPP
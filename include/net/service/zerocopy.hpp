@@ -0,0 +1,225 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file zerocopy.hpp
+ * @brief This file declares a tracker for zero-copy sends.
+ */
+#pragma once
+#ifndef CPPNET_ZEROCOPY_HPP
+#define CPPNET_ZEROCOPY_HPP
+#include "async_context.hpp"
+#include "net/detail/concepts.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+/** @brief This namespace is for network services. */
+namespace net::service {
+/**
+ * @brief Sends messages on one socket with `MSG_ZEROCOPY`.
+ * @details A zero-copy send pins the pages of the message instead of
+ * copying them into the kernel, so the message must stay alive and
+ * unmodified until the kernel releases it. The kernel numbers every
+ * zero-copy send on a socket and reports released ranges of those numbers
+ * on the socket error queue. The tracker mirrors the numbering, and while
+ * any send is outstanding it keeps one reader armed on the error queue
+ * through the context's poller. A send completes once its number has been
+ * released.
+ *
+ * `SO_ZEROCOPY` is set on the first send. Platforms without zero-copy
+ * sends fall back to ordinary sends, which complete as soon as the message
+ * is copied. A tracker must only be used on the thread that runs its
+ * context, and it must be used for a single socket.
+ * @code
+ * auto zerocopy = std::make_shared<zerocopy_tracker<async_context>>();
+ * sender auto send = zerocopy->send(ctx, socket, msg) |
+ *                    then([buf = std::move(buf)](auto len) {
+ *                      // The kernel has released buf.
+ *                    });
+ * @endcode
+ * @note A socket with unread data is always readable, so the error queue
+ * reader never waits for the socket to become readable. Multiplexers that
+ * satisfy `ErrorMultiplexer` wait for the socket error alone. Any other
+ * multiplexer falls back to reading the error queue every
+ * `POLL_INTERVAL` until every send has been released.
+ * @tparam AsyncContext The asynchronous context type.
+ */
+template <typename AsyncContext>
+class zerocopy_tracker
+    : public std::enable_shared_from_this<zerocopy_tracker<AsyncContext>> {
+public:
+  /** @brief The asynchronous context type. */
+  using async_context = AsyncContext;
+  /** @brief The socket dialog type. */
+  using socket_dialog = typename async_context::socket_dialog;
+  /** @brief The size type. */
+  using size_type = std::size_t;
+  /** @brief A sender that completes when the kernel releases a send. */
+  class release_sender;
+
+  /** @brief Default constructor. */
+  zerocopy_tracker() = default;
+  /** @brief Deleted copy constructor. */
+  zerocopy_tracker(const zerocopy_tracker &) = delete;
+  /** @brief Deleted copy assignment. */
+  auto operator=(const zerocopy_tracker &) -> zerocopy_tracker & = delete;
+
+  /**
+   * @brief Sends a message without copying it.
+   * @tparam Message The socket message type.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket to send on.
+   * @param msg The message to send.
+   * @param flags Additional sendmsg flags.
+   * @returns A sender that completes with the number of bytes sent once
+   * the kernel has released the message, or with an errno value if the
+   * send fails.
+   */
+  template <typename Message>
+  auto send(async_context &ctx, const socket_dialog &socket, Message msg,
+            int flags = 0);
+
+  /** @returns The number of zero-copy sends. */
+  [[nodiscard]] auto sends() const noexcept -> size_type;
+  /**
+   * @returns The number of zero-copy sends that the kernel copied anyway,
+   * for instance because the route doesn't support scatter-gather I/O.
+   */
+  [[nodiscard]] auto copied() const noexcept -> size_type;
+  /** @returns The number of sends that haven't been released yet. */
+  [[nodiscard]] auto pending() const noexcept -> size_type;
+
+  /** @brief Default destructor. */
+  ~zerocopy_tracker() = default;
+
+  /**
+   * @brief How often the error queue is read by multiplexers that can't
+   * wait for a socket error alone.
+   */
+  static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(1);
+
+private:
+  /** @brief The native socket type. */
+  using socket_type = io::socket::native_socket_type;
+  /** @brief The multiplexer type. */
+  using multiplexer_type = typename async_context::multiplexer_type;
+
+  /** @brief A send that waits to be released. */
+  struct waiter {
+    /** @brief Completion function type. */
+    using complete_fn = auto(waiter *, int) noexcept -> void;
+
+    /** @brief The next waiter. */
+    waiter *next = nullptr;
+    /** @brief The send number. */
+    std::uint32_t id = 0;
+    /**
+     * @brief Completes the waiter. The second argument is an errno value,
+     * or 0 if the send was released.
+     */
+    complete_fn *complete = nullptr;
+  };
+
+  /**
+   * @brief Sets SO_ZEROCOPY on the socket the first time it is called.
+   * @param socket The socket to send on.
+   * @returns true if zero-copy sends are enabled.
+   */
+  auto enable_(const socket_dialog &socket) noexcept -> bool;
+  /**
+   * @brief Accounts for a completed send.
+   * @param len The number of bytes sent.
+   * @returns The number of the send, or nullopt if the send doesn't wait
+   * for a release.
+   */
+  auto sent_(ssize_t len) noexcept -> std::optional<std::uint32_t>;
+  /** @returns true if the send numbered `id` has been released. */
+  [[nodiscard]] auto released_(std::uint32_t id) const noexcept -> bool;
+  /**
+   * @brief Releases the sends numbered `lo` to `hi` inclusive.
+   * @param lo The first released send.
+   * @param hi The last released send.
+   */
+  auto release_(std::uint32_t lo, std::uint32_t hi) -> void;
+  /**
+   * @brief Reads every notification on the socket error queue.
+   * @param socket The native socket.
+   * @returns The number of notifications that were read.
+   */
+  auto drain_(socket_type socket) -> size_type;
+  /**
+   * @brief Completes waiters.
+   * @param error Completes every waiter with this errno value if it isn't
+   * 0, otherwise only the released waiters are completed.
+   */
+  auto complete_(int error) noexcept -> void;
+  /**
+   * @brief Completes a waiter if its send has been released, otherwise
+   * queues it and arms the error queue reader.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket.
+   * @param op The waiter.
+   */
+  auto wait_(async_context &ctx, const socket_dialog &socket,
+             waiter *op) -> void;
+  /**
+   * @brief Arms the error queue reader if it isn't armed already.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket.
+   */
+  auto arm_(async_context &ctx, const socket_dialog &socket) -> void;
+  /**
+   * @brief Reads the error queue with a periodic timer until every send
+   * has been released.
+   * @param ctx The context that the socket belongs to.
+   * @param socket The socket.
+   */
+  auto poll_(async_context &ctx, const socket_dialog &socket) -> void;
+
+  /** @brief True once SO_ZEROCOPY has been set. */
+  bool enabled_ = false;
+  /** @brief True once enabling SO_ZEROCOPY has been attempted. */
+  bool probed_ = false;
+  /** @brief True if the socket is a stream socket. */
+  bool stream_ = true;
+  /** @brief True while the error queue reader is armed. */
+  bool armed_ = false;
+  /** @brief The number of the next zero-copy send. */
+  std::uint32_t next_id_ = 0;
+  /** @brief Every send numbered below this one has been released. */
+  std::uint32_t released_below_ = 0;
+  /** @brief Released ranges above released_below_. */
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> ranges_;
+  /** @brief The sends that are waiting to be released. */
+  waiter *waiters_ = nullptr;
+  /** @brief The number of zero-copy sends. */
+  size_type sends_ = 0;
+  /** @brief The number of zero-copy sends that were copied. */
+  size_type copied_ = 0;
+};
+
+} // namespace net::service
+
+#include "impl/zerocopy_impl.hpp" // IWYU pragma: export
+
+#endif // CPPNET_ZEROCOPY_HPP
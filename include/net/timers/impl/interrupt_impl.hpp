@@ -21,9 +21,42 @@
 #ifndef CPPNET_INTERRUPT_IMPL_HPP
 #define CPPNET_INTERRUPT_IMPL_HPP
 #include "net/timers/interrupt.hpp"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+
+#include <thread>
+#include <utility>
 /** @brief This namespace is for timers and interrupts. */
 namespace net::timers {
 
+inline auto socketpair_interrupt_source_t::open() noexcept -> int
+{
+  return ::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets.data());
+}
+
+inline auto
+socketpair_interrupt_source_t::listener() const noexcept -> socket_type
+{
+  return sockets[0];
+}
+
+inline auto socketpair_interrupt_source_t::close() noexcept -> void
+{
+  auto socket = std::exchange(sockets[1], INVALID_SOCKET);
+  if (socket != INVALID_SOCKET)
+    io::socket::close(socket);
+}
+
+inline auto
+socketpair_interrupt_source_t::drain(socket_type socket) noexcept
+    -> std::int64_t
+{
+  static constexpr auto BUFLEN = 1024UL;
+  auto buffer = std::array<char, BUFLEN>{};
+  return ::recv(socket, buffer.data(), buffer.size(), 0);
+}
+
 inline auto socketpair_interrupt_source_t::interrupt() const noexcept -> void
 {
   using namespace io::socket;
@@ -33,6 +66,69 @@ inline auto socketpair_interrupt_source_t::interrupt() const noexcept -> void
   ::io::sendmsg(sockets[1], msg, MSG_NOSIGNAL);
 }
 
+#if __has_include(<sys/eventfd.h>)
+inline auto eventfd_interrupt_source_t::open() noexcept -> int
+{
+  event = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event < 0)
+    return -1;
+
+  auto writer = ::fcntl(event, F_DUPFD_CLOEXEC, 0);
+  if (writer < 0)
+  {
+    io::socket::close(std::exchange(event, INVALID_SOCKET));
+    return -1;
+  }
+
+  fd.store(writer);
+  return 0;
+}
+
+inline auto eventfd_interrupt_source_t::listener() const noexcept -> socket_type
+{
+  return event;
+}
+
+inline auto eventfd_interrupt_source_t::close() noexcept -> void
+{
+  auto writer = fd.exchange(INVALID_SOCKET);
+  if (writer == INVALID_SOCKET)
+    return;
+
+  // An interrupt that read the descriptor before the exchange is still
+  // writing to it.
+  while (writers.load())
+    std::this_thread::yield();
+
+  io::socket::close(writer);
+}
+
+inline auto
+eventfd_interrupt_source_t::drain(socket_type socket) noexcept -> std::int64_t
+{
+  auto count = ::eventfd_t{};
+  if (::eventfd_read(socket, &count))
+    return -1;
+
+  return static_cast<std::int64_t>(count);
+}
+
+inline auto eventfd_interrupt_source_t::interrupt() const noexcept -> void
+{
+  writers.fetch_add(1);
+  if (auto writer = fd.load(); writer != INVALID_SOCKET)
+    ::eventfd_write(writer, 1);
+  writers.fetch_sub(1);
+}
+
+inline auto swap(eventfd_interrupt_source_t &lhs,
+                 eventfd_interrupt_source_t &rhs) noexcept -> void
+{
+  std::swap(lhs.event, rhs.event);
+  rhs.fd.store(lhs.fd.exchange(rhs.fd.load()));
+}
+#endif
+
 template <InterruptSource Interrupt>
 inline auto interrupt<Interrupt>::operator()() const noexcept -> void
 {
@@ -18,6 +18,8 @@
 #define CPPNET_TIMERS_IMPL_HPP
 #include "net/detail/with_lock.hpp"
 #include "net/timers/timers.hpp"
+
+#include <algorithm>
 namespace net::timers {
 
 namespace detail {
@@ -71,6 +73,8 @@ auto swap(timers<I> &lhs, timers<I> &rhs) noexcept -> void
 
   auto lock = std::scoped_lock(lhs.mtx_, rhs.mtx_);
   swap(lhs.state_, rhs.state_);
+  swap(lhs.expired_, rhs.expired_);
+  rhs.owner_.store(lhs.owner_.exchange(rhs.owner_.load()));
   swap(static_cast<timers<I>::interrupt_type &>(lhs),
        static_cast<timers<I>::interrupt_type &>(rhs));
 }
@@ -86,7 +90,48 @@ template <InterruptSource Interrupt>
 auto timers<Interrupt>::add(timestamp when, handler_t handler,
                             duration period) -> timer_id
 {
-  auto lock = std::lock_guard(mtx_);
+  auto tid = INVALID_TIMER;
+  auto wake = false;
+  {
+    auto lock = std::lock_guard(mtx_);
+    wake = preempts_(when);
+    tid = insert_(when, std::move(handler), period);
+  }
+
+  if (wake)
+    Interrupt::interrupt();
+
+  return tid;
+}
+
+/**
+ * @brief Adds many timers with one lock acquisition and at most one
+ * interrupt.
+ */
+template <InterruptSource Interrupt>
+auto timers<Interrupt>::add_many(std::span<timer_spec> specs) -> void
+{
+  if (specs.empty())
+    return;
+
+  auto wake = false;
+  {
+    auto lock = std::lock_guard(mtx_);
+    auto earliest = std::ranges::min_element(specs, {}, &timer_spec::when);
+    wake = preempts_(earliest->when);
+
+    for (auto &[when, handler, period, id] : specs)
+      id = insert_(when, std::move(handler), period);
+  }
+
+  if (wake)
+    Interrupt::interrupt();
+}
+
+template <InterruptSource Interrupt>
+auto timers<Interrupt>::insert_(timestamp when, handler_t &&handler,
+                                duration period) -> timer_id
+{
   auto &[events, eventq, free_ids] = state_;
 
   // Add a new event. If an ID is free prefer that one.
@@ -107,12 +152,21 @@ auto timers<Interrupt>::add(timestamp when, handler_t handler,
 
   eventq.push({.expires_at = when, .id = tid});
 
-  // Notify the interrupt sink of a new event.
-  Interrupt::interrupt();
-
   return tid;
 }
 
+template <InterruptSource Interrupt>
+auto timers<Interrupt>::preempts_(timestamp when) const noexcept -> bool
+{
+  // The event loop recomputes its timeout after every resolve, so it
+  // never has to be interrupted by its own thread.
+  if (owner_.load(std::memory_order_relaxed) == std::this_thread::get_id())
+    return false;
+
+  const auto &eventq = state_.eventq;
+  return eventq.empty() || when < eventq.top().expires_at;
+}
+
 /**
  * @brief Overloaded `add` function that uses a `std::chrono::duration`
  * instead of a `time_point` for the first timeout.
@@ -156,22 +210,21 @@ auto timers<Interrupt>::remove(timer_id tid) noexcept -> timer_id
  * @brief Dequeues timers from an eventq.
  * @details Dequeues timers from the internal eventq of a
  * timers class state object. Armed timers that are dequeued
- * will be returned in a new vector. Unarmed timers that are
+ * are appended to `expired`. Unarmed timers that are
  * dequeued are pushed onto the internal free timer_id stack.
  * @tparam The timers class state.
  * @param state The internal state of a timers class.
- * @returns A vector of armed timer events.
+ * @param expired The vector to append armed timer events to. Its capacity
+ * is reused across calls, so the steady state doesn't allocate.
  */
 template <typename TimersState>
-auto dequeue_timers(TimersState &state) -> std::vector<detail::event_ref>
+auto dequeue_timers(TimersState &state,
+                    std::vector<detail::event_ref> &expired) -> void
 {
   using namespace detail;
   auto &[events, eventq, free_ids] = state;
 
   const auto now = clock::now();
-  auto tmp = std::vector<event_ref>(events.get_allocator());
-  tmp.reserve(events.size());
-
   while (!eventq.empty())
   {
     auto &next = eventq.top();
@@ -188,12 +241,10 @@ auto dequeue_timers(TimersState &state) -> std::vector<detail::event_ref>
     if (now < next.expires_at)
       break;
 
-    tmp.push_back(next);
+    expired.push_back(next);
     eventq.pop();
   }
-
-  return tmp;
-} // GCOVR_EXCL_LINE
+}
 
 /**
  * @brief Updates the timer state.
@@ -243,8 +294,11 @@ auto timers<Interrupt>::resolve() -> duration
   using namespace detail;
   using namespace std::chrono;
   auto &[events, eventq, free_ids] = state_;
+  owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
 
-  auto timers = with_lock(mtx_, [&] { return dequeue_timers(state_); });
+  auto &timers = expired_;
+  timers.clear();
+  with_lock(mtx_, [&] { dequeue_timers(state_, timers); });
 
   // Run handlers and remove unarmed timers.
   auto [unarmed, end] = std::ranges::remove_if(timers, [&](event_ref ref) {
@@ -0,0 +1,406 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file timing_wheel_impl.hpp
+ * @brief This file defines a hierarchical timing wheel.
+ */
+#pragma once
+#ifndef CPPNET_TIMING_WHEEL_IMPL_HPP
+#define CPPNET_TIMING_WHEEL_IMPL_HPP
+#include "net/detail/with_lock.hpp"
+#include "net/timers/timing_wheel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+namespace net::timers {
+/** @brief Move constructor. */
+template <InterruptSource Interrupt>
+timing_wheel<Interrupt>::timing_wheel(timing_wheel &&other) noexcept
+    : timing_wheel()
+{
+  swap(*this, other);
+}
+
+/** @brief Move assignment. */
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::operator=(timing_wheel &&other) noexcept
+    -> timing_wheel &
+{
+  swap(*this, other);
+  return *this;
+}
+
+/** @brief Swap function. */
+template <InterruptSource I>
+auto swap(timing_wheel<I> &lhs, timing_wheel<I> &rhs) noexcept -> void
+{
+  using std::swap;
+  if (&lhs == &rhs)
+    return;
+
+  auto lock = std::scoped_lock(lhs.mtx_, rhs.mtx_);
+  swap(lhs.state_, rhs.state_);
+  swap(lhs.expired_, rhs.expired_);
+  rhs.owner_.store(lhs.owner_.exchange(rhs.owner_.load()));
+  swap(static_cast<timing_wheel<I>::interrupt_type &>(lhs),
+       static_cast<timing_wheel<I>::interrupt_type &>(rhs));
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::add(timestamp when, handler_t handler,
+                                  duration period) -> timer_id
+{
+  auto tid = INVALID_TIMER;
+  auto wake = false;
+  {
+    auto lock = std::lock_guard(mtx_);
+    wake = preempts_(when);
+    tid = insert_(when, std::move(handler), period);
+  }
+
+  if (wake)
+    Interrupt::interrupt();
+
+  return tid;
+}
+
+template <InterruptSource Interrupt>
+template <class Rep, class Period>
+auto timing_wheel<Interrupt>::add(std::chrono::duration<Rep, Period> when,
+                                  handler_t handler,
+                                  duration period) -> timer_id
+{
+  using namespace std::chrono;
+  auto timeout = clock::now() + duration_cast<duration>(when);
+  return add(timeout, std::move(handler), period);
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::add(std::uint64_t when, handler_t handler,
+                                  std::uint64_t period) -> timer_id
+{
+  return add(duration(when), std::move(handler), duration(period));
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::add_many(std::span<timer_spec> specs) -> void
+{
+  if (specs.empty())
+    return;
+
+  auto wake = false;
+  {
+    auto lock = std::lock_guard(mtx_);
+    auto earliest = std::ranges::min_element(specs, {}, &timer_spec::when);
+    wake = preempts_(earliest->when);
+
+    for (auto &[when, handler, period, id] : specs)
+      id = insert_(when, std::move(handler), period);
+  }
+
+  if (wake)
+    Interrupt::interrupt();
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::remove(timer_id tid) noexcept -> timer_id
+{
+  auto lock = std::lock_guard(mtx_);
+  if (tid >= state_.events.size())
+    return tid;
+
+  // Events that are being resolved aren't linked, they are released by
+  // resolve once their handler returns.
+  auto &event = state_.events[tid];
+  event.armed.clear();
+  if (event.linked)
+  {
+    unlink_(event);
+    release_(event);
+  }
+
+  return INVALID_TIMER;
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::resolve() -> duration
+{
+  using net::detail::with_lock;
+  using namespace std::chrono;
+  owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+  with_lock(mtx_, [&] { advance_(clock::now()); });
+
+  // Run handlers without holding the lock. Events are stored in a deque,
+  // so the pointers stay valid even if a handler adds more timers.
+  for (auto *event : expired_)
+  {
+    if (event->armed.test())
+      event->handler(event->id);
+
+    if (event->period.count() == 0)
+      event->armed.clear();
+  }
+
+  return with_lock(mtx_, [&] {
+    const auto current = state_.current;
+    for (auto *event : expired_)
+    {
+      if (!event->armed.test())
+      {
+        release_(*event);
+        continue;
+      }
+
+      event->expires_at += event->period;
+      event->tick = std::max(to_tick_(event->expires_at), current + 1);
+      link_(*event);
+    }
+    expired_.clear();
+
+    if (!state_.linked)
+      return duration(-1);
+
+    auto next = duration_cast<duration>(to_time_(next_tick_()) - clock::now());
+    return std::max(duration(0), next);
+  });
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::to_tick_(timestamp when) const noexcept
+    -> std::uint64_t
+{
+  const auto elapsed = when - state_.origin;
+  if (elapsed <= clock::duration::zero())
+    return 0;
+
+  auto ticks = elapsed / RESOLUTION;
+  if (ticks * RESOLUTION < elapsed)
+    ++ticks;
+
+  return static_cast<std::uint64_t>(ticks);
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::to_time_(std::uint64_t tick) const noexcept
+    -> timestamp
+{
+  using namespace std::chrono;
+  return state_.origin + duration_cast<clock::duration>(
+                             RESOLUTION * static_cast<std::int64_t>(tick));
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::insert_(timestamp when, handler_t &&handler,
+                                      duration period) -> timer_id
+{
+  auto &[events, free_ids, wheels, occupied, origin, current, linked] = state_;
+
+  // Add a new event. If an ID is free prefer that one.
+  timer_id tid = events.size();
+  if (!free_ids.empty())
+  {
+    tid = free_ids.top();
+    free_ids.pop();
+  }
+
+  auto &event = (tid == events.size()) ? events.emplace_back() : events[tid];
+
+  event.handler = std::move(handler);
+  event.id = tid;
+  event.expires_at = when;
+  event.period = period;
+  event.tick = std::max(to_tick_(when), current + 1);
+  event.armed.test_and_set();
+  link_(event);
+
+  return tid;
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::link_(detail::wheel_event &event) noexcept
+    -> void
+{
+  static constexpr auto TOP = LEVELS - 1;
+  auto &[events, free_ids, wheels, occupied, origin, current, linked] = state_;
+
+  const auto delta = event.tick - current;
+  auto tick = event.tick;
+  auto level = std::size_t{0};
+  while (level < TOP && delta >= (1ULL << (BITS * (level + 1))))
+    ++level;
+
+  // Events beyond the range of the outermost wheel are parked in the slot
+  // that is processed last, and are re-hashed when it is processed.
+  if (delta >= (1ULL << (BITS * LEVELS)))
+    tick = ((current >> (BITS * TOP)) + SLOTS - 1) << (BITS * TOP);
+
+  const auto index = (tick >> (BITS * level)) & (SLOTS - 1);
+  auto &head = wheels[level][index];
+  event.prev = INVALID_TIMER;
+  event.next = head;
+  if (head != INVALID_TIMER)
+    events[head].prev = event.id;
+
+  head = event.id;
+  event.slot = static_cast<std::uint16_t>((level * SLOTS) + index);
+  event.linked = true;
+  occupied[level][index / 64] |= 1ULL << (index % 64);
+  ++linked;
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::unlink_(detail::wheel_event &event) noexcept
+    -> void
+{
+  auto &[events, free_ids, wheels, occupied, origin, current, linked] = state_;
+
+  const auto level = event.slot / SLOTS;
+  const auto index = event.slot % SLOTS;
+  auto &head = wheels[level][index];
+
+  (event.prev != INVALID_TIMER ? events[event.prev].next : head) = event.next;
+  if (event.next != INVALID_TIMER)
+    events[event.next].prev = event.prev;
+
+  if (head == INVALID_TIMER)
+    occupied[level][index / 64] &= ~(1ULL << (index % 64));
+
+  event.next = event.prev = INVALID_TIMER;
+  event.linked = false;
+  --linked;
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::release_(detail::wheel_event &event) noexcept
+    -> void
+{
+  event.handler = nullptr;
+  state_.free_ids.push(event.id);
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::cascade_(std::size_t level,
+                                       std::size_t slot) noexcept -> void
+{
+  auto &events = state_.events;
+  auto tid = state_.wheels[level][slot];
+  while (tid != INVALID_TIMER)
+  {
+    auto &event = events[tid];
+    tid = event.next;
+    unlink_(event);
+    link_(event);
+  }
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::advance_(timestamp now) -> void
+{
+  auto &[events, free_ids, wheels, occupied, origin, current, linked] = state_;
+  const auto elapsed = std::max(now - origin, clock::duration::zero());
+  const auto now_tick = static_cast<std::uint64_t>(elapsed / RESOLUTION);
+
+  // Jump straight from one tick with work to do to the next, so the cost
+  // of advancing doesn't depend on how long the event loop slept for.
+  while (linked && current < now_tick)
+  {
+    const auto next = next_tick_();
+    if (next > now_tick)
+      break;
+
+    current = next;
+    for (auto level = LEVELS - 1; level > 0; --level)
+    {
+      const auto shift = BITS * level;
+      if ((next & ((1ULL << shift) - 1)) == 0)
+        cascade_(level, (next >> shift) & (SLOTS - 1));
+    }
+
+    auto tid = wheels[0][next & (SLOTS - 1)];
+    while (tid != INVALID_TIMER)
+    {
+      auto &event = events[tid];
+      tid = event.next;
+      unlink_(event);
+      expired_.push_back(&event);
+    }
+  }
+
+  current = std::max(current, now_tick);
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::next_tick_() const noexcept -> std::uint64_t
+{
+  auto next = std::numeric_limits<std::uint64_t>::max();
+  for (std::size_t level = 0; level < LEVELS; ++level)
+  {
+    const auto shift = BITS * level;
+    const auto cycle = state_.current >> shift;
+    if (auto dist = distance_(state_.occupied[level], cycle & (SLOTS - 1)))
+      next = std::min(next, (cycle + dist) << shift);
+  }
+
+  return next;
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::distance_(const bitmap &bits,
+                                        std::size_t pos) noexcept
+    -> std::size_t
+{
+  // Returns the first occupied slot in [from, to), or SLOTS if there isn't
+  // one.
+  auto find = [&](std::size_t from, std::size_t to) -> std::size_t {
+    for (auto i = from; i < to; i = ((i / 64) + 1) * 64)
+    {
+      if (auto word = bits[i / 64] >> (i % 64))
+      {
+        const auto found = i + std::countr_zero(word);
+        return (found < to) ? found : SLOTS;
+      }
+    }
+    return SLOTS;
+  };
+
+  if (auto slot = find(pos + 1, SLOTS); slot != SLOTS)
+    return slot - pos;
+
+  if (auto slot = find(0, pos + 1); slot != SLOTS)
+    return slot + SLOTS - pos;
+
+  return 0;
+}
+
+template <InterruptSource Interrupt>
+auto timing_wheel<Interrupt>::preempts_(timestamp when) const noexcept
+    -> bool
+{
+  // The event loop recomputes its timeout after every resolve, so it
+  // never has to be interrupted by its own thread.
+  if (owner_.load(std::memory_order_relaxed) == std::this_thread::get_id())
+    return false;
+
+  if (!state_.linked)
+    return true;
+
+  return std::max(to_tick_(when), state_.current + 1) < next_tick_();
+}
+
+} // namespace net::timers
+#endif // CPPNET_TIMING_WHEEL_IMPL_HPP
@@ -23,6 +23,12 @@
 #include "net/detail/concepts.hpp"
 
 #include <io/io.hpp>
+#if __has_include(<sys/eventfd.h>)
+#include <sys/eventfd.h>
+#endif
+
+#include <atomic>
+#include <cstdint>
 /** @brief This namespace is for timers and interrupts. */
 namespace net::timers {
 /** @brief A socketpair interrupt source. */
@@ -33,14 +39,105 @@ struct socketpair_interrupt_source_t {
   static constexpr auto INVALID_SOCKET = io::socket::INVALID_SOCKET;
   /** @brief The socket pair. */
   std::array<socket_type, 2> sockets{INVALID_SOCKET, INVALID_SOCKET};
+  /**
+   * @brief Creates the socket pair.
+   * @returns 0 on success, otherwise -1 and errno is set.
+   */
+  inline auto open() noexcept -> int;
+  /**
+   * @brief The socket that interrupts are received on.
+   * @returns The receiving end of the socket pair.
+   */
+  [[nodiscard]] inline auto listener() const noexcept -> socket_type;
+  /**
+   * @brief Closes the sending end of the socket pair.
+   * @details The receiving end is owned by the event loop poller.
+   */
+  inline auto close() noexcept -> void;
+  /**
+   * @brief Consumes pending interrupts.
+   * @param socket The receiving end of the socket pair.
+   * @returns The number of interrupts consumed, otherwise -1 and errno is
+   * set.
+   */
+  static inline auto drain(socket_type socket) noexcept -> std::int64_t;
+  /**
+   * @brief The interrupt method.
+   * @details This method is needed to comply with the InterruptSource
+   * concept.
+   */
+  inline auto interrupt() const noexcept -> void;
+};
+
+#if __has_include(<sys/eventfd.h>)
+/**
+ * @brief An eventfd interrupt source.
+ * @details An interrupt is a single 8-byte write that increments the eventfd
+ * counter, so any number of interrupts that arrive before the event loop
+ * wakes up are consumed by a single read.
+ *
+ * The event loop poller owns the eventfd, so interrupts are written to a
+ * duplicate that the source owns until it is closed. Interrupts can be sent
+ * from any thread, and close() waits for the ones in flight, so an
+ * interrupt is never written to a descriptor number that has been reused.
+ */
+struct eventfd_interrupt_source_t {
+  /** @brief The native socket type. */
+  using socket_type = io::socket::native_socket_type;
+  /** @brief The invalid socket constant. */
+  static constexpr auto INVALID_SOCKET = io::socket::INVALID_SOCKET;
+  /** @brief The eventfd that is owned by the event loop poller. */
+  socket_type event{INVALID_SOCKET};
+  /** @brief The duplicate of the eventfd that interrupts are written to. */
+  std::atomic<socket_type> fd{INVALID_SOCKET};
+  /** @brief The number of interrupts that are being written. */
+  mutable std::atomic<std::uint32_t> writers{0};
+  /**
+   * @brief Creates the eventfd.
+   * @returns 0 on success, otherwise -1 and errno is set.
+   */
+  inline auto open() noexcept -> int;
+  /**
+   * @brief The descriptor that interrupts are received on.
+   * @returns The eventfd.
+   */
+  [[nodiscard]] inline auto listener() const noexcept -> socket_type;
+  /**
+   * @brief Stops sending interrupts and closes the duplicate eventfd.
+   * @details The eventfd itself is owned by the event loop poller.
+   */
+  inline auto close() noexcept -> void;
+  /**
+   * @brief Consumes pending interrupts.
+   * @param socket The eventfd.
+   * @returns The number of interrupts consumed, otherwise -1 and errno is
+   * set.
+   */
+  static inline auto drain(socket_type socket) noexcept -> std::int64_t;
   /**
    * @brief The interrupt method.
    * @details This method is needed to comply with the InterruptSource
    * concept.
    */
   inline auto interrupt() const noexcept -> void;
+
+  /**
+   * @brief Swaps two eventfd interrupt sources.
+   * @details Neither source may be sending interrupts.
+   * @param lhs The left hand side.
+   * @param rhs The right hand side.
+   */
+  friend inline auto swap(eventfd_interrupt_source_t &lhs,
+                          eventfd_interrupt_source_t &rhs) noexcept -> void;
 };
 
+/** @brief The default interrupt source. */
+using default_interrupt_source_t = eventfd_interrupt_source_t;
+#else
+/** @brief The default interrupt source. */
+using default_interrupt_source_t = socketpair_interrupt_source_t;
+#endif
+
 /**
  * @brief An interrupt is an immediately run timer event.
  * @tparam Interrupt An interrupt source tag compliant with the InterruptSoruce
@@ -18,19 +18,33 @@
 #define CPPNET_TIMERS_HPP
 #include "interrupt.hpp"
 #include "net/detail/concepts.hpp"
+#include "net/detail/inplace_function.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <queue>
+#include <span>
 #include <stack>
+#include <thread>
+#include <vector>
 namespace net::timers {
 
 /** @brief timer_id type. */
 using timer_id = std::size_t;
 /** @brief Invalid timer_id. */
 static constexpr timer_id INVALID_TIMER = -1;
-/** @brief handler type. */
-using handler_t = std::function<void(timer_id)>;
+/**
+ * @brief The inline storage of a handler in bytes. This fits a socket
+ * dialog, a shared_ptr, a span and a reference.
+ */
+inline constexpr std::size_t HANDLER_SIZE = 80;
+/**
+ * @brief handler type.
+ * @details Handlers are move-only and are stored inline, so adding a timer
+ * never allocates. Callables larger than `HANDLER_SIZE` don't compile.
+ */
+using handler_t = net::detail::inplace_function<void(timer_id), HANDLER_SIZE>;
 /** @brief clock type. */
 using clock = std::chrono::steady_clock;
 /** @brief time type. */
@@ -38,6 +52,18 @@ using timestamp = std::chrono::time_point<clock>;
 /** @brief duration type. */
 using duration = std::chrono::microseconds;
 
+/** @brief The arguments of a timer added with `timers::add_many`. */
+struct timer_spec {
+  /** @brief The time at which the handler is invoked. */
+  timestamp when;
+  /** @brief The callable that is invoked when the timer fires. */
+  handler_t handler;
+  /** @brief The timer period. Only used for periodic timers. */
+  duration period{};
+  /** @brief The id of the new timer. Set by `add_many`. */
+  timer_id id = INVALID_TIMER;
+};
+
 /** @brief Internal timer implementation details. */
 namespace detail {
 /** @brief The event structure. */
@@ -96,6 +122,11 @@ inline auto operator==(const event_ref &lhs, const event_ref &rhs) -> bool;
  * events in the internal event queue, then the resolve method returns
  * `duration(-1)`, otherwise the returned duration contains a strictly
  * non-negative count.
+ *
+ * The interrupt is only raised when a timer is added from a thread other
+ * than the one that calls `resolve`, and only when the new timer expires
+ * before every timer that is already queued. In every other case the event
+ * loop is guaranteed to wake up in time on its own.
  */
 template <InterruptSource Interrupt>
 class timers : public interrupt<Interrupt> {
@@ -156,6 +187,15 @@ public:
   auto add(std::uint64_t when, handler_t handler,
            std::uint64_t period = 0) -> timer_id;
 
+  /**
+   * @brief Adds many timers with one lock acquisition and at most one
+   * interrupt.
+   * @details The id of each new timer is written to its spec, so adding
+   * timers in a batch doesn't allocate.
+   * @param specs The timers to add. Their handlers are moved from.
+   */
+  auto add_many(std::span<timer_spec> specs) -> void;
+
   /**
    * @brief Removes the timer with the given id.
    * @param tid The timer_id to remove.
@@ -187,6 +227,24 @@ private:
   template <typename T>
   using minheap = std::priority_queue<T, std::vector<T>, std::greater<>>;
 
+  /**
+   * @brief Inserts a new timer. Must be called while holding the lock.
+   * @param when The time at which the handler is invoked.
+   * @param handler The callable that is invoked when the timer fires.
+   * @param period The timer period.
+   * @returns The id associated with the timer.
+   */
+  auto insert_(timestamp when, handler_t &&handler,
+               duration period) -> timer_id;
+  /**
+   * @brief Checks if adding a timer needs to interrupt the event loop.
+   * Must be called while holding the lock, before the timer is inserted.
+   * @param when The time at which the new timer expires.
+   * @returns true if the caller isn't the event loop thread and the timer
+   * expires before the current earliest timer.
+   */
+  [[nodiscard]] auto preempts_(timestamp when) const noexcept -> bool;
+
   /** @brief Internal state. */
   struct {
     /** @brief The vector that holds all active events. */
@@ -194,9 +252,14 @@ private:
     /** @brief The minheap that stores timeouts. */
     minheap<detail::event_ref> eventq;
     /** @brief A pool of recyclable timer_ids */
-    std::stack<timer_id> free_ids;
+    std::stack<timer_id, std::vector<timer_id>> free_ids;
   } state_;
 
+  /** @brief Scratch space for the events that expire in a resolve. */
+  std::vector<detail::event_ref> expired_;
+
+  /** @brief The thread that last called resolve. */
+  std::atomic<std::thread::id> owner_;
   /** @brief mutex for thread-safety. */
   mutable std::mutex mtx_;
 };
@@ -0,0 +1,291 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file timing_wheel.hpp
+ * @brief This file declares a hierarchical timing wheel.
+ */
+#pragma once
+#ifndef CPPNET_TIMING_WHEEL_HPP
+#define CPPNET_TIMING_WHEEL_HPP
+#include "timers.hpp"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <vector>
+namespace net::timers {
+/** @brief Internal timer implementation details. */
+namespace detail {
+/** @brief A timing wheel event. */
+struct wheel_event {
+  /** @brief An event handler. */
+  handler_t handler;
+  /** @brief The timer id. */
+  timer_id id = INVALID_TIMER;
+  /** @brief The time at which the event expires. */
+  timestamp expires_at;
+  /** @brief The timer period. */
+  duration period{};
+  /** @brief The wheel tick at which the event expires. */
+  std::uint64_t tick = 0;
+  /** @brief The next event in the same slot. */
+  timer_id next = INVALID_TIMER;
+  /** @brief The previous event in the same slot. */
+  timer_id prev = INVALID_TIMER;
+  /** @brief The slot that the event is linked into. */
+  std::uint16_t slot = 0;
+  /** @brief Whether the event is linked into a slot. */
+  bool linked = false;
+  /** @brief A flag to determine if the timer is armed. */
+  std::atomic_flag armed;
+};
+} // namespace detail.
+
+/**
+ * @brief Provides event-loop timers backed by a hierarchical timing wheel.
+ * @tparam Interrupt An interrupt source that satisfies the InterruptSource
+ * concept.
+ * @details `timing_wheel` is a drop-in replacement for `timers` with the
+ * same `add`, `remove` and `resolve` interface. Instead of a min-heap it
+ * hashes each timer into one of `SLOTS` slots on one of `LEVELS` wheels, so
+ * arming and cancelling a timer are both O(1). Cancelled timers are unlinked
+ * immediately rather than when their deadline passes, and memory is bounded
+ * by the maximum number of concurrently armed timers. Timers are resolved
+ * with a granularity of `RESOLUTION`, and never fire early.
+ *
+ * The wheels cover 2^32 ticks (about 49 days at 1 ms). Timers that expire
+ * further into the future are parked in the outermost wheel and re-hashed as
+ * their deadline approaches.
+ * @code
+ * using wheel_timers = timing_wheel<default_interrupt_source_t>;
+ * using context = basic_async_context<poll_multiplexer, wheel_timers>;
+ * @endcode
+ */
+template <InterruptSource Interrupt>
+class timing_wheel : public interrupt<Interrupt> {
+public:
+  /** @brief The base interrupt type. */
+  using interrupt_type = interrupt<Interrupt>;
+
+  /** @brief The duration of one tick of the innermost wheel. */
+  static constexpr auto RESOLUTION = std::chrono::milliseconds(1);
+  /** @brief The number of slots per wheel. */
+  static constexpr std::size_t SLOTS = 256;
+  /** @brief The number of wheels. */
+  static constexpr std::size_t LEVELS = 4;
+
+  /** @brief Default constructor. */
+  timing_wheel() = default;
+  /** @brief Deleted copy constructor. */
+  timing_wheel(const timing_wheel &other) = delete;
+  /** @brief Move constructor. */
+  timing_wheel(timing_wheel &&other) noexcept;
+
+  /** @brief Deleted copy assignment. */
+  auto operator=(const timing_wheel &other) = delete;
+  /** @brief Move assignment. */
+  auto operator=(timing_wheel &&other) noexcept -> timing_wheel &;
+
+  /** @brief Swap function. */
+  template <InterruptSource I>
+  friend auto swap(timing_wheel<I> &lhs,
+                   timing_wheel<I> &rhs) noexcept -> void;
+
+  /**
+   * @brief Add a new timer.
+   * @param when The time at which the handler is invoked.
+   * @param handler The callable that is invoked when the timer fires.
+   * @param period The periodicity at which the timer fires. Only used for
+   * periodic timers.
+   * @returns The id associated with this timer.
+   */
+  auto add(timestamp when, handler_t handler,
+           duration period = duration::zero()) -> timer_id;
+
+  /**
+   * @brief Overloaded `add` function that uses a `std::chrono::duration`
+   * instead of a `time_point` for the first timeout.
+   * @tparam Rep The arithmetic tick type for a `std::chrono::duration`.
+   * @tparam Period The `std::ratio` of a `std::chrono::duration`.
+   * @param when The time until the timer times out.
+   * @param handler The timer event handler.
+   * @param period The time between events for a periodic timer.
+   * @returns The id associated with this timer.
+   */
+  template <class Rep, class Period>
+  auto add(std::chrono::duration<Rep, Period> when, handler_t handler,
+           duration period = duration::zero()) -> timer_id;
+
+  /**
+   * @brief Overloaded `add` function that uses a uint64_t instead of a
+   * `time_point` for the first timeout and the period.
+   * @param when The number of microseconds until the event times out.
+   * @param handler The event handler.
+   * @param period The number of microseconds between events for a periodic
+   * timer.
+   * @returns The id associated with this timer.
+   */
+  auto add(std::uint64_t when, handler_t handler,
+           std::uint64_t period = 0) -> timer_id;
+
+  /**
+   * @brief Adds many timers with one lock acquisition and at most one
+   * interrupt.
+   * @details The id of each new timer is written to its spec, so adding
+   * timers in a batch doesn't allocate.
+   * @param specs The timers to add. Their handlers are moved from.
+   */
+  auto add_many(std::span<timer_spec> specs) -> void;
+
+  /**
+   * @brief Removes the timer with the given id.
+   * @param tid The timer_id to remove.
+   * @returns tid if the timer is not valid. Otherwise returns INVALID_TIMER.
+   */
+  auto remove(timer_id tid) noexcept -> timer_id;
+
+  /**
+   * @brief Resolves all expired event handles.
+   * @returns The duration until the next event times out. Returns
+   * `duration(-1)` if there are no armed timers.
+   */
+  auto resolve() -> duration;
+
+  /** @brief Default destructor. */
+  ~timing_wheel() = default;
+
+private:
+  /** @brief The number of bits of a tick that index a wheel. */
+  static constexpr std::size_t BITS = 8;
+  /** @brief The number of occupancy words per wheel. */
+  static constexpr std::size_t WORDS = SLOTS / 64;
+  static_assert(SLOTS == (1UL << BITS) && SLOTS % 64 == 0,
+                "SLOTS must match BITS and fill whole occupancy words.");
+
+  /** @brief The slot heads of a wheel. */
+  using wheel = std::array<timer_id, SLOTS>;
+  /** @brief The slot occupancy bitmap of a wheel. */
+  using bitmap = std::array<std::uint64_t, WORDS>;
+
+  /**
+   * @brief Converts a timestamp to the first tick at or after it.
+   * @param when The timestamp.
+   * @returns The tick.
+   */
+  [[nodiscard]] auto to_tick_(timestamp when) const noexcept -> std::uint64_t;
+  /**
+   * @brief Converts a tick to the time at which it starts.
+   * @param tick The tick.
+   * @returns The timestamp.
+   */
+  [[nodiscard]] auto to_time_(std::uint64_t tick) const noexcept -> timestamp;
+  /**
+   * @brief Inserts a new timer. Must be called while holding the lock.
+   * @returns The id associated with the timer.
+   */
+  auto insert_(timestamp when, handler_t &&handler,
+               duration period) -> timer_id;
+  /**
+   * @brief Links an event into the slot for its tick. Must be called while
+   * holding the lock.
+   * @param event The event to link.
+   */
+  auto link_(detail::wheel_event &event) noexcept -> void;
+  /**
+   * @brief Unlinks an event from its slot. Must be called while holding the
+   * lock.
+   * @param event The event to unlink.
+   */
+  auto unlink_(detail::wheel_event &event) noexcept -> void;
+  /**
+   * @brief Recycles the id of an event. Must be called while holding the
+   * lock.
+   * @param event The event to release.
+   */
+  auto release_(detail::wheel_event &event) noexcept -> void;
+  /**
+   * @brief Re-hashes every event in a slot. Must be called while holding the
+   * lock.
+   * @param level The wheel of the slot.
+   * @param slot The slot index.
+   */
+  auto cascade_(std::size_t level, std::size_t slot) noexcept -> void;
+  /**
+   * @brief Advances the wheels up to now and collects every expired event.
+   * Must be called while holding the lock.
+   * @param now The current time.
+   */
+  auto advance_(timestamp now) -> void;
+  /**
+   * @brief Finds the next tick at which a slot must be processed. Must be
+   * called while holding the lock, and only if a timer is armed.
+   * @returns The next tick after the current tick that has work to do.
+   */
+  [[nodiscard]] auto next_tick_() const noexcept -> std::uint64_t;
+  /**
+   * @brief Finds the distance from a slot to the next occupied slot.
+   * @param bits The occupancy bitmap of a wheel.
+   * @param pos The slot to search from. The search wraps around, so `pos`
+   * itself is the last slot that is checked.
+   * @returns A distance in [1, SLOTS], or 0 if the wheel is empty.
+   */
+  static auto distance_(const bitmap &bits,
+                        std::size_t pos) noexcept -> std::size_t;
+  /**
+   * @brief Checks if adding a timer needs to interrupt the event loop.
+   * Must be called while holding the lock, before the timer is inserted.
+   * @param when The time at which the new timer expires.
+   * @returns true if the caller isn't the event loop thread and the timer
+   * expires before the current earliest slot.
+   */
+  [[nodiscard]] auto preempts_(timestamp when) const noexcept -> bool;
+
+  /** @brief Internal state. */
+  struct {
+    /** @brief The storage for every event, indexed by timer_id. */
+    std::deque<detail::wheel_event> events;
+    /** @brief A pool of recyclable timer_ids */
+    std::stack<timer_id, std::vector<timer_id>> free_ids;
+    /** @brief The slot heads of every wheel. */
+    std::array<wheel, LEVELS> wheels = [] {
+      auto wheels = std::array<wheel, LEVELS>{};
+      for (auto &slots : wheels)
+        slots.fill(INVALID_TIMER);
+      return wheels;
+    }();
+    /** @brief The slot occupancy of every wheel. */
+    std::array<bitmap, LEVELS> occupied{};
+    /** @brief The time of tick zero. */
+    timestamp origin = clock::now();
+    /** @brief The last tick that has been processed. */
+    std::uint64_t current = 0;
+    /** @brief The number of linked events. */
+    std::size_t linked = 0;
+  } state_;
+
+  /** @brief Scratch space for the events that expire in a resolve. */
+  std::vector<detail::wheel_event *> expired_;
+  /** @brief The thread that last called resolve. */
+  std::atomic<std::thread::id> owner_;
+  /** @brief mutex for thread-safety. */
+  mutable std::mutex mtx_;
+};
+
+} // namespace net::timers
+
+#include "impl/timing_wheel_impl.hpp" // IWYU pragma: export
+
+#endif // CPPNET_TIMING_WHEEL_HPP
@@ -20,7 +20,13 @@
 #include <gtest/gtest.h>
 
 #include <condition_variable>
+#include <cstdlib>
+#include <ctime>
 #include <mutex>
+#include <optional>
+#include <sched.h>
+#include <thread>
+#include <vector>
 
 using namespace net::service;
 
@@ -30,14 +36,11 @@ TEST_F(AsyncContextTest, SignalTest)
 {
   auto ctx = async_context{};
 
-  int err = ::socketpair(AF_UNIX, SOCK_STREAM, 0, ctx.timers.sockets.data());
-  ASSERT_EQ(err, 0);
+  ASSERT_EQ(ctx.timers.open(), 0);
 
   ctx.signal(ctx.terminate);
 
-  auto buf = std::array<char, 5>();
-  auto msg = io::socket::socket_message<sockaddr_in>{.buffers = buf};
-  auto len = io::recvmsg(ctx.timers.sockets[0], msg, 0);
+  auto len = async_context::interrupt_source::drain(ctx.timers.listener());
   EXPECT_EQ(len, 1);
 }
 
@@ -107,4 +110,210 @@ TEST_F(AsyncContextTest, TestUser1Signal)
   }
   EXPECT_EQ(test_signal, service.user1);
 }
+TEST_F(AsyncContextTest, MpscQueueOrder)
+{
+  struct node : net::detail::mpsc_node {
+    int producer = 0;
+    int value = 0;
+  };
+  constexpr int PRODUCERS = 4;
+  constexpr int COUNT = 1000;
+
+  auto queue = net::detail::mpsc_queue<node>();
+  auto nodes = std::vector<node>(PRODUCERS * COUNT);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(queue.take(), nullptr);
+
+  auto producers = std::vector<std::thread>();
+  for (int i = 0; i < PRODUCERS; ++i)
+  {
+    producers.emplace_back([&, i] {
+      for (int j = 0; j < COUNT; ++j)
+      {
+        auto &n = nodes[i * COUNT + j];
+        n.producer = i;
+        n.value = j;
+        queue.push(&n);
+      }
+    });
+  }
+
+  // Values from each producer must come out in the order they were pushed.
+  auto next = std::vector<int>(PRODUCERS);
+  auto total = 0;
+  while (total < PRODUCERS * COUNT)
+  {
+    for (auto *n = queue.take(); n; n = static_cast<node *>(n->next), ++total)
+      ASSERT_EQ(n->value, next[n->producer]++);
+  }
+
+  for (auto &producer : producers)
+    producer.join();
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(AsyncContextTest, Scheduler)
+{
+  using namespace stdexec;
+  using enum async_context::context_states;
+
+  auto service = context_thread<test_service>();
+  service.start();
+  service.state.wait(PENDING);
+  ASSERT_EQ(service.state, STARTED);
+
+  auto scheduler = service.get_scheduler();
+  EXPECT_TRUE(scheduler == service.get_scheduler());
+
+  auto [tid] = sync_wait(schedule(scheduler) | then([] {
+                           return std::this_thread::get_id();
+                         })).value();
+  EXPECT_NE(tid, std::this_thread::get_id());
+}
+
+TEST_F(AsyncContextTest, Post)
+{
+  using enum async_context::context_states;
+
+  auto service = context_thread<test_service>();
+  service.start();
+  service.state.wait(PENDING);
+  ASSERT_EQ(service.state, STARTED);
+
+  constexpr int COUNT = 100;
+  auto mtx = std::mutex();
+  auto cv = std::condition_variable();
+  auto order = std::vector<int>();
+  for (int i = 0; i < COUNT; ++i)
+  {
+    service.post([&, i] {
+      auto lock = std::lock_guard{mtx};
+      order.push_back(i);
+      cv.notify_all();
+    });
+  }
+
+  auto lock = std::unique_lock{mtx};
+  cv.wait(lock, [&] { return order.size() == COUNT; });
+  for (int i = 0; i < COUNT; ++i)
+    EXPECT_EQ(order[i], i);
+}
+
+TEST_F(AsyncContextTest, SubMillisecondTimers)
+{
+  using namespace std::chrono;
+  using enum async_context::context_states;
+  using net::timers::timer_id;
+
+  auto service = context_thread<test_service>();
+  service.start();
+  service.state.wait(PENDING);
+  ASSERT_EQ(service.state, STARTED);
+
+  constexpr auto DEADLINE = microseconds(250);
+  constexpr auto SLACK = milliseconds(100);
+  constexpr int COUNT = 10;
+  auto mtx = std::mutex();
+  auto cv = std::condition_variable();
+  for (int i = 0; i < COUNT; ++i)
+  {
+    auto fired = std::optional<steady_clock::time_point>();
+    auto start = steady_clock::now();
+    service.timers.add(DEADLINE, [&](timer_id) {
+      auto lock = std::lock_guard{mtx};
+      fired = steady_clock::now();
+      cv.notify_all();
+    });
+
+    auto lock = std::unique_lock{mtx};
+    ASSERT_TRUE(
+        cv.wait_for(lock, seconds(1), [&] { return fired.has_value(); }));
+    // The timer never fires before its deadline.
+    EXPECT_GE(*fired - start, DEADLINE);
+    EXPECT_LT(*fired - start, DEADLINE + SLACK);
+  }
+}
+
+TEST_F(AsyncContextTest, SubMillisecondTimersDontSpin)
+{
+  using namespace std::chrono;
+  using enum async_context::context_states;
+  using net::timers::timer_id;
+
+  // CPU time is too noisy on a loaded machine to check by default.
+  if (!std::getenv("CPPNET_TIMING_TESTS"))
+    GTEST_SKIP() << "Set CPPNET_TIMING_TESTS to run timing tests.";
+
+  auto service = context_thread<test_service>();
+  service.start();
+  service.state.wait(PENDING);
+  ASSERT_EQ(service.state, STARTED);
+
+  auto cpu_time = [] {
+    auto now = timespec{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return seconds(now.tv_sec) + nanoseconds(now.tv_nsec);
+  };
+
+  constexpr auto PERIOD = microseconds(250);
+  constexpr auto WINDOW = milliseconds(100);
+  auto fired = std::atomic<int>(0);
+  auto wall_start = steady_clock::now();
+  auto cpu_start = cpu_time();
+  auto timer = service.timers.add(
+      PERIOD, [&](timer_id) { fired.fetch_add(1); }, PERIOD);
+
+  std::this_thread::sleep_for(WINDOW);
+  service.timers.remove(timer);
+  auto wall = steady_clock::now() - wall_start;
+  auto cpu = cpu_time() - cpu_start;
+
+  // A busy-looping event loop uses a whole CPU for the entire window.
+  EXPECT_GT(fired.load(), 0);
+  EXPECT_LT(cpu, wall * 9 / 10);
+}
+
+TEST_F(AsyncContextTest, PinnedContextThread)
+{
+  using enum async_context::context_states;
+
+  const auto cpus = allowed_cpus();
+  ASSERT_FALSE(cpus.empty());
+
+  auto service = context_thread<test_service>(thread_options{{cpus.back()}});
+  EXPECT_EQ(service.thread_id(), std::thread::id());
+  EXPECT_TRUE(service.affinity().empty());
+
+  service.start();
+  service.state.wait(PENDING);
+  ASSERT_EQ(service.state, STARTED);
+
+  EXPECT_NE(service.thread_id(), std::thread::id());
+  EXPECT_NE(service.thread_id(), std::this_thread::get_id());
+  EXPECT_EQ(service.affinity(), std::vector<int>{cpus.back()});
+
+  auto mtx = std::mutex();
+  auto cv = std::condition_variable();
+  auto cpu = -1;
+  service.post([&] {
+    auto lock = std::lock_guard{mtx};
+    cpu = sched_getcpu();
+    cv.notify_all();
+  });
+
+  auto lock = std::unique_lock{mtx};
+  cv.wait(lock, [&] { return cpu >= 0; });
+  EXPECT_EQ(cpu, cpus.back());
+}
+
+TEST_F(AsyncContextTest, PinToInvalidCpu)
+{
+  using enum async_context::context_states;
+
+  auto service = context_thread<test_service>(thread_options{{-1}});
+  service.start();
+  service.state.wait(PENDING);
+  EXPECT_EQ(service.state, STOPPED);
+  EXPECT_EQ(service.error(), std::errc::invalid_argument);
+}
 // NOLINTEND
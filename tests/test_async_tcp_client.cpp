@@ -0,0 +1,201 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// NOLINTBEGIN
+#include "net/service/async_context.hpp"
+#include "net/service/async_tcp_client.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <optional>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace net::service;
+
+class AsyncTcpClientTest : public ::testing::Test {
+protected:
+  using client_type = async_tcp_client<>;
+  using socket_dialog = client_type::socket_dialog;
+  template <typename T> using socket_address = io::socket::socket_address<T>;
+
+  auto SetUp() -> void override
+  {
+    ASSERT_EQ(ctx.timers.open(), 0);
+    listener = listen_(SOMAXCONN);
+  }
+
+  // Opens a loopback listener on an ephemeral port and points address at
+  // it.
+  auto listen_(int backlog) -> int
+  {
+    auto sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    auto sin = sockaddr_in{};
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    EXPECT_EQ(::bind(sockfd, reinterpret_cast<sockaddr *>(&sin), sizeof(sin)),
+              0);
+    EXPECT_EQ(::listen(sockfd, backlog), 0);
+
+    auto len = socklen_t{sizeof(sin)};
+    ::getsockname(sockfd, reinterpret_cast<sockaddr *>(&sin), &len);
+    address = socket_address<sockaddr_in>();
+    address->sin_family = AF_INET;
+    address->sin_addr = sin.sin_addr;
+    address->sin_port = sin.sin_port;
+    return sockfd;
+  }
+
+  // Runs the event loop and the timers until the checkout completes.
+  auto run(client_type::sender_type sender) -> std::optional<socket_dialog>
+  {
+    using namespace stdexec;
+    using namespace std::chrono;
+
+    auto done = false;
+    auto result = std::optional<socket_dialog>();
+    ctx.scope.spawn(std::move(sender) | then([&](socket_dialog socket) {
+                      result = std::move(socket);
+                      done = true;
+                    }) |
+                    upon_error([&](int err) {
+                      error = err;
+                      done = true;
+                    }));
+
+    const auto start = steady_clock::now();
+    while (!done && steady_clock::now() - start < seconds(2))
+    {
+      ctx.poller.wait_for(10);
+      ctx.timers.resolve();
+    }
+    EXPECT_TRUE(done);
+    return result;
+  }
+
+  auto TearDown() -> void override
+  {
+    ::close(listener);
+    ctx.timers.close();
+  }
+
+  async_context ctx;
+  int listener = -1;
+  int error = 0;
+  socket_address<sockaddr_in> address;
+};
+
+TEST_F(AsyncTcpClientTest, CheckoutReusesConnections)
+{
+  auto client = client_type();
+
+  auto first = run(client.checkout(ctx, address));
+  ASSERT_TRUE(first);
+  auto peer = ::accept(listener, nullptr, nullptr);
+  ASSERT_GE(peer, 0);
+
+  const auto sockfd =
+      static_cast<io::socket::native_socket_type>(*first->socket);
+  client.checkin(address, std::move(*first));
+  EXPECT_EQ(client.stats().idle, 1);
+
+  // The second checkout gets the same connection without a handshake.
+  auto second = run(client.checkout(ctx, address));
+  ASSERT_TRUE(second);
+  EXPECT_EQ(static_cast<io::socket::native_socket_type>(*second->socket),
+            sockfd);
+
+  auto stats = client.stats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.idle, 0);
+  EXPECT_DOUBLE_EQ(stats.hit_rate(), 0.5);
+
+  ::close(peer);
+}
+
+TEST_F(AsyncTcpClientTest, ClosedConnectionsAreDiscarded)
+{
+  auto client = client_type();
+
+  auto first = run(client.checkout(ctx, address));
+  ASSERT_TRUE(first);
+  auto peer = ::accept(listener, nullptr, nullptr);
+  ASSERT_GE(peer, 0);
+  client.checkin(address, std::move(*first));
+
+  // The peer closes the idle connection, so the next checkout connects
+  // again.
+  ::close(peer);
+  auto second = run(client.checkout(ctx, address));
+  ASSERT_TRUE(second);
+
+  auto stats = client.stats();
+  EXPECT_EQ(stats.hits, 0);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.discarded, 1);
+}
+
+TEST_F(AsyncTcpClientTest, MaxIdle)
+{
+  auto client = client_type({.max_idle = 1});
+
+  auto first = run(client.checkout(ctx, address));
+  auto second = run(client.checkout(ctx, address));
+  ASSERT_TRUE(first && second);
+
+  client.checkin(address, std::move(*first));
+  client.checkin(address, std::move(*second));
+  EXPECT_EQ(client.stats().idle, 1);
+  EXPECT_EQ(client.stats().discarded, 1);
+
+  client.clear();
+  EXPECT_EQ(client.stats().idle, 0);
+}
+
+TEST_F(AsyncTcpClientTest, ConnectRefused)
+{
+  auto client = client_type();
+
+  // Nothing listens on the port once the listener is closed.
+  ::close(listener);
+  listener = -1;
+
+  EXPECT_FALSE(run(client.connect(ctx, address)));
+  EXPECT_EQ(error, ECONNREFUSED);
+}
+
+TEST_F(AsyncTcpClientTest, ConnectTimeout)
+{
+  using namespace std::chrono;
+
+  auto client = client_type({.connect = {.timeout = milliseconds(50)}});
+
+  // A listener with a full accept queue drops new handshakes.
+  ::close(listener);
+  listener = listen_(0);
+  auto first = run(client.connect(ctx, address));
+  ASSERT_TRUE(first);
+
+  const auto start = steady_clock::now();
+  EXPECT_FALSE(run(client.connect(ctx, address)));
+  EXPECT_EQ(error, ETIMEDOUT);
+  EXPECT_GE(steady_clock::now() - start, milliseconds(40));
+}
+// NOLINTEND
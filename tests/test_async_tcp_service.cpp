@@ -17,8 +17,152 @@
 // NOLINTBEGIN
 #include "test_tcp_fixture.hpp"
 #include <atomic>
+#include <netinet/tcp.h>
+#include <string>
+#include <vector>
 using namespace net::service;
 
+struct options_echo_service : public async_tcp_service<options_echo_service> {
+  using Base = async_tcp_service<options_echo_service>;
+
+  template <typename T>
+  options_echo_service(socket_address<T> address, options_type options)
+      : Base(address, options)
+  {}
+
+  std::atomic<int> nodelay = -1;
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {
+    using namespace stdexec;
+
+    if (buf.empty())
+    {
+      auto value = 0;
+      auto len = socklen_t{sizeof(value)};
+      auto sockfd = static_cast<int>(*socket.socket);
+      ::getsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &value, &len);
+      nodelay = value;
+    }
+
+    auto msg = io::socket::socket_message<>{.buffers = buf};
+    sender auto sendmsg = io::sendmsg(socket, msg, 0) |
+                          then([&, socket, rctx](auto &&len) {
+                            submit_recv(ctx, socket, rctx);
+                          }) |
+                          upon_error([](auto &&error) {});
+
+    ctx.scope.spawn(std::move(sendmsg));
+  }
+};
+
+struct zerocopy_echo_service
+    : public async_tcp_service<zerocopy_echo_service> {
+  using Base = async_tcp_service<zerocopy_echo_service>;
+
+  template <typename T>
+  explicit zerocopy_echo_service(socket_address<T> address) : Base(address)
+  {}
+
+  std::atomic<std::size_t> released = 0;
+  std::atomic<std::size_t> sends = 0;
+  std::atomic<std::size_t> pending = 0;
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {
+    using namespace stdexec;
+
+    if (!rctx)
+      return;
+
+    // rctx owns buf, so it is kept alive until the kernel releases buf.
+    auto msg = io::socket::socket_message<>{.buffers = buf};
+    sender auto sendmsg = send_zerocopy(ctx, socket, rctx, msg) |
+                          then([&, socket, rctx](auto &&len) {
+                            sends = rctx->zerocopy->sends();
+                            pending = rctx->zerocopy->pending();
+                            ++released;
+                            submit_recv(ctx, socket, rctx);
+                          }) |
+                          upon_error([](auto &&error) {});
+
+    ctx.scope.spawn(std::move(sendmsg));
+  }
+};
+
+struct queued_echo_service : public async_tcp_service<queued_echo_service> {
+  using Base = async_tcp_service<queued_echo_service>;
+
+  template <typename T>
+  queued_echo_service(socket_address<T> address, options_type options)
+      : Base(address, options)
+  {}
+
+  static constexpr std::size_t COPIES = 8;
+  std::shared_ptr<write_queue_type> writes;
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {
+    if (!rctx)
+      return;
+
+    // Every copy of every byte is enqueued as its own buffer.
+    for (auto byte : buf)
+    {
+      for (std::size_t i = 0; i < COPIES; ++i)
+        enqueue(ctx, socket, rctx, std::span(&byte, 1));
+    }
+    writes = rctx->writes;
+    submit_recv(ctx, socket, std::move(rctx));
+  }
+};
+
+struct flood_service : public async_tcp_service<flood_service> {
+  using Base = async_tcp_service<flood_service>;
+
+  template <typename T>
+  flood_service(socket_address<T> address, options_type options)
+      : Base(address, options)
+  {}
+
+  static constexpr std::size_t FLOOD = 1024 * 1024UL;
+
+  // Accepted connections inherit the small send buffer, so the flood
+  // stays on the write queue until the client reads it.
+  auto initialize(const socket_handle &socket) -> std::error_code
+  {
+    auto size = 16 * 1024;
+    const auto sockfd = static_cast<io::socket::native_socket_type>(socket);
+    ::setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    return {};
+  }
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {
+    if (!rctx)
+      return;
+
+    // Only an 'x' floods, so other clients can have an empty write queue.
+    for (auto byte : buf)
+    {
+      if (byte != std::byte{'x'})
+        continue;
+
+      header_received(socket);
+      enqueue(ctx, socket, rctx, std::vector<std::byte>(FLOOD, byte));
+    }
+    submit_recv(ctx, socket, std::move(rctx));
+  }
+};
+
 TEST_F(AsyncTcpServiceTest, StartTest)
 {
   service_v4->start(*ctx);
@@ -179,4 +323,499 @@ TEST_F(AsyncTcpServiceTest, ServerDrainTest)
   server_v4->state.wait(STARTED);
   EXPECT_GE(test_counter, 2);
 }
+
+TEST_F(AsyncTcpServiceTest, ReadContextPool)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  constexpr auto CONNECTIONS = 3;
+  service_v4->start(*ctx);
+  EXPECT_EQ(service_v4->read_pool_stats().capacity, 0);
+
+  auto connect_all = [&] {
+    auto socks = std::vector<socket_handle>();
+    for (int i = 0; i < CONNECTIONS; ++i)
+    {
+      auto &sock = socks.emplace_back(AF_INET, SOCK_STREAM, 0);
+      EXPECT_EQ(connect(sock, addr_v4), 0);
+    }
+    while (service_v4->read_pool_stats().in_use < CONNECTIONS)
+    {
+      if (!ctx->poller.wait_for(2000))
+        break;
+    }
+    return socks;
+  };
+
+  EXPECT_EQ(connect_all().size(), CONNECTIONS);
+  // Closed connections return their read contexts to the pool.
+  while (service_v4->read_pool_stats().in_use > 0)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+
+  auto stats = service_v4->read_pool_stats();
+  EXPECT_EQ(stats.peak, CONNECTIONS);
+  EXPECT_EQ(stats.slabs, 1);
+
+  // New connections reuse them without growing the pool.
+  auto socks = connect_all();
+  EXPECT_EQ(service_v4->read_pool_stats().in_use, CONNECTIONS);
+  EXPECT_EQ(service_v4->read_pool_stats().capacity, stats.capacity);
+}
+
+TEST_F(AsyncTcpServiceTest, AdaptiveReadBuffers)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  constexpr auto CONNECTIONS = 3;
+  constexpr std::size_t BULK = 32 * 1024;
+  auto service = options_echo_service(
+      addr_v4, {.read_buffers = {.adaptive = true}});
+  service.start(*ctx);
+
+  auto socks = std::vector<socket_handle>();
+  for (int i = 0; i < CONNECTIONS; ++i)
+  {
+    auto &sock = socks.emplace_back(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(sock, addr_v4), 0);
+  }
+  while (service.read_pool_stats().in_use < CONNECTIONS)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+
+  // Idle connections don't hold a read buffer.
+  EXPECT_EQ(service.read_buffer_stats().in_use, 0);
+
+  auto data = std::vector<char>(BULK);
+  for (std::size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<char>(i % 251);
+
+  auto out = socket_message<sockaddr_in>{.buffers = std::span(data)};
+  ASSERT_EQ(sendmsg(socks[0], out, 0), BULK);
+
+  auto echoed = std::vector<char>();
+  auto buf = std::array<char, 4096>{};
+  auto in = socket_message{.buffers = buf};
+  while (echoed.size() < BULK)
+  {
+    ctx->poller.wait_for(50);
+    auto len = recvmsg(socks[0], in, MSG_DONTWAIT);
+    if (len > 0)
+      echoed.insert(echoed.end(), buf.begin(), buf.begin() + len);
+  }
+  EXPECT_EQ(echoed, data);
+
+  // The bulk transfer grew the buffer beyond the smallest size class, and
+  // the buffer went back to the pool once the connection went idle.
+  while (service.read_buffer_stats().in_use > 0)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  EXPECT_GT(service.read_buffer_stats().bytes_reserved, 16 * 512);
+
+  socks.clear();
+  while (service.read_pool_stats().in_use > 0)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+}
+
+TEST_F(AsyncTcpServiceTest, BatchedAccept)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  constexpr auto CONNECTIONS = 10;
+  auto service = options_echo_service(addr_v4, {.accept_budget = 4});
+  service.start(*ctx);
+
+  auto socks = std::vector<socket_handle>();
+  for (int i = 0; i < CONNECTIONS; ++i)
+  {
+    auto &sock = socks.emplace_back(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(sock, addr_v4), 0);
+  }
+  while (service.read_pool_stats().in_use < CONNECTIONS)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  EXPECT_EQ(service.read_pool_stats().in_use, CONNECTIONS);
+
+  auto buf = std::array<char, 1>{};
+  auto msg = socket_message{.buffers = buf};
+  for (auto &sock : socks)
+  {
+    auto out = socket_message<sockaddr_in>{.buffers = std::span("x", 1)};
+    ASSERT_EQ(sendmsg(sock, out, 0), 1);
+    while (recvmsg(sock, msg, MSG_DONTWAIT) != 1)
+      ASSERT_GT(ctx->poller.wait_for(2000), 0);
+    EXPECT_EQ(buf[0], 'x');
+  }
+}
+
+TEST_F(AsyncTcpServiceTest, TcpOptions)
+{
+  using namespace io;
+  using namespace io::socket;
+  using namespace std::chrono;
+
+  auto service = options_echo_service(
+      addr_v4,
+      {.tcp = {.backlog = 16, .defer_accept = 1, .fastopen = 16,
+               .nodelay = true}});
+  service.start(*ctx);
+  ASSERT_FALSE(ctx->scope.get_stop_token().stop_requested());
+
+  auto sock = socket_handle(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(sock, addr_v4), 0);
+
+  // With TCP_DEFER_ACCEPT the connection isn't accepted before it sends
+  // data.
+  ctx->poller.wait_for(100);
+  EXPECT_EQ(service.read_pool_stats().in_use, 0);
+
+  auto out = socket_message<sockaddr_in>{.buffers = std::span("x", 1)};
+  ASSERT_EQ(sendmsg(sock, out, 0), 1);
+
+  auto buf = std::array<char, 1>{};
+  auto msg = socket_message{.buffers = buf};
+  while (recvmsg(sock, msg, MSG_DONTWAIT) != 1)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  EXPECT_EQ(buf[0], 'x');
+  EXPECT_EQ(service.nodelay, 1);
+}
+
+TEST_F(AsyncTcpServiceTest, ZerocopyEcho)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  auto service = zerocopy_echo_service(addr_v4);
+  service.start(*ctx);
+
+  auto sock = socket_handle(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(sock, addr_v4), 0);
+
+  auto buf = std::array<char, 1>{};
+  auto msg = socket_message{.buffers = buf};
+  const char *data = "abc";
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    auto out = socket_message<sockaddr_in>{.buffers = std::span(data + i, 1)};
+    ASSERT_EQ(sendmsg(sock, out, 0), 1);
+    while (recvmsg(sock, msg, MSG_DONTWAIT) != 1)
+      ASSERT_GT(ctx->poller.wait_for(2000), 0);
+    EXPECT_EQ(buf[0], data[i]);
+
+    // The next read is only submitted once the kernel released the echo.
+    while (service.released < i + 1)
+      ASSERT_GT(ctx->poller.wait_for(2000), 0);
+    EXPECT_EQ(service.pending, 0);
+  }
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  EXPECT_EQ(service.sends, 3);
+#endif
+}
+
+TEST_F(AsyncTcpServiceTest, ZerocopyPipelined)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  auto service = zerocopy_echo_service(addr_v4);
+  service.start(*ctx);
+
+  auto sock = socket_handle(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(sock, addr_v4), 0);
+
+  // Each request is sent as soon as the last one is read, so the socket
+  // has unread data while the echo of the last one waits to be released.
+  const auto data = std::string("abcdefgh");
+  for (const auto &byte : data)
+  {
+    auto out = socket_message<sockaddr_in>{.buffers = std::span(&byte, 1)};
+    ASSERT_EQ(sendmsg(sock, out, 0), 1);
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  }
+
+  auto echoed = std::string();
+  auto buf = std::array<char, 8>{};
+  auto msg = socket_message{.buffers = buf};
+  auto polls = 0;
+  while (echoed.size() < data.size())
+  {
+    auto len = recvmsg(sock, msg, MSG_DONTWAIT);
+    if (len > 0)
+    {
+      echoed.append(buf.data(), len);
+      continue;
+    }
+
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+    ++polls;
+  }
+  EXPECT_EQ(echoed, data);
+
+  // The error queue isn't read on every turn of the event loop while a
+  // release is pending.
+  EXPECT_LT(polls, 1000);
+}
+
+TEST_F(AsyncTcpServiceTest, WriteQueue)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  auto service =
+      queued_echo_service(addr_v4, {.writes = {.max_iovecs = 16}});
+  service.start(*ctx);
+
+  auto sock = socket_handle(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(sock, addr_v4), 0);
+
+  auto out = socket_message<sockaddr_in>{.buffers = std::span("abcd", 4)};
+  ASSERT_EQ(sendmsg(sock, out, 0), 4);
+
+  constexpr auto COPIES = queued_echo_service::COPIES;
+  auto echoed = std::string();
+  auto buf = std::array<char, 64>{};
+  auto msg = socket_message{.buffers = buf};
+  while (echoed.size() < 4 * COPIES)
+  {
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+    auto len = recvmsg(sock, msg, MSG_DONTWAIT);
+    if (len > 0)
+      echoed.append(buf.data(), len);
+  }
+
+  auto expected = std::string();
+  for (auto c : std::string("abcd"))
+    expected.append(COPIES, c);
+  EXPECT_EQ(echoed, expected);
+
+  // The 32 buffers are sent 16 at a time.
+  ASSERT_TRUE(service.writes);
+  EXPECT_EQ(service.writes->syscalls(), 2);
+  EXPECT_EQ(service.writes->queued(), 0);
+  EXPECT_EQ(service.writes->error(), 0);
+}
+
+static auto drain_flood(async_context &ctx, io::socket::socket_handle &sock)
+    -> std::size_t
+{
+  using namespace io;
+  using namespace io::socket;
+
+  auto received = std::size_t{0};
+  auto buf = std::vector<char>(64 * 1024UL);
+  auto msg = socket_message{.buffers = buf};
+  for (int i = 0; i < 10000 && received < flood_service::FLOOD; ++i)
+  {
+    ctx.poller.wait_for(10);
+    auto len = recvmsg(sock, msg, MSG_DONTWAIT);
+    if (len > 0)
+      received += len;
+  }
+  return received;
+}
+
+TEST_F(AsyncTcpServiceTest, Backpressure)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  auto service = flood_service(
+      addr_v4, {.backpressure = {.high_water = 64 * 1024UL,
+                                 .low_water = 16 * 1024UL}});
+  service.start(*ctx);
+
+  auto sock = socket_handle(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(sock, addr_v4), 0);
+  auto out = socket_message<sockaddr_in>{.buffers = std::span("x", 1)};
+  ASSERT_EQ(sendmsg(sock, out, 0), 1);
+
+  // Reads pause as soon as the flood is queued.
+  while (service.write_queue_stats().paused == 0)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  EXPECT_GT(service.write_queue_stats().queued, 64 * 1024UL);
+
+  // Reads resume once the client has drained the queue.
+  EXPECT_EQ(drain_flood(*ctx, sock), flood_service::FLOOD);
+  EXPECT_EQ(service.write_queue_stats().paused, 0);
+  EXPECT_EQ(service.write_queue_stats().queued, 0);
+}
+
+TEST_F(AsyncTcpServiceTest, ServiceBackpressure)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  auto service = flood_service(
+      addr_v4, {.backpressure = {.service_high_water = 64 * 1024UL,
+                                 .service_low_water = 0}});
+  service.start(*ctx);
+
+  auto socks = std::vector<socket_handle>();
+  for (int i = 0; i < 2; ++i)
+  {
+    auto &sock = socks.emplace_back(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(sock, addr_v4), 0);
+    auto out = socket_message<sockaddr_in>{.buffers = std::span("x", 1)};
+    ASSERT_EQ(sendmsg(sock, out, 0), 1);
+  }
+
+  // Both connections pause on the service limit.
+  while (service.write_queue_stats().paused < 2)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+
+  for (auto &sock : socks)
+    EXPECT_EQ(drain_flood(*ctx, sock), flood_service::FLOOD);
+  EXPECT_EQ(service.write_queue_stats().paused, 0);
+  EXPECT_EQ(service.write_queue_stats().queued, 0);
+}
+
+TEST_F(AsyncTcpServiceTest, IdleTimeout)
+{
+  using namespace io;
+  using namespace io::socket;
+  using namespace std::chrono;
+
+  auto service =
+      options_echo_service(addr_v4, {.timeouts = {.idle = milliseconds(50)}});
+  service.start(*ctx);
+
+  auto sock = socket_handle(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(sock, addr_v4), 0);
+
+  auto out = socket_message<sockaddr_in>{.buffers = std::span("x", 1)};
+  ASSERT_EQ(sendmsg(sock, out, 0), 1);
+
+  // The echo arrives, then the idle connection is shut down.
+  auto buf = std::array<char, 1>{};
+  auto msg = socket_message{.buffers = buf};
+  while (recvmsg(sock, msg, MSG_DONTWAIT) != 1)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  EXPECT_EQ(service.reaper_stats().tracked, 1);
+
+  const auto start = steady_clock::now();
+  while (recvmsg(sock, msg, MSG_DONTWAIT) != 0)
+  {
+    ASSERT_LT(steady_clock::now() - start, seconds(2));
+    ctx->poller.wait_for(10);
+    ctx->timers.resolve();
+  }
+  EXPECT_GE(steady_clock::now() - start, milliseconds(40));
+
+  // The closed connection returns its read context to the pool.
+  while (service.read_pool_stats().in_use > 0)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+
+  auto stats = service.reaper_stats();
+  EXPECT_EQ(stats.expired, 1);
+  EXPECT_EQ(stats.tracked, 0);
+}
+
+TEST_F(AsyncTcpServiceTest, ClosedConnectionIsUntracked)
+{
+  using namespace io;
+  using namespace io::socket;
+  using namespace std::chrono;
+
+  auto service =
+      options_echo_service(addr_v4, {.timeouts = {.idle = seconds(10)}});
+  service.start(*ctx);
+
+  {
+    auto sock = socket_handle(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(sock, addr_v4), 0);
+
+    auto out = socket_message<sockaddr_in>{.buffers = std::span("x", 1)};
+    ASSERT_EQ(sendmsg(sock, out, 0), 1);
+
+    auto buf = std::array<char, 1>{};
+    auto msg = socket_message{.buffers = buf};
+    while (recvmsg(sock, msg, MSG_DONTWAIT) != 1)
+      ASSERT_GT(ctx->poller.wait_for(2000), 0);
+    EXPECT_EQ(service.reaper_stats().tracked, 1);
+  }
+
+  // The client closed, so the connection reads end of file and closes
+  // long before its deadline.
+  while (service.read_pool_stats().in_use > 0)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+
+  auto stats = service.reaper_stats();
+  EXPECT_EQ(stats.expired, 0);
+  EXPECT_EQ(stats.tracked, 0);
+}
+
+TEST_F(AsyncTcpServiceTest, PausedConnectionExpires)
+{
+  using namespace io;
+  using namespace io::socket;
+  using namespace std::chrono;
+
+  auto service = flood_service(
+      addr_v4, {.backpressure = {.service_high_water = 64 * 1024UL,
+                                 .service_low_water = 0},
+                .timeouts = {.header = milliseconds(100)}});
+  service.start(*ctx);
+
+  // The first client fills the write budget and completes its header.
+  auto flooder = socket_handle(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(flooder, addr_v4), 0);
+  auto flood = socket_message<sockaddr_in>{.buffers = std::span("x", 1)};
+  ASSERT_EQ(sendmsg(flooder, flood, 0), 1);
+  while (service.write_queue_stats().paused == 0)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+
+  // The second client pauses on the budget with an empty write queue, and
+  // never completes its header.
+  auto sock = socket_handle(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(sock, addr_v4), 0);
+  auto out = socket_message<sockaddr_in>{.buffers = std::span("y", 1)};
+  ASSERT_EQ(sendmsg(sock, out, 0), 1);
+  while (service.write_queue_stats().paused < 2)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+
+  // It closes at its deadline without waiting for the budget to drain.
+  const auto start = steady_clock::now();
+  while (service.read_pool_stats().in_use > 1)
+  {
+    ASSERT_LT(steady_clock::now() - start, seconds(2));
+    ctx->poller.wait_for(10);
+    ctx->timers.resolve();
+  }
+
+  auto buf = std::array<char, 1>{};
+  auto msg = socket_message{.buffers = buf};
+  EXPECT_EQ(recvmsg(sock, msg, MSG_DONTWAIT), 0);
+  EXPECT_EQ(service.reaper_stats().expired, 1);
+  EXPECT_EQ(service.write_queue_stats().paused, 1);
+}
+
+TEST_F(AsyncTcpServiceTest, HeaderTimeout)
+{
+  using namespace io;
+  using namespace io::socket;
+  using namespace std::chrono;
+
+  auto service = options_echo_service(
+      addr_v4, {.timeouts = {.idle = milliseconds(500),
+                             .header = milliseconds(100)}});
+  service.start(*ctx);
+
+  auto sock = socket_handle(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(sock, addr_v4), 0);
+
+  // A client that trickles bytes in never goes idle, but it never
+  // completes its header either.
+  auto out = socket_message<sockaddr_in>{.buffers = std::span("x", 1)};
+  auto buf = std::array<char, 16>{};
+  auto msg = socket_message{.buffers = buf};
+  const auto start = steady_clock::now();
+  while (recvmsg(sock, msg, MSG_DONTWAIT) != 0)
+  {
+    ASSERT_LT(steady_clock::now() - start, seconds(2));
+    sendmsg(sock, out, MSG_NOSIGNAL);
+    ctx->poller.wait_for(10);
+    ctx->timers.resolve();
+  }
+  EXPECT_LT(steady_clock::now() - start, milliseconds(500));
+  EXPECT_EQ(service.reaper_stats().expired, 1);
+}
 // NOLINTEND
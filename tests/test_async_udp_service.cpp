@@ -17,6 +17,162 @@
 // NOLINTBEGIN
 #include "test_udp_fixture.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <netinet/udp.h>
+
+struct zerocopy_udp_service : public async_udp_service<zerocopy_udp_service> {
+  using Base = async_udp_service<zerocopy_udp_service>;
+
+  template <typename T>
+  explicit zerocopy_udp_service(socket_address<T> address) : Base(address)
+  {}
+
+  std::atomic<std::size_t> released = 0;
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {
+    using namespace io::socket;
+    using namespace stdexec;
+
+    if (!rctx)
+      return;
+
+    // rctx owns buf, so it is kept alive until the kernel releases buf.
+    auto msg = socket_message<sockaddr_in6>{.address = *rctx->msg.address,
+                                            .buffers = buf};
+    sender auto sendmsg = send_zerocopy(ctx, socket, msg) |
+                          then([&, socket, rctx](auto &&len) {
+                            ++released;
+                            submit_recv(ctx, socket, rctx);
+                          }) |
+                          upon_error([](auto &&error) {});
+
+    ctx.scope.spawn(std::move(sendmsg));
+  }
+};
+
+struct batch_echo_service : public async_udp_service<batch_echo_service> {
+  using Base = async_udp_service<batch_echo_service>;
+
+  template <typename T>
+  batch_echo_service(socket_address<T> address, options_type options)
+      : Base(address, options)
+  {}
+
+  std::size_t largest = 0;
+  std::size_t received = 0;
+  bool queued = false;
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {}
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_batch> batch) -> void
+  {
+    using namespace io;
+    using namespace io::socket;
+
+    if (!batch)
+      return;
+
+    largest = std::max(largest, batch->size());
+    received += batch->size();
+    for (std::size_t i = 0; i < batch->size(); ++i)
+    {
+      const auto &address = *batch->slots[i].msg.address;
+      if (queued)
+      {
+        enqueue(ctx, socket, address, batch->buffer(i));
+        continue;
+      }
+
+      auto msg = socket_message<sockaddr_in6>{.address = address,
+                                              .buffers = batch->buffer(i)};
+      sendmsg(*socket.socket, msg, 0);
+    }
+    submit_recv(ctx, socket, std::move(batch));
+  }
+};
+
+struct gro_echo_service : public async_udp_service<gro_echo_service> {
+  using Base = async_udp_service<gro_echo_service>;
+
+  template <typename T>
+  gro_echo_service(socket_address<T> address, options_type options)
+      : Base(address, options)
+  {}
+
+  std::size_t reads = 0;
+  std::vector<std::size_t> segments;
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {
+    if (!rctx)
+      return;
+
+    ++reads;
+    rctx->for_each_segment(buf, [&](std::span<const std::byte> segment) {
+      segments.push_back(segment.size());
+    });
+
+    // The reply keeps the segment boundaries of the request.
+    enqueue(ctx, socket, *rctx->msg.address, buf, rctx->segment_size);
+    submit_recv(ctx, socket, std::move(rctx));
+  }
+};
+
+struct small_gro_service
+    : public async_udp_service<small_gro_service, 1024> {
+  using Base = async_udp_service<small_gro_service, 1024>;
+
+  template <typename T>
+  small_gro_service(socket_address<T> address, options_type options)
+      : Base(address, options)
+  {}
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {}
+};
+
+struct held_recv_service : public async_udp_service<held_recv_service> {
+  using Base = async_udp_service<held_recv_service>;
+
+  template <typename T>
+  held_recv_service(socket_address<T> address, options_type options)
+      : Base(address, options)
+  {}
+
+  // Read contexts that the handler has not re-armed yet.
+  std::vector<std::shared_ptr<read_context>> held;
+  std::vector<std::byte> received;
+  std::optional<socket_dialog> dialog;
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {
+    if (!rctx)
+      return;
+
+    dialog = socket;
+    received.insert(received.end(), buf.begin(), buf.end());
+    held.push_back(std::move(rctx));
+  }
+};
+
 TEST_F(AsyncUDPServiceTest, StartTest)
 {
   service_v4->start(*ctx);
@@ -84,6 +240,266 @@ TEST_F(AsyncUDPServiceTest, EchoTest)
   ASSERT_GT(n, 0);
 }
 
+TEST_F(AsyncUDPServiceTest, ZerocopyEcho)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  auto service = zerocopy_udp_service(addr_v6);
+  service.start(*ctx);
+
+  auto sock = socket_handle(AF_INET6, SOCK_DGRAM, 0);
+  auto buf = std::array<char, 1>{};
+  auto msg = socket_message{.buffers = buf};
+
+  const char *data = "abc";
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    auto len = sendmsg(sock,
+                       socket_message<sockaddr_in6>{
+                           .address = {addr_v6},
+                           .buffers = std::span(data + i, 1)},
+                       0);
+    ASSERT_EQ(len, 1);
+    while (recvmsg(sock, msg, MSG_DONTWAIT) != 1)
+      ASSERT_GT(ctx->poller.wait_for(2000), 0);
+    EXPECT_EQ(buf[0], data[i]);
+
+    while (service.released < i + 1)
+      ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  }
+}
+
+TEST_F(AsyncUDPServiceTest, BatchedRecv)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  constexpr auto DATAGRAMS = 8UL;
+  auto service = batch_echo_service(addr_v6, {.recv_batch = DATAGRAMS});
+  service.start(*ctx);
+
+  auto sock = socket_handle(AF_INET6, SOCK_DGRAM, 0);
+  const char *data = "abcdefgh";
+  for (std::size_t i = 0; i < DATAGRAMS; ++i)
+  {
+    auto len = sendmsg(sock,
+                       socket_message<sockaddr_in6>{
+                           .address = {addr_v6},
+                           .buffers = std::span(data + i, 1)},
+                       0);
+    ASSERT_EQ(len, 1);
+  }
+
+  // Every queued datagram is read by one recvmmsg and echoed in order.
+  while (service.received < DATAGRAMS)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  EXPECT_EQ(service.largest, DATAGRAMS);
+
+  auto buf = std::array<char, 1>{};
+  auto msg = socket_message{.buffers = buf};
+  for (std::size_t i = 0; i < DATAGRAMS; ++i)
+  {
+    ASSERT_EQ(recvmsg(sock, msg, 0), 1);
+    EXPECT_EQ(buf[0], data[i]);
+  }
+}
+
+TEST_F(AsyncUDPServiceTest, BatchDropsTruncatedDatagrams)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  auto service = batch_echo_service(
+      addr_v6, {.recv_batch = 4, .datagram_size = 4});
+  service.start(*ctx);
+
+  // The middle datagram is longer than a slot of the batch.
+  auto sock = socket_handle(AF_INET6, SOCK_DGRAM, 0);
+  for (const std::string data : {"ab", "abcdefgh", "cd"})
+  {
+    auto len = sendmsg(sock,
+                       socket_message<sockaddr_in6>{
+                           .address = {addr_v6},
+                           .buffers = std::span(data.data(), data.size())},
+                       0);
+    ASSERT_EQ(len, static_cast<ssize_t>(data.size()));
+  }
+
+  while (service.received < 2)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+
+  auto buf = std::array<char, 8>{};
+  auto msg = socket_message{.buffers = buf};
+  for (const std::string data : {"ab", "cd"})
+  {
+    ASSERT_EQ(recvmsg(sock, msg, 0), 2);
+    EXPECT_EQ(std::string(buf.data(), 2), data);
+  }
+  EXPECT_EQ(recvmsg(sock, msg, MSG_DONTWAIT), -1);
+}
+
+TEST_F(AsyncUDPServiceTest, BatchRequiresBatchHandler)
+{
+  // held_recv_service has no read_batch overload.
+  auto service = held_recv_service(addr_v6, {.recv_batch = 8});
+  service.start(*ctx);
+  EXPECT_TRUE(ctx->scope.get_stop_token().stop_requested());
+}
+
+TEST_F(AsyncUDPServiceTest, DatagramQueue)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  constexpr auto DATAGRAMS = 8UL;
+  constexpr auto MAX_BATCH = 4UL;
+  auto service = batch_echo_service(
+      addr_v6, {.recv_batch = DATAGRAMS, .sends = {.max_batch = MAX_BATCH}});
+  service.queued = true;
+  service.start(*ctx);
+
+  auto sock = socket_handle(AF_INET6, SOCK_DGRAM, 0);
+  const char *data = "abcdefgh";
+  for (std::size_t i = 0; i < DATAGRAMS; ++i)
+  {
+    auto len = sendmsg(sock,
+                       socket_message<sockaddr_in6>{
+                           .address = {addr_v6},
+                           .buffers = std::span(data + i, 1)},
+                       0);
+    ASSERT_EQ(len, 1);
+  }
+
+  auto buf = std::array<char, 1>{};
+  auto msg = socket_message{.buffers = buf};
+  for (std::size_t i = 0; i < DATAGRAMS; ++i)
+  {
+    while (recvmsg(sock, msg, MSG_DONTWAIT) != 1)
+      ASSERT_GT(ctx->poller.wait_for(2000), 0);
+    EXPECT_EQ(buf[0], data[i]);
+  }
+
+  // The replies to one read batch leave in as few sendmmsg calls as
+  // max_batch allows.
+  const auto &sends = service.send_queue();
+  ASSERT_TRUE(sends);
+  EXPECT_EQ(sends->sent(), DATAGRAMS);
+  EXPECT_EQ(sends->syscalls(), DATAGRAMS / MAX_BATCH);
+  EXPECT_EQ(sends->queued(), 0);
+}
+
+TEST_F(AsyncUDPServiceTest, GroRequiresLargeReads)
+{
+  // A 1 KiB read would truncate GRO reads.
+  auto service = small_gro_service(addr_v6, {.gro = true});
+  service.start(*ctx);
+  EXPECT_TRUE(ctx->scope.get_stop_token().stop_requested());
+}
+
+TEST_F(AsyncUDPServiceTest, SegmentationOffload)
+{
+#if defined(UDP_SEGMENT) && defined(UDP_GRO)
+  using namespace io::socket;
+
+  constexpr auto SEGMENTS = 10UL;
+  constexpr auto SEGMENT_SIZE = std::uint16_t{100};
+  auto service = gro_echo_service(addr_v6, {.gro = true});
+  service.start(*ctx);
+
+  auto data = std::vector<char>(SEGMENTS * SEGMENT_SIZE);
+  for (std::size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<char>(i / SEGMENT_SIZE);
+
+  // The client sends every segment with one GSO message.
+  auto sock = socket_handle(AF_INET6, SOCK_DGRAM, 0);
+  const auto sockfd = static_cast<native_socket_type>(sock);
+  auto iov = iovec{.iov_base = data.data(), .iov_len = data.size()};
+  alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(SEGMENT_SIZE))>
+      control{};
+  auto hdr = msghdr{};
+  hdr.msg_name = std::addressof(*addr_v6);
+  hdr.msg_namelen = sizeof(sockaddr_in6);
+  hdr.msg_iov = &iov;
+  hdr.msg_iovlen = 1;
+  hdr.msg_control = control.data();
+  hdr.msg_controllen = control.size();
+  auto *cmsg = CMSG_FIRSTHDR(&hdr);
+  cmsg->cmsg_level = SOL_UDP;
+  cmsg->cmsg_type = UDP_SEGMENT;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(SEGMENT_SIZE));
+  std::memcpy(CMSG_DATA(cmsg), &SEGMENT_SIZE, sizeof(SEGMENT_SIZE));
+  if (::sendmsg(sockfd, &hdr, 0) < 0)
+    GTEST_SKIP() << "UDP_SEGMENT is not supported.";
+
+  // With or without GRO, the handler sees every segment in order.
+  while (service.segments.size() < SEGMENTS)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  EXPECT_LE(service.reads, SEGMENTS);
+  EXPECT_EQ(service.segments,
+            std::vector<std::size_t>(SEGMENTS, SEGMENT_SIZE));
+
+  // The echo arrives as separate datagrams of the same size.
+  auto buf = std::array<char, SEGMENTS * SEGMENT_SIZE>{};
+  for (std::size_t i = 0; i < SEGMENTS; ++i)
+  {
+    auto len = ssize_t{};
+    while ((len = ::recv(sockfd, buf.data(), buf.size(), MSG_DONTWAIT)) < 0)
+      ASSERT_GT(ctx->poller.wait_for(2000), 0);
+    ASSERT_EQ(len, SEGMENT_SIZE);
+    EXPECT_EQ(buf[0], static_cast<char>(i));
+  }
+#else
+  GTEST_SKIP() << "UDP_SEGMENT is not supported.";
+#endif
+}
+
+TEST_F(AsyncUDPServiceTest, RecvDepth)
+{
+  using namespace io;
+  using namespace io::socket;
+
+  constexpr auto DEPTH = 4UL;
+  auto service = held_recv_service(addr_v6, {.recv_depth = DEPTH});
+  service.start(*ctx);
+
+  auto sock = socket_handle(AF_INET6, SOCK_DGRAM, 0);
+  const char *data = "abcdefgh";
+  for (std::size_t i = 0; i < 2 * DEPTH; ++i)
+  {
+    auto len = sendmsg(sock,
+                       socket_message<sockaddr_in6>{
+                           .address = {addr_v6},
+                           .buffers = std::span(data + i, 1)},
+                       0);
+    ASSERT_EQ(len, 1);
+  }
+
+  // Every read in flight completes although none has been re-armed.
+  while (service.held.size() < DEPTH)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  ctx->poller.wait_for(50);
+  EXPECT_EQ(service.held.size(), DEPTH);
+
+  // Each re-armed read reads one more datagram into its own buffer.
+  auto held = std::move(service.held);
+  service.held.clear();
+  for (const auto &rctx : held)
+    service.submit_recv(*ctx, *service.dialog, rctx);
+
+  while (service.received.size() < 2 * DEPTH)
+    ASSERT_GT(ctx->poller.wait_for(2000), 0);
+  EXPECT_EQ(service.held.size(), DEPTH);
+  for (const auto &rctx : service.held)
+    EXPECT_NE(std::ranges::find(held, rctx), held.end());
+
+  auto received = std::string(
+      reinterpret_cast<const char *>(service.received.data()),
+      service.received.size());
+  std::ranges::sort(received);
+  EXPECT_EQ(received, std::string(data, 2 * DEPTH));
+}
+
 TEST_F(AsyncUDPServiceTest, InitializeError)
 {
   using namespace io::socket;
@@ -0,0 +1,125 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// NOLINTBEGIN
+#include "net/service/context_pool.hpp"
+#include "test_tcp_fixture.hpp"
+#include "test_udp_fixture.hpp"
+
+#include <thread>
+#include <vector>
+
+TEST_F(AsyncTcpServiceTest, ContextPoolTcp)
+{
+  using namespace io;
+  using namespace io::socket;
+  using enum async_context::context_states;
+
+  constexpr auto THREADS = 4;
+  auto pool = context_pool<tcp_echo_service>(THREADS);
+  ASSERT_EQ(pool.size(), THREADS);
+
+  // Every service binds the same address, which only succeeds if they all
+  // set SO_REUSEPORT.
+  pool.start(addr_v4);
+  ASSERT_TRUE(pool.started());
+  for (std::size_t i = 0; i < pool.size(); ++i)
+    EXPECT_TRUE(pool[i].reuse_port);
+
+  EXPECT_THROW(pool.start(addr_v4), std::invalid_argument);
+
+  auto socks = std::vector<socket_handle>();
+  socks.reserve(4 * THREADS);
+  for (int i = 0; i < 4 * THREADS; ++i)
+  {
+    auto &sock = socks.emplace_back(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(sock, addr_v4), 0);
+  }
+
+  auto buf = std::array<char, 1>{};
+  auto msg = socket_message{.buffers = buf};
+  for (auto &sock : socks)
+  {
+    const char *byte = "x";
+    auto msg_ = socket_message<sockaddr_in>{.buffers = std::span(byte, 1)};
+    ASSERT_EQ(sendmsg(sock, msg_, 0), 1);
+    ASSERT_EQ(recvmsg(sock, msg, 0), 1);
+    EXPECT_EQ(buf[0], 'x');
+  }
+
+  pool.stop();
+  for (std::size_t i = 0; i < pool.size(); ++i)
+    EXPECT_EQ(pool[i].state, STOPPED);
+}
+
+TEST_F(AsyncUDPServiceTest, ContextPoolUdp)
+{
+  using namespace io;
+  using namespace io::socket;
+  using enum async_context::context_states;
+
+  constexpr auto THREADS = 4;
+  auto pool = context_pool<udp_echo_service>(THREADS);
+  pool.start(addr_v4);
+  ASSERT_TRUE(pool.started());
+
+  // Datagrams from different source ports are hashed to different sockets.
+  for (int i = 0; i < 4 * THREADS; ++i)
+  {
+    auto sock = socket_handle(AF_INET, SOCK_DGRAM, 0);
+    auto buf = std::array<char, 1>{};
+    auto msg = socket_message{.buffers = buf};
+    auto len = sendmsg(sock,
+                       socket_message<sockaddr_in>{
+                           .address = {addr_v4}, .buffers = std::span("x", 1)},
+                       0);
+    ASSERT_EQ(len, 1);
+    ASSERT_EQ(recvmsg(sock, msg, 0), 1);
+    EXPECT_EQ(buf[0], 'x');
+  }
+
+  pool.signal(pool[0].terminate);
+  pool.stop();
+  EXPECT_FALSE(pool.started());
+}
+
+TEST_F(AsyncUDPServiceTest, ContextPoolPinned)
+{
+  using enum async_context::context_states;
+  using pool_type = context_pool<udp_echo_service>;
+
+  constexpr auto THREADS = 2;
+  const auto cpus = allowed_cpus();
+  ASSERT_FALSE(cpus.empty());
+
+  auto options = pool_type::pinned(THREADS);
+  ASSERT_EQ(options.size(), THREADS);
+  for (std::size_t i = 0; i < options.size(); ++i)
+    EXPECT_EQ(options[i].cpus, std::vector<int>{cpus[i % cpus.size()]});
+
+  auto pool = pool_type(std::move(options));
+  pool.start(addr_v4);
+  ASSERT_TRUE(pool.started());
+  for (std::size_t i = 0; i < pool.size(); ++i)
+  {
+    EXPECT_EQ(pool[i].affinity(), pool[i].options().cpus);
+    EXPECT_NE(pool[i].thread_id(), std::this_thread::get_id());
+  }
+
+  pool.stop();
+  EXPECT_FALSE(pool.started());
+}
+// NOLINTEND
@@ -0,0 +1,272 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// NOLINTBEGIN
+#include "net/execution/epoll_multiplexer.hpp"
+#include "net/service/async_tcp_service.hpp"
+#include "net/service/async_udp_service.hpp"
+#include "net/service/context_thread.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace net::service;
+using net::execution::epoll_multiplexer;
+
+struct epoll_tcp_echo_service
+    : public async_tcp_service<epoll_tcp_echo_service, 1024UL,
+                               epoll_multiplexer> {
+  using Base =
+      async_tcp_service<epoll_tcp_echo_service, 1024UL, epoll_multiplexer>;
+  using socket_message = io::socket::socket_message<>;
+
+  template <typename T>
+  explicit epoll_tcp_echo_service(socket_address<T> address) : Base(address)
+  {}
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {
+    using namespace stdexec;
+    if (!rctx)
+      return;
+
+    sender auto sendmsg =
+        io::sendmsg(socket, socket_message{.buffers = buf}, 0) |
+        then([&, socket, rctx](auto &&) { submit_recv(ctx, socket, rctx); }) |
+        upon_error([](auto &&) {});
+
+    ctx.scope.spawn(std::move(sendmsg));
+  }
+};
+
+struct epoll_udp_echo_service
+    : public async_udp_service<epoll_udp_echo_service, 1024UL,
+                               epoll_multiplexer> {
+  using Base =
+      async_udp_service<epoll_udp_echo_service, 1024UL, epoll_multiplexer>;
+  using socket_message = io::socket::socket_message<>;
+
+  template <typename T>
+  explicit epoll_udp_echo_service(socket_address<T> address) : Base(address)
+  {}
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {
+    using namespace stdexec;
+    if (!rctx)
+      return;
+
+    auto address = *rctx->msg.address;
+    if (address->sin6_family == AF_INET)
+    {
+      const auto *ptr =
+          reinterpret_cast<struct sockaddr *>(std::addressof(*address));
+      address = socket_address<sockaddr_in>(ptr);
+    }
+
+    sender auto sendmsg =
+        io::sendmsg(socket, socket_message{.address = address, .buffers = buf},
+                    0) |
+        then([&, socket, rctx](auto &&) { submit_recv(ctx, socket, rctx); }) |
+        upon_error([](auto &&) {});
+
+    ctx.scope.spawn(std::move(sendmsg));
+  }
+};
+
+class EpollMultiplexerTest : public ::testing::Test {
+protected:
+  template <typename T> using socket_address = io::socket::socket_address<T>;
+
+  auto SetUp() -> void override
+  {
+    constexpr auto PORT_MIN = 8000UL;
+    unsigned short port = PORT_MIN + std::rand() % (UINT16_MAX - PORT_MIN + 1);
+
+    addr_v4->sin_family = AF_INET;
+    addr_v4->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr_v4->sin_port = htons(port);
+  }
+
+  socket_address<sockaddr_in> addr_v4;
+};
+
+TEST_F(EpollMultiplexerTest, ContextType)
+{
+  using tcp_context = context_thread<epoll_tcp_echo_service>::context_type;
+  using udp_context = context_thread<epoll_udp_echo_service>::context_type;
+
+  EXPECT_TRUE((std::is_same_v<tcp_context::multiplexer_type,
+                              epoll_multiplexer>));
+  EXPECT_TRUE((std::is_same_v<udp_context::multiplexer_type,
+                              epoll_multiplexer>));
+}
+
+TEST_F(EpollMultiplexerTest, WaitForTimeout)
+{
+  auto mux = epoll_multiplexer();
+  EXPECT_EQ(mux.wait_for(0), 0);
+}
+
+TEST_F(EpollMultiplexerTest, ErrorsIgnoreReadableData)
+{
+  using namespace io::socket;
+  using namespace stdexec;
+
+  EXPECT_TRUE(net::execution::ErrorMultiplexer<epoll_multiplexer>);
+  EXPECT_FALSE(
+      net::execution::ErrorMultiplexer<io::execution::poll_multiplexer>);
+
+  auto fds = std::array<int, 2>{};
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()), 0);
+  auto socket = std::make_shared<socket_handle>(fds[0]);
+  ASSERT_EQ(::write(fds[1], "x", 1), 1);
+
+  auto mux = epoll_multiplexer();
+  auto woken = 0;
+  auto scope = exec::async_scope();
+  auto wait = mux.set(socket, epoll_multiplexer::ERRORS, [&]() -> int {
+    ++woken;
+    return 0;
+  });
+  scope.spawn(std::move(wait) | then([](int) {}) | upon_error([](int) {}));
+
+  // Unread data doesn't wake an error-only wait.
+  for (int i = 0; i < 5; ++i)
+    mux.wait_for(10);
+  EXPECT_EQ(woken, 0);
+
+  // A hangup does.
+  ::close(fds[1]);
+  while (!woken)
+    ASSERT_GT(mux.wait_for(1000), 0);
+  EXPECT_EQ(woken, 1);
+
+  sync_wait(scope.on_empty());
+}
+
+TEST_F(EpollMultiplexerTest, CancelledWaitOnReusedFd)
+{
+  using namespace io::socket;
+  using namespace stdexec;
+  using enum io::execution::execution_trigger;
+
+  auto mux = epoll_multiplexer();
+  auto fds = std::array<int, 2>{};
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()), 0);
+  const auto fd = fds[0];
+  {
+    auto socket = std::make_shared<socket_handle>(fds[0]);
+    auto scope = exec::async_scope();
+    scope.spawn(mux.set(socket, READ, [] { return 0; }) | then([](int) {}) |
+                upon_error([](int) {}));
+    EXPECT_EQ(mux.wait_for(0), 0);
+
+    scope.request_stop();
+    sync_wait(scope.on_empty());
+  }
+  ::close(fds[1]);
+
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()), 0);
+  if (fds[0] != fd)
+  {
+    ::close(fds[0]);
+    ::close(fds[1]);
+    GTEST_SKIP() << "The descriptor number wasn't reused.";
+  }
+
+  // The new socket is registered even though the cancelled wait had armed
+  // the same descriptor number.
+  auto socket = std::make_shared<socket_handle>(fds[0]);
+  auto woken = false;
+  auto scope = exec::async_scope();
+  auto wait = mux.set(socket, READ, [&] {
+    woken = true;
+    return 0;
+  });
+  scope.spawn(std::move(wait) | then([](int) {}) | upon_error([](int) {}));
+  ASSERT_EQ(::write(fds[1], "x", 1), 1);
+
+  while (!woken)
+    ASSERT_GT(mux.wait_for(1000), 0);
+
+  sync_wait(scope.on_empty());
+  ::close(fds[1]);
+}
+
+TEST_F(EpollMultiplexerTest, TcpEcho)
+{
+  using namespace io;
+  using namespace io::socket;
+  using enum async_context::context_states;
+
+  auto server = context_thread<epoll_tcp_echo_service>();
+  server.start(addr_v4);
+  server.state.wait(PENDING);
+  ASSERT_EQ(server.state, STARTED);
+
+  auto sock = socket_handle(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(sock, addr_v4), 0);
+
+  auto buf = std::array<char, 1>{'x'};
+  auto msg = socket_message{.buffers = buf};
+
+  const char *alphabet = "abcdefghijklmnopqrstuvwxyz";
+  for (const auto *it = alphabet; it != alphabet + 26; ++it)
+  {
+    auto msg_ = socket_message<sockaddr_in>{.buffers = std::span(it, 1)};
+    ASSERT_EQ(sendmsg(sock, msg_, 0), 1);
+    ASSERT_EQ(recvmsg(sock, msg, 0), 1);
+    EXPECT_EQ(buf[0], *it);
+  }
+}
+
+TEST_F(EpollMultiplexerTest, UdpEcho)
+{
+  using namespace io;
+  using namespace io::socket;
+  using enum async_context::context_states;
+
+  auto server = context_thread<epoll_udp_echo_service>();
+  server.start(addr_v4);
+  server.state.wait(PENDING);
+  ASSERT_EQ(server.state, STARTED);
+
+  auto sock = socket_handle(AF_INET, SOCK_DGRAM, 0);
+  auto buf = std::array<char, 1>{'x'};
+  auto msg = socket_message{.buffers = buf};
+
+  const char *alphabet = "abcdefghijklmnopqrstuvwxyz";
+  for (const auto *it = alphabet; it != alphabet + 26; ++it)
+  {
+    auto len = sendmsg(sock,
+                       socket_message<sockaddr_in>{
+                           .address = {addr_v4}, .buffers = std::span(it, 1)},
+                       0);
+    ASSERT_EQ(len, 1);
+    ASSERT_EQ(recvmsg(sock, msg, 0), 1);
+    EXPECT_EQ(buf[0], *it);
+  }
+}
+// NOLINTEND
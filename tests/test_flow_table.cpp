@@ -0,0 +1,163 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// NOLINTBEGIN
+#include "net/service/async_context.hpp"
+#include "net/service/flow_table.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include <arpa/inet.h>
+
+using namespace net::service;
+
+class FlowTableTest : public ::testing::Test {
+protected:
+  using table_type = flow_table<int>;
+  using socket_address = table_type::socket_address;
+
+  // An IPv6 loopback peer on the given port.
+  static auto peer(std::uint16_t port) -> socket_address
+  {
+    auto address = socket_address();
+    address->sin6_family = AF_INET6;
+    address->sin6_addr = in6addr_loopback;
+    address->sin6_port = htons(port);
+    return address;
+  }
+};
+
+TEST_F(FlowTableTest, InsertFindErase)
+{
+  auto table = table_type({.capacity = 64});
+
+  for (std::uint16_t port = 1; port <= 64; ++port)
+  {
+    auto [state, inserted] = table.try_emplace(peer(port));
+    ASSERT_TRUE(inserted);
+    *state = port;
+  }
+  EXPECT_EQ(table.size(), 64);
+
+  // Erasing shifts probe sequences back, and every flow stays reachable.
+  for (std::uint16_t port = 1; port <= 64; port += 2)
+    EXPECT_TRUE(table.erase(peer(port)));
+  EXPECT_FALSE(table.erase(peer(1)));
+
+  for (std::uint16_t port = 1; port <= 64; ++port)
+  {
+    auto *state = table.find(peer(port));
+    if (port % 2 != 0)
+    {
+      EXPECT_EQ(state, nullptr);
+      continue;
+    }
+    ASSERT_NE(state, nullptr);
+    EXPECT_EQ(*state, port);
+  }
+
+  auto [state, inserted] = table.try_emplace(peer(2));
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(*state, 2);
+  EXPECT_EQ(table.size(), 32);
+
+  table.clear();
+  EXPECT_EQ(table.size(), 0);
+  EXPECT_EQ(table.find(peer(2)), nullptr);
+}
+
+TEST_F(FlowTableTest, MappedAddresses)
+{
+  auto table = table_type();
+
+  auto v4 = io::socket::socket_address<sockaddr_in>();
+  v4->sin_family = AF_INET;
+  v4->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  v4->sin_port = htons(8080);
+  *table.try_emplace(socket_address(v4)).first = 1;
+
+  // A dual-stack socket sees the same peer as ::ffff:127.0.0.1.
+  auto mapped = peer(8080);
+  ASSERT_EQ(inet_pton(AF_INET6, "::ffff:127.0.0.1", &mapped->sin6_addr), 1);
+  auto *state = table.find(mapped);
+  ASSERT_NE(state, nullptr);
+  EXPECT_EQ(*state, 1);
+}
+
+TEST_F(FlowTableTest, EvictsWhenFull)
+{
+  constexpr auto CAPACITY = 16;
+  auto table = table_type({.capacity = CAPACITY});
+
+  for (std::uint16_t port = 1; port <= 2 * CAPACITY; ++port)
+    ASSERT_TRUE(table.try_emplace(peer(port)).second);
+
+  auto stats = table.stats();
+  EXPECT_EQ(stats.flows, CAPACITY);
+  EXPECT_EQ(stats.inserted, 2 * CAPACITY);
+  EXPECT_EQ(stats.evicted, CAPACITY);
+
+  // The newest flow is never the one evicted.
+  EXPECT_NE(table.find(peer(2 * CAPACITY)), nullptr);
+}
+
+TEST_F(FlowTableTest, ExpiresIdleFlows)
+{
+  auto table = table_type({.capacity = 64});
+  table.try_emplace(peer(1));
+  table.try_emplace(peer(2));
+
+  // A flow that is used every tick never expires.
+  for (std::size_t i = 0; i < 2 * table_type::SWEEP_SLICES + 1; ++i)
+  {
+    ASSERT_NE(table.find(peer(1)), nullptr);
+    table.tick();
+  }
+
+  EXPECT_NE(table.find(peer(1)), nullptr);
+  EXPECT_EQ(table.find(peer(2)), nullptr);
+  EXPECT_EQ(table.stats().expired, 1);
+}
+
+TEST_F(FlowTableTest, ContextTimers)
+{
+  using namespace std::chrono;
+
+  auto ctx = async_context();
+  ASSERT_EQ(ctx.timers.open(), 0);
+
+  auto table = std::make_shared<table_type>(
+      table_type::options_type{.idle = milliseconds(40)});
+  table->start(ctx);
+  table->try_emplace(peer(1));
+
+  const auto start = steady_clock::now();
+  while (table->size() > 0 && steady_clock::now() - start < seconds(2))
+  {
+    ctx.poller.wait_for(5);
+    ctx.timers.resolve();
+  }
+  EXPECT_EQ(table->size(), 0);
+  EXPECT_GE(steady_clock::now() - start, milliseconds(40));
+
+  table->stop(ctx);
+  ctx.timers.close();
+}
+// NOLINTEND
@@ -29,6 +29,8 @@ int socketpair(int domain, int type, int __protocol, int __fds[2])
   return -1;
 }
 
+int eventfd(unsigned int __count, int __flags) { return -1; }
+
 class AsyncServiceTest : public ::testing::Test {};
 
 std::mutex test_mtx;
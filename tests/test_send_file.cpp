@@ -0,0 +1,191 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// NOLINTBEGIN
+#include "net/service/async_context.hpp"
+#include "net/service/send_file.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace net::service;
+
+class SendFileTest : public ::testing::Test {
+protected:
+  using socket_dialog = async_context::socket_dialog;
+
+  auto SetUp() -> void override
+  {
+    int fds[2] = {};
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_EQ(::fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+
+    // A small send buffer forces the transfer to wait for the socket.
+    auto size = 4096;
+    ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+    socket = ctx.poller.emplace(fds[0]);
+    peer = fds[1];
+
+    data.resize(256 * 1024UL);
+    for (std::size_t i = 0; i < data.size(); ++i)
+      data[i] = static_cast<char>(i % 251);
+
+    file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(std::fwrite(data.data(), 1, data.size(), file), data.size());
+    ASSERT_EQ(std::fflush(file), 0);
+  }
+
+  // Runs the event loop until the transfer completes, and collects
+  // everything the peer receives.
+  auto run() -> std::vector<char>
+  {
+    auto received = std::vector<char>();
+    auto buf = std::array<char, 16 * 1024>{};
+    while (!done)
+    {
+      ctx.poller.wait_for(100);
+      while (true)
+      {
+        auto len = ::recv(peer, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0)
+          break;
+        received.insert(received.end(), buf.data(), buf.data() + len);
+      }
+    }
+    return received;
+  }
+
+  auto TearDown() -> void override
+  {
+    std::fclose(file);
+    ::close(peer);
+  }
+
+  async_context ctx;
+  socket_dialog socket;
+  int peer = -1;
+  std::FILE *file = nullptr;
+  std::vector<char> data;
+  bool done = false;
+  std::size_t sent = 0;
+};
+
+TEST_F(SendFileTest, SendFile)
+{
+  using namespace stdexec;
+
+  auto calls = 0UL;
+  auto last = std::size_t{0};
+  auto progress = [&](std::size_t len, std::size_t count) {
+    EXPECT_GT(len, last);
+    EXPECT_EQ(count, data.size());
+    last = len;
+    ++calls;
+  };
+
+  ctx.scope.spawn(send_file(socket, ::fileno(file), 0, data.size(),
+                            progress) |
+                  then([&](std::size_t len) {
+                    sent = len;
+                    done = true;
+                  }) |
+                  upon_error([&](int) { done = true; }));
+
+  auto received = run();
+  EXPECT_EQ(sent, data.size());
+  EXPECT_EQ(last, data.size());
+  EXPECT_GT(calls, 1);
+  EXPECT_EQ(received, data);
+}
+
+TEST_F(SendFileTest, PartialTransfer)
+{
+  using namespace stdexec;
+
+  // The file ends before the requested count.
+  constexpr auto OFFSET = 1000;
+  ctx.scope.spawn(send_file(socket, ::fileno(file), OFFSET, 2 * data.size()) |
+                  then([&](std::size_t len) {
+                    sent = len;
+                    done = true;
+                  }) |
+                  upon_error([&](int) { done = true; }));
+
+  auto received = run();
+  EXPECT_EQ(sent, data.size() - OFFSET);
+  EXPECT_TRUE(std::equal(received.begin(), received.end(),
+                         data.begin() + OFFSET, data.end()));
+}
+
+TEST_F(SendFileTest, SpliceFromPipe)
+{
+  using namespace stdexec;
+
+  constexpr auto CHUNK = 4096;
+  int pipefd[2] = {};
+  ASSERT_EQ(::pipe(pipefd), 0);
+  ASSERT_EQ(::write(pipefd[1], data.data(), CHUNK), CHUNK);
+
+  ctx.scope.spawn(send_file(socket, pipefd[0], 0, data.size()) |
+                  then([&](std::size_t len) {
+                    sent = len;
+                    done = true;
+                  }) |
+                  upon_error([&](int) { done = true; }));
+
+  // A drained pipe is waited for while its writer is open.
+  for (int i = 0; i < 5; ++i)
+    ctx.poller.wait_for(10);
+  EXPECT_FALSE(done);
+
+  // The transfer ends once the writer closes the pipe.
+  ASSERT_EQ(::write(pipefd[1], data.data() + CHUNK, CHUNK), CHUNK);
+  ::close(pipefd[1]);
+
+  auto received = run();
+  EXPECT_EQ(sent, 2 * CHUNK);
+  EXPECT_EQ(received.size(), 2 * CHUNK);
+  EXPECT_TRUE(std::equal(received.begin(), received.end(), data.begin()));
+
+  ::close(pipefd[0]);
+}
+
+TEST_F(SendFileTest, BadFileDescriptor)
+{
+  using namespace stdexec;
+
+  auto error = 0;
+  ctx.scope.spawn(send_file(socket, -1, 0, data.size()) |
+                  then([&](std::size_t len) { done = true; }) |
+                  upon_error([&](int err) {
+                    error = err;
+                    done = true;
+                  }));
+
+  run();
+  EXPECT_EQ(error, EBADF);
+}
+// NOLINTEND
@@ -0,0 +1,130 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// NOLINTBEGIN
+#include "net/detail/buffer_pool.hpp"
+#include "net/detail/slab_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace net::detail;
+
+class SlabPoolTest : public ::testing::Test {};
+
+TEST_F(SlabPoolTest, RecyclesBlocks)
+{
+  constexpr std::size_t SLAB_SIZE = 4;
+  auto pool = slab_pool(SLAB_SIZE);
+  EXPECT_EQ(pool.block_size(), 0);
+  EXPECT_EQ(pool.stats().capacity, 0);
+
+  auto blocks = std::vector<void *>();
+  for (std::size_t i = 0; i < SLAB_SIZE + 1; ++i)
+    blocks.push_back(pool.allocate(100, alignof(std::max_align_t)));
+
+  EXPECT_EQ(pool.block_size() % alignof(std::max_align_t), 0);
+  EXPECT_EQ(std::set(blocks.begin(), blocks.end()).size(), blocks.size());
+  for (auto *block : blocks)
+  {
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(block) %
+                  alignof(std::max_align_t),
+              0);
+  }
+
+  auto stats = pool.stats();
+  EXPECT_EQ(stats.slabs, 2);
+  EXPECT_EQ(stats.capacity, 2 * SLAB_SIZE);
+  EXPECT_EQ(stats.in_use, SLAB_SIZE + 1);
+  EXPECT_EQ(stats.peak, SLAB_SIZE + 1);
+
+  for (auto *block : blocks)
+    pool.deallocate(block);
+  EXPECT_EQ(pool.stats().in_use, 0);
+
+  // Freed blocks are reused before the pool grows again.
+  for (std::size_t i = 0; i < 2 * SLAB_SIZE; ++i)
+    blocks.push_back(pool.allocate(100, alignof(std::max_align_t)));
+
+  stats = pool.stats();
+  EXPECT_EQ(stats.slabs, 2);
+  EXPECT_EQ(stats.in_use, 2 * SLAB_SIZE);
+  EXPECT_EQ(stats.peak, 2 * SLAB_SIZE);
+
+  EXPECT_THROW((void)pool.allocate(pool.block_size() + 1, 1), std::bad_alloc);
+}
+
+TEST_F(SlabPoolTest, AllocateShared)
+{
+  struct object {
+    std::array<std::byte, 1024> data;
+  };
+
+  auto pool = std::make_shared<slab_pool>();
+  auto alloc = slab_allocator<object>(pool);
+  auto first = std::allocate_shared<object>(alloc);
+  auto *address = first.get();
+  EXPECT_EQ(pool->stats().in_use, 1);
+
+  first.reset();
+  EXPECT_EQ(pool->stats().in_use, 0);
+
+  auto second = std::allocate_shared<object>(alloc);
+  EXPECT_EQ(second.get(), address);
+  EXPECT_EQ(pool->stats().slabs, 1);
+
+  // Objects keep their pool alive.
+  auto weak = std::weak_ptr(pool);
+  pool.reset();
+  alloc = slab_allocator<object>(std::make_shared<slab_pool>());
+  EXPECT_FALSE(weak.expired());
+  second.reset();
+  EXPECT_TRUE(weak.expired());
+}
+
+TEST_F(SlabPoolTest, BufferPoolClasses)
+{
+  auto pool = buffer_pool(512, 1000);
+  EXPECT_EQ(pool.min_size(), 512);
+  EXPECT_EQ(pool.max_size(), 1000);
+
+  auto small = pool.acquire(1);
+  EXPECT_EQ(small.size(), 512);
+  auto large = pool.acquire(513);
+  EXPECT_EQ(large.size(), 1000);
+  auto huge = pool.acquire(1 << 20);
+  EXPECT_EQ(huge.size(), 1000);
+
+  auto stats = pool.stats();
+  EXPECT_EQ(stats.in_use, 3);
+  EXPECT_EQ(stats.bytes_in_use, 2512);
+  EXPECT_GE(stats.bytes_reserved, stats.bytes_in_use);
+
+  pool.release(small);
+  pool.release(large);
+  pool.release(huge);
+  EXPECT_EQ(pool.stats().in_use, 0);
+  EXPECT_EQ(pool.stats().bytes_reserved, stats.bytes_reserved);
+
+  // Released buffers are handed out again.
+  EXPECT_EQ(pool.acquire(512).data(), small.data());
+}
+// NOLINTEND
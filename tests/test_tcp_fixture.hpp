@@ -100,10 +100,9 @@ protected:
     service_v6 = std::make_unique<tcp_echo_service>(addr_v6);
     server_v6 = std::make_unique<server_type>();
 
-    int err = ::socketpair(AF_UNIX, SOCK_STREAM, 0, ctx->timers.sockets.data());
-    ASSERT_EQ(err, 0);
+    ASSERT_EQ(ctx->timers.open(), 0);
 
-    isr(ctx->poller.emplace(ctx->timers.sockets[0]), [&] {
+    isr(ctx->poller.emplace(ctx->timers.listener()), [&] {
       auto sigmask = ctx->sigmask.exchange(0);
       for (int signum = 0; auto mask = (sigmask >> signum); ++signum)
       {
@@ -131,28 +130,13 @@ protected:
     requires std::is_invocable_r_v<bool, Fn>
   auto isr(const socket_dialog &socket, Fn &&handler) -> void
   {
-    using namespace stdexec;
-    using namespace io::socket;
-    static auto buf = std::array<std::byte, 1024>();
-    static auto msg = socket_message{.buffers = buf};
+    ctx->isr(socket, [this, handler] {
+      if (handler())
+        return true;
 
-    if (!handler())
-    {
       ctx->scope.request_stop();
-      return;
-    }
-
-    sender auto recvmsg =
-        io::recvmsg(socket, msg, 0) |
-        then([this, socket, handler](auto len) { isr(socket, handler); }) |
-        upon_error([](auto &&error) {
-          if constexpr (std::is_same_v<std::decay_t<decltype(error)>, int>)
-          {
-            auto msg = std::error_code(error, std::system_category()).message();
-          }
-        });
-
-    ctx->scope.spawn(std::move(recvmsg));
+      return false;
+    });
   }
 
   std::unique_ptr<async_context> ctx;
@@ -170,13 +154,12 @@ protected:
 
   auto TearDown() -> void override
   {
-    if (ctx->timers.sockets[1] != io::socket::INVALID_SOCKET)
-      io::socket::close(ctx->timers.sockets[1]);
     if (!is_empty)
     {
       ctx->signal(ctx->terminate);
       ctx->poller.wait();
     }
+    ctx->timers.close();
     service_v4.reset();
     service_v6.reset();
     ctx.reset();
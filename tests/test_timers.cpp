@@ -20,6 +20,8 @@
 
 #include <gtest/gtest.h>
 
+#include <fcntl.h>
+
 using namespace net::timers;
 
 using interrupt_source = socketpair_interrupt_source_t;
@@ -48,6 +50,46 @@ TEST(TimersTests, Swap)
   swap(timers1, timers1);
 }
 
+TEST(TimersTests, SocketpairInterruptSource)
+{
+  auto source = socketpair_interrupt_source_t{};
+  ASSERT_EQ(source.open(), 0);
+
+  source.interrupt();
+  EXPECT_EQ(socketpair_interrupt_source_t::drain(source.listener()), 1);
+
+  source.close();
+  EXPECT_EQ(source.sockets[1], source.INVALID_SOCKET);
+  EXPECT_EQ(socketpair_interrupt_source_t::drain(source.listener()), 0);
+  ::close(source.listener());
+}
+
+TEST(TimersTests, EventfdInterruptSource)
+{
+  auto source = eventfd_interrupt_source_t{};
+  ASSERT_EQ(source.open(), 0);
+  const auto fd = source.listener();
+
+  // Repeated interrupts are coalesced into a single read.
+  source.interrupt();
+  source.interrupt();
+  source.interrupt();
+  EXPECT_EQ(eventfd_interrupt_source_t::drain(fd), 3);
+  EXPECT_EQ(eventfd_interrupt_source_t::drain(fd), -1);
+  EXPECT_EQ(errno, EAGAIN);
+
+  // Interrupts are dropped once the source is closed, and the descriptor
+  // that they were written to is closed with it.
+  const auto writer = source.fd.load();
+  EXPECT_NE(writer, fd);
+  source.close();
+  EXPECT_EQ(source.fd, source.INVALID_SOCKET);
+  EXPECT_EQ(::fcntl(writer, F_GETFD), -1);
+  source.interrupt();
+  EXPECT_EQ(eventfd_interrupt_source_t::drain(fd), -1);
+  ::close(fd);
+}
+
 TEST(TimersTests, EventRefEquality)
 {
   using event_ref = detail::event_ref;
@@ -94,4 +136,60 @@ TEST(TimersTests, PeriodicTimer)
   auto next = timers.resolve();
   EXPECT_NE(next.count(), -1);
 }
+
+struct counting_interrupt_source {
+  mutable int count = 0;
+  auto interrupt() const noexcept -> void { ++count; }
+};
+
+TEST(TimersTests, InterruptCoalescing)
+{
+  using namespace std::chrono;
+
+  auto timers = net::timers::timers<counting_interrupt_source>();
+  timers.add(seconds(10), [](timer_id) {});
+  EXPECT_EQ(timers.count, 1);
+
+  // A timer that expires after the earliest timer doesn't interrupt.
+  timers.add(seconds(20), [](timer_id) {});
+  EXPECT_EQ(timers.count, 1);
+
+  timers.add(seconds(5), [](timer_id) {});
+  EXPECT_EQ(timers.count, 2);
+
+  // Timers added on the event loop thread never interrupt.
+  timers.resolve();
+  timers.add(seconds(1), [](timer_id) {});
+  EXPECT_EQ(timers.count, 2);
+
+  std::thread([&] { timers.add(milliseconds(1), [](timer_id) {}); }).join();
+  EXPECT_EQ(timers.count, 3);
+}
+
+TEST(TimersTests, AddMany)
+{
+  using namespace std::chrono;
+
+  auto timers = net::timers::timers<counting_interrupt_source>();
+  timers.add_many({});
+  EXPECT_EQ(timers.count, 0);
+
+  auto fired = 0;
+  auto now = clock::now();
+  auto specs = std::array<timer_spec, 3>{{
+      {.when = now + seconds(10), .handler = [&](timer_id) { ++fired; }},
+      {.when = now, .handler = [&](timer_id) { ++fired; }},
+      {.when = now + seconds(20), .handler = [&](timer_id) { ++fired; }},
+  }};
+
+  timers.add_many(specs);
+  EXPECT_EQ(specs[0].id, 0);
+  EXPECT_EQ(specs[1].id, 1);
+  EXPECT_EQ(specs[2].id, 2);
+  EXPECT_EQ(timers.count, 1);
+
+  auto next = timers.resolve();
+  EXPECT_EQ(fired, 1);
+  EXPECT_GT(next.count(), 0);
+}
 // NOLINTEND
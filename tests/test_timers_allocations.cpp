@@ -0,0 +1,131 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// NOLINTBEGIN
+#include "net/timers/timers.hpp"
+#include "net/timers/timing_wheel.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+static std::atomic<std::size_t> allocations{0};
+
+void *operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+using namespace net::timers;
+
+struct null_interrupt_source {
+  auto interrupt() const noexcept -> void {}
+};
+
+template <typename Timers> class TimersAllocationTest : public ::testing::Test {
+protected:
+  static constexpr std::size_t TIMERS = 64;
+
+  // One round of arming, cancelling and resolving timers, with handlers
+  // that are larger than the small buffer of a std::function.
+  auto round(Timers &timers) -> void
+  {
+    auto payload = std::array<std::byte, 48>{};
+    auto tids = std::array<timer_id, TIMERS>{};
+    auto now = clock::now();
+    for (auto &tid : tids)
+    {
+      tid = timers.add(now,
+                       [this, payload](timer_id) { fired += payload.size(); });
+    }
+
+    for (std::size_t i = 0; i < TIMERS; i += 2)
+      timers.remove(tids[i]);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    timers.resolve();
+  }
+
+  // The same round, with the timers armed in one batch.
+  auto batch_round(Timers &timers) -> void
+  {
+    auto payload = std::array<std::byte, 48>{};
+    std::array<timer_spec, TIMERS> specs;
+    auto now = clock::now();
+    for (auto &spec : specs)
+    {
+      spec.when = now;
+      spec.handler = [this, payload](timer_id) { fired += payload.size(); };
+    }
+    timers.add_many(specs);
+
+    for (std::size_t i = 0; i < TIMERS; i += 2)
+      timers.remove(specs[i].id);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    timers.resolve();
+  }
+
+  std::size_t fired = 0;
+};
+
+using engines = ::testing::Types<timers<null_interrupt_source>,
+                                 timing_wheel<null_interrupt_source>>;
+TYPED_TEST_SUITE(TimersAllocationTest, engines);
+
+TYPED_TEST(TimersAllocationTest, SteadyStateDoesNotAllocate)
+{
+  using namespace std::chrono;
+
+  auto timers = TypeParam();
+  auto periodic = timers.add(
+      milliseconds(1), [this](timer_id) { ++this->fired; }, milliseconds(1));
+
+  // Warm up the internal containers.
+  for (int i = 0; i < 4; ++i)
+    this->round(timers);
+
+  const auto before = allocations.load();
+  for (int i = 0; i < 32; ++i)
+    this->round(timers);
+  EXPECT_EQ(allocations.load() - before, 0);
+
+  timers.remove(periodic);
+  EXPECT_GT(this->fired, 0);
+}
+
+TYPED_TEST(TimersAllocationTest, AddManyDoesNotAllocate)
+{
+  auto timers = TypeParam();
+  for (int i = 0; i < 4; ++i)
+    this->batch_round(timers);
+
+  const auto before = allocations.load();
+  for (int i = 0; i < 32; ++i)
+    this->batch_round(timers);
+  EXPECT_EQ(allocations.load() - before, 0);
+  EXPECT_GT(this->fired, 0);
+}
+// NOLINTEND
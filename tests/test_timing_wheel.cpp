@@ -0,0 +1,299 @@
+/* Copyright (C) 2025 Kevin Exton (kevin.exton@pm.me)
+ *
+ * cppnet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cppnet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cppnet.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// NOLINTBEGIN
+#include "net/timers/timing_wheel.hpp"
+#include "net/service/async_udp_service.hpp"
+#include "net/service/context_thread.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace net::timers;
+
+struct counting_interrupt_source {
+  mutable int count = 0;
+  auto interrupt() const noexcept -> void { ++count; }
+};
+
+using wheel_type = timing_wheel<counting_interrupt_source>;
+
+TEST(TimingWheelTests, MoveAndSwap)
+{
+  auto wheel0 = wheel_type();
+  wheel0.add(1000, [](timer_id) {});
+  auto wheel1 = wheel_type(std::move(wheel0));
+  EXPECT_EQ(wheel0.resolve().count(), -1);
+  EXPECT_NE(wheel1.resolve().count(), -1);
+
+  swap(wheel0, wheel1);
+  swap(wheel0, wheel0);
+  EXPECT_NE(wheel0.resolve().count(), -1);
+  EXPECT_EQ(wheel1.resolve().count(), -1);
+}
+
+TEST(TimingWheelTests, ResolveEmpty)
+{
+  auto wheel = wheel_type();
+  EXPECT_EQ(wheel.resolve().count(), -1);
+}
+
+TEST(TimingWheelTests, TimerFires)
+{
+  using namespace std::chrono;
+
+  auto wheel = wheel_type();
+  auto fired = timer_id{INVALID_TIMER};
+  auto timer = wheel.add(milliseconds(2), [&](timer_id tid) { fired = tid; });
+  ASSERT_EQ(timer, 0);
+
+  auto next = wheel.resolve();
+  EXPECT_EQ(fired, INVALID_TIMER);
+  EXPECT_GE(next.count(), 0);
+  EXPECT_LE(next, milliseconds(3));
+
+  std::this_thread::sleep_for(milliseconds(4));
+  EXPECT_EQ(wheel.resolve().count(), -1);
+  EXPECT_EQ(fired, timer);
+}
+
+TEST(TimingWheelTests, CascadedTimerFires)
+{
+  using namespace std::chrono;
+
+  // 300 ticks is past the end of the innermost wheel.
+  auto wheel = wheel_type();
+  auto start = clock::now();
+  auto fired = timestamp{};
+  wheel.add(milliseconds(300), [&](timer_id) { fired = clock::now(); });
+
+  while (fired == timestamp{})
+  {
+    auto next = wheel.resolve();
+    if (next.count() > 0)
+      std::this_thread::sleep_for(next);
+  }
+
+  EXPECT_GE(fired - start, milliseconds(300));
+  EXPECT_EQ(wheel.resolve().count(), -1);
+}
+
+TEST(TimingWheelTests, RemoveReleasesImmediately)
+{
+  using namespace std::chrono;
+
+  auto wheel = wheel_type();
+  auto timer0 = wheel.add(hours(1), [](timer_id) {});
+  auto timer1 = wheel.add(hours(48), [](timer_id) {});
+  ASSERT_EQ(wheel.remove(timer0), INVALID_TIMER);
+  ASSERT_EQ(wheel.remove(timer1), INVALID_TIMER);
+  EXPECT_EQ(wheel.remove(10), 10);
+
+  // Cancelled timers don't linger until their deadline, and their ids are
+  // reused straight away.
+  EXPECT_EQ(wheel.resolve().count(), -1);
+  auto timer2 = wheel.add(hours(1), [](timer_id) {});
+  EXPECT_TRUE(timer2 == timer0 || timer2 == timer1);
+}
+
+TEST(TimingWheelTests, FarFutureTimer)
+{
+  using namespace std::chrono;
+
+  // Beyond the range of the outermost wheel.
+  auto wheel = wheel_type();
+  wheel.add(hours(24 * 60), [](timer_id) {});
+  auto next = wheel.resolve();
+  EXPECT_GT(next, hours(24));
+  EXPECT_LE(next, hours(24 * 60));
+}
+
+TEST(TimingWheelTests, PeriodicTimer)
+{
+  using namespace std::chrono;
+
+  auto wheel = wheel_type();
+  auto count = 0;
+  auto timer = wheel.add(
+      milliseconds(1), [&](timer_id) { ++count; }, milliseconds(1));
+
+  while (count < 3)
+  {
+    auto next = wheel.resolve();
+    ASSERT_NE(next.count(), -1);
+    std::this_thread::sleep_for(next);
+  }
+
+  wheel.remove(timer);
+  EXPECT_EQ(wheel.resolve().count(), -1);
+}
+
+TEST(TimingWheelTests, RemoveFromHandler)
+{
+  using namespace std::chrono;
+
+  auto wheel = wheel_type();
+  auto count = 0;
+  wheel.add(
+      0,
+      [&](timer_id tid) {
+        ++count;
+        wheel.remove(tid);
+      },
+      1000);
+
+  std::this_thread::sleep_for(milliseconds(2));
+  EXPECT_EQ(wheel.resolve().count(), -1);
+  EXPECT_EQ(count, 1);
+}
+
+TEST(TimingWheelTests, InterruptCoalescing)
+{
+  using namespace std::chrono;
+
+  auto wheel = wheel_type();
+  wheel.add(seconds(10), [](timer_id) {});
+  EXPECT_EQ(wheel.count, 1);
+
+  wheel.add(seconds(20), [](timer_id) {});
+  EXPECT_EQ(wheel.count, 1);
+
+  wheel.add(seconds(5), [](timer_id) {});
+  EXPECT_EQ(wheel.count, 2);
+
+  wheel.resolve();
+  wheel.add(seconds(1), [](timer_id) {});
+  EXPECT_EQ(wheel.count, 2);
+
+  std::thread([&] { wheel.add(milliseconds(1), [](timer_id) {}); }).join();
+  EXPECT_EQ(wheel.count, 3);
+}
+
+TEST(TimingWheelTests, AddMany)
+{
+  using namespace std::chrono;
+
+  auto wheel = wheel_type();
+  auto fired = 0;
+  auto now = clock::now();
+  auto specs = std::array<timer_spec, 3>{{
+      {.when = now + seconds(10), .handler = [&](timer_id) { ++fired; }},
+      {.when = now, .handler = [&](timer_id) { ++fired; }},
+      {.when = now + seconds(20), .handler = [&](timer_id) { ++fired; }},
+  }};
+
+  wheel.add_many(specs);
+  for (const auto &spec : specs)
+    EXPECT_NE(spec.id, INVALID_TIMER);
+  EXPECT_EQ(wheel.count, 1);
+
+  std::this_thread::sleep_for(milliseconds(2));
+  auto next = wheel.resolve();
+  EXPECT_EQ(fired, 1);
+  EXPECT_GT(next.count(), 0);
+}
+using default_wheel = timing_wheel<default_interrupt_source_t>;
+
+struct wheel_udp_echo_service
+    : public net::service::async_udp_service<
+          wheel_udp_echo_service, 1024UL,
+          net::service::async_context::multiplexer_type, default_wheel> {
+  using Base = net::service::async_udp_service<
+      wheel_udp_echo_service, 1024UL,
+      net::service::async_context::multiplexer_type, default_wheel>;
+  using socket_message = io::socket::socket_message<>;
+
+  template <typename T>
+  explicit wheel_udp_echo_service(socket_address<T> address) : Base(address)
+  {}
+
+  auto service(async_context &ctx, const socket_dialog &socket,
+               std::shared_ptr<read_context> rctx,
+               std::span<const std::byte> buf) -> void
+  {
+    if (!rctx)
+      return;
+
+    // Echo the datagram back from a timer on the event loop.
+    ctx.timers.add(std::chrono::milliseconds(1),
+                   [this, &ctx, socket, rctx, buf](timer_id) {
+                     echo(ctx, socket, rctx, buf);
+                   });
+  }
+
+  auto echo(async_context &ctx, const socket_dialog &socket,
+            const std::shared_ptr<read_context> &rctx,
+            std::span<const std::byte> buf) -> void
+  {
+    using namespace stdexec;
+
+    auto address = *rctx->msg.address;
+    if (address->sin6_family == AF_INET)
+    {
+      const auto *ptr =
+          reinterpret_cast<struct sockaddr *>(std::addressof(*address));
+      address = socket_address<sockaddr_in>(ptr);
+    }
+
+    sender auto sendmsg =
+        io::sendmsg(socket, socket_message{.address = address, .buffers = buf},
+                    0) |
+        then([&, socket, rctx](auto &&) { submit_recv(ctx, socket, rctx); }) |
+        upon_error([](auto &&) {});
+    ctx.scope.spawn(std::move(sendmsg));
+  }
+};
+
+TEST(TimingWheelTests, ContextTimers)
+{
+  using namespace io;
+  using namespace io::socket;
+  using namespace net::service;
+  using enum async_context::context_states;
+  using context_type = context_thread<wheel_udp_echo_service>::context_type;
+
+  EXPECT_TRUE((std::is_same_v<context_type::timers_type, default_wheel>));
+
+  constexpr auto PORT_MIN = 8000UL;
+  unsigned short port = PORT_MIN + std::rand() % (UINT16_MAX - PORT_MIN + 1);
+  auto addr_v4 = socket_address<sockaddr_in>();
+  addr_v4->sin_family = AF_INET;
+  addr_v4->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr_v4->sin_port = htons(port);
+
+  auto server = context_thread<wheel_udp_echo_service>();
+  server.start(addr_v4);
+  server.state.wait(PENDING);
+  ASSERT_EQ(server.state, STARTED);
+
+  auto sock = socket_handle(AF_INET, SOCK_DGRAM, 0);
+  auto buf = std::array<char, 1>{'x'};
+  auto msg = socket_message{.buffers = buf};
+
+  const char *alphabet = "abcdefghijklmnopqrstuvwxyz";
+  for (const auto *it = alphabet; it != alphabet + 26; ++it)
+  {
+    auto len = sendmsg(sock,
+                       socket_message<sockaddr_in>{
+                           .address = {addr_v4}, .buffers = std::span(it, 1)},
+                       0);
+    ASSERT_EQ(len, 1);
+    ASSERT_EQ(recvmsg(sock, msg, 0), 1);
+    EXPECT_EQ(buf[0], *it);
+  }
+}
+// NOLINTEND